@@ -0,0 +1,80 @@
+/*
+ * Random access into a big rectangular<double>, with and without huge pages.
+ *
+ * Usage: bench_hugepage [MiB] [accesses]
+ *
+ * With 4KiB pages every random access is (nearly always) a TLB miss and a
+ * page walk; with 2MiB pages the TLB covers 512 times as much memory.
+ */
+
+#include "rectangular.hpp"
+#include "rectangular_alloc.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace gnb;
+
+using A = hugepage_allocator<double>;
+using HR = rectangular<double, A>;
+
+static const char* kind_name(page_kind k) {
+    switch (k) {
+        case page_kind::normal: return "normal";
+        case page_kind::transparent_huge: return "transparent huge";
+        case page_kind::huge: return "explicit huge";
+    }
+    return "?";
+}
+
+static const char* mode_name(hugepage_mode m) {
+    switch (m) {
+        case hugepage_mode::prefer_huge: return "prefer_huge";
+        case hugepage_mode::transparent_only: return "transparent_only";
+        case hugepage_mode::none: return "none";
+    }
+    return "?";
+}
+
+// xorshift64, cheap enough not to hide the memory latency
+static std::uint64_t next(std::uint64_t& s) {
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return s;
+}
+
+static void run(hugepage_mode mode, std::size_t height, std::size_t width, std::size_t accesses) {
+    std::vector<double, A> vec{A{mode}};
+    vec.resize(height * width, 1.0);
+    HR grid{height, width, vec};
+    page_info info = grid.get_allocator().info();
+
+    std::uint64_t seed = 0x9E3779B97F4A7C15ull;
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < accesses; ++i) {
+        std::uint64_t r = next(seed);
+        sum += grid.at((r >> 32) % height, (r & 0xffffffff) % width);
+    }
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-17s got %-16s pages (%7zu KiB): %6.1f ns/access (sum %g)\n",
+        mode_name(mode), kind_name(info.kind), info.page_size / 1024, ns / accesses, sum);
+}
+
+int main(int argc, char** argv) {
+    std::size_t mib = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1024;
+    std::size_t accesses = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20000000;
+
+    std::size_t width = 4096;
+    std::size_t height = mib * 1024 * 1024 / sizeof(double) / width;
+    std::printf("rectangular<double>{%zu, %zu}, %zu MiB, %zu random accesses\n", height, width, mib, accesses);
+
+    run(hugepage_mode::none, height, width, accesses);
+    run(hugepage_mode::transparent_only, height, width, accesses);
+    run(hugepage_mode::prefer_huge, height, width, accesses);
+}
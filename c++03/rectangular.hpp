@@ -14,6 +14,7 @@
  * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
  */
 
+#include <algorithm>
 #include <stdexcept>
 #include <utility>
 #include <vector>
@@ -44,6 +45,7 @@ class rectangular {
         typedef typename BaseType::const_pointer const_pointer;
         typedef typename BaseType::size_type size_type;
         typedef typename BaseType::difference_type difference_type;
+        typedef typename BaseType::allocator_type allocator_type;
 
         rectangular() : m_height(0), m_width(0), m_data() {}
         explicit rectangular(size_type height, size_type width, value_type value = value_type()) : 
@@ -62,7 +64,7 @@ class rectangular {
         
         // Efficiently move a std:vector<> into a rectangular
         // NB: will erase the argument!
-        rectangular(size_type height, size_type width, std::vector<value_type>& vec) :
+        rectangular(size_type height, size_type width, std::vector<value_type, Allocator>& vec) :
             m_height(height), m_width(width),
             m_data() {
                 if (vec.size() != height * width) throw std::out_of_range("rectangular vector<> create");
@@ -83,6 +85,8 @@ class rectangular {
 
         size_type height() const { return m_height; }
         size_type width() const { return m_width; }
+
+        allocator_type get_allocator() const { return m_data.get_allocator(); }
         
         // Bounds-checked, will throw std::out_of_range() if required
         reference at(size_type y, size_type x) {
@@ -103,6 +107,10 @@ class rectangular {
         pointer operator[](size_type y) { return &m_data[y * m_width]; }
         const_pointer operator[](size_type y) const { return &m_data[y * m_width]; }
 
+        // The underlying row-major buffer, as per C++11 std::vector<>::data()
+        pointer data() { return m_data.empty() ? 0 : &m_data[0]; }
+        const_pointer data() const { return m_data.empty() ? 0 : &m_data[0]; }
+
         // Will retain existing data, erasing elements that are no longer 
         // required, and using value for any new data
         void resize(size_type new_height, size_type new_width, 
@@ -112,6 +120,57 @@ class rectangular {
                 m_width = new_width;
         }
 
+        // Reserve space for height x width elements, so growing to that
+        // size will not reallocate
+        void reserve(size_type height, size_type width) { m_data.reserve(height * width); }
+
+        // Insert n rows of value before row y, throws std::out_of_range if y > height()
+        // Inserting at height() appends, in amortized O(n * width())
+        void insert_rows(size_type y, size_type n, value_type value = value_type()) {
+            if (y > m_height) throw std::out_of_range("rectangular insert_rows");
+            m_data.insert(m_data.begin() + y * m_width, n * m_width, value);
+            m_height += n;
+        }
+
+        // Erase rows [y, y+n), throws std::out_of_range if they do not all exist
+        void erase_rows(size_type y, size_type n) {
+            if (n > m_height || y > m_height - n) throw std::out_of_range("rectangular erase_rows");
+            m_data.erase(m_data.begin() + y * m_width, m_data.begin() + (y + n) * m_width);
+            m_height -= n;
+        }
+
+        // Insert n columns of value before column x, throws std::out_of_range if x > width()
+        void insert_cols(size_type x, size_type n, value_type value = value_type()) {
+            if (x > m_width) throw std::out_of_range("rectangular insert_cols");
+            if (n == 0) return;
+            const size_type new_width = m_width + n;
+            m_data.resize(m_height * new_width, value);
+            // One pass from the end, each row moves right to its new place
+            for (size_type y = m_height; y-- > 0; ) {
+                iterator from = m_data.begin() + y * m_width, to = m_data.begin() + y * new_width;
+                std::copy_backward(from + x, from + m_width, to + new_width);
+                // Row 0 starts in place
+                if (y > 0) std::copy_backward(from, from + x, to + x);
+                std::fill(to + x, to + x + n, value);
+            }
+            m_width = new_width;
+        }
+
+        // Erase columns [x, x+n), throws std::out_of_range if they do not all exist
+        void erase_cols(size_type x, size_type n) {
+            if (n > m_width || x > m_width - n) throw std::out_of_range("rectangular erase_cols");
+            if (n == 0) return;
+            const size_type new_width = m_width - n;
+            // One pass from the start, each row moves left to its new place
+            for (size_type y = 0; y < m_height; ++y) {
+                iterator from = m_data.begin() + y * m_width, to = m_data.begin() + y * new_width;
+                if (y > 0) std::copy(from, from + x, to);
+                std::copy(from + x + n, from + m_width, to + x);
+            }
+            m_data.erase(m_data.begin() + m_height * new_width, m_data.end());
+            m_width = new_width;
+        }
+
         // Set every element to the given fallue
         void fill(const_reference value) {
             std::fill(begin(), end(), value);
@@ -127,6 +186,17 @@ class rectangular {
         BaseType m_data;
 };
 
+// Same shape and equal elements
+template <typename T, class Allocator>
+bool operator==(const rectangular<T, Allocator>& a, const rectangular<T, Allocator>& b) {
+    return a.height() == b.height() && a.width() == b.width() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename T, class Allocator>
+bool operator!=(const rectangular<T, Allocator>& a, const rectangular<T, Allocator>& b) {
+    return !(a == b);
+}
+
 /*
  * checked_rectangular IS-A rectangular
  * but r[y][x] is now range-checked and may throw std::out_of_range like r.at(y,x)
@@ -174,7 +244,7 @@ class checked_rectangular : public rectangular<T, Allocator> {
         
         // Efficiently move a std:vector<> into a rectangular
         // NB: will erase the argument!
-        checked_rectangular(size_type height, size_type width, std::vector<value_type>& vec) :
+        checked_rectangular(size_type height, size_type width, std::vector<value_type, Allocator>& vec) :
             Base(height, width, vec) {}
 
         // Default dtor/copy/assign/move OK
@@ -152,6 +152,51 @@ static int test_resize() {
     TEST_CASE_END();
 }
 
+static int test_insert_erase() {
+    TEST_CASE_BEGIN("insert and erase");
+    std::string s("123456");
+
+    R i(2, 3, s.begin(), s.end());
+
+    i.insert_rows(1, 1, 7);
+    REQUIRE(i.height() == 3);
+    REQUIRE(i[1][2] == 7);
+    REQUIRE(i[2][0] == '4');
+
+    i.insert_cols(1, 2, 9);
+    REQUIRE(i.width() == 5);
+    REQUIRE(i[0][0] == '1');
+    REQUIRE(i[0][2] == 9);
+    REQUIRE(i[0][3] == '2');
+    REQUIRE(i[2][4] == '6');
+
+    i.erase_cols(0, 3);
+    REQUIRE(i.width() == 2);
+    REQUIRE(i[2][0] == '5');
+
+    i.erase_rows(0, 2);
+    REQUIRE(i.height() == 1);
+    REQUIRE(i.size() == 2);
+    REQUIRE(i[0][1] == '6');
+
+    TEST_CASE_END();
+}
+
+static int test_equality() {
+    TEST_CASE_BEGIN("equality");
+    std::string s("123456");
+
+    R a(2, 3, s.begin(), s.end());
+    R b(2, 3, s.begin(), s.end());
+    REQUIRE(a == b);
+    b[1][2] = 7;
+    REQUIRE(a != b);
+    R c(3, 2, s.begin(), s.end());
+    REQUIRE(a != c);
+
+    TEST_CASE_END();
+}
+
 static int test_swap() {
     TEST_CASE_BEGIN("swap");
 
@@ -228,6 +273,8 @@ int main(int, char**) {
     ret += test_throws();
     ret += test_checked_throws();
     ret += test_resize();
+    ret += test_insert_erase();
+    ret += test_equality();
     ret += test_swap();
     ret += test_fill();
     ret += test_iterators();
@@ -0,0 +1,562 @@
+#ifndef GNB_compressed_rectangular
+#define GNB_compressed_rectangular
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rectangular.hpp"
+
+// Define GNB_RECTANGULAR_LZ4 to 1, and link with liblz4, to add the LZ4 codec
+#ifndef GNB_RECTANGULAR_LZ4
+#   define GNB_RECTANGULAR_LZ4 0
+#endif
+#if GNB_RECTANGULAR_LZ4
+#   include <lz4.h>
+#endif
+
+namespace gnb {
+
+/*
+ * How a tile of a compressed_rectangular is stored
+ *  - raw: as is
+ *  - rle: runs of equal values, as (length, value) pairs
+ *  - delta: differences between consecutive cells, zigzag encoded and packed
+ *    in blocks of 64 at the bit width of the largest in each block
+ *  - lz4: LZ4 of the raw bytes, if GNB_RECTANGULAR_LZ4 is set
+ *  - automatic: whichever of the above comes out smallest, tile by tile
+ */
+enum class tile_codec { automatic, raw, rle, delta, lz4 };
+
+namespace detail {
+
+template <std::size_t Bytes> struct tile_bits;
+template <> struct tile_bits<1> { using type = std::uint8_t; };
+template <> struct tile_bits<2> { using type = std::uint16_t; };
+template <> struct tile_bits<4> { using type = std::uint32_t; };
+template <> struct tile_bits<8> { using type = std::uint64_t; };
+
+inline void put_varint(std::vector<unsigned char>& out, std::size_t v) {
+    for (; v >= 0x80; v >>= 7) out.push_back(static_cast<unsigned char>(v | 0x80));
+    out.push_back(static_cast<unsigned char>(v));
+}
+
+inline std::size_t get_varint(const unsigned char*& p) {
+    std::size_t v = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        const unsigned char b = *p++;
+        v |= std::size_t(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+}
+
+// The codecs work on the bits of each T as an unsigned U, copied rather than cast
+template <typename U, typename T>
+U tile_bits_of(const T& v) {
+    static_assert(sizeof(U) == sizeof(T), "tile bits must be the size of the value");
+    U u;
+    std::memcpy(&u, &v, sizeof u);
+    return u;
+}
+
+template <typename T, typename U>
+T tile_value_of(U u) {
+    T v;
+    std::memcpy(&v, &u, sizeof v);
+    return v;
+}
+
+// Encoders append to out and give up, returning false, once it reaches limit bytes
+
+template <typename U, typename T>
+bool rle_encode(const T* cells, std::size_t n, std::vector<unsigned char>& out, std::size_t limit) {
+    for (std::size_t i = 0; i < n;) {
+        const U v = tile_bits_of<U>(cells[i]);
+        std::size_t j = i + 1;
+        while (j < n && tile_bits_of<U>(cells[j]) == v) ++j;
+        put_varint(out, j - i);
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(&v);
+        out.insert(out.end(), b, b + sizeof(U));
+        if (out.size() >= limit) return false;
+        i = j;
+    }
+    return true;
+}
+
+template <typename U, typename T>
+void rle_decode(const unsigned char* p, T* cells, std::size_t n) {
+    for (std::size_t i = 0; i < n;) {
+        const std::size_t count = get_varint(p);
+        T v;
+        std::memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        std::fill(cells + i, cells + i + count, v);
+        i += count;
+    }
+}
+
+// Packs values of up to 64 bits into whole 64-bit words
+class bit_writer {
+    public:
+        explicit bit_writer(std::vector<unsigned char>& out) : m_out(out), m_acc{0}, m_used{0} {}
+
+        void put(std::uint64_t v, unsigned bits) {
+            while (bits) {
+                const unsigned take = std::min(bits, 64 - m_used);
+                const std::uint64_t part = take == 64 ? v : v & ((std::uint64_t(1) << take) - 1);
+                m_acc |= part << m_used;
+                m_used += take;
+                v = take == 64 ? 0 : v >> take;
+                bits -= take;
+                if (m_used == 64) flush();
+            }
+        }
+
+        // Pad to a whole word
+        void finish() {
+            if (m_used) flush();
+        }
+
+    private:
+        void flush() {
+            const unsigned char* b = reinterpret_cast<const unsigned char*>(&m_acc);
+            m_out.insert(m_out.end(), b, b + sizeof m_acc);
+            m_acc = 0;
+            m_used = 0;
+        }
+
+        std::vector<unsigned char>& m_out;
+        std::uint64_t m_acc;
+        unsigned m_used;
+};
+
+class bit_reader {
+    public:
+        explicit bit_reader(const unsigned char* p) : m_p{p}, m_acc{0}, m_avail{0} {}
+
+        std::uint64_t get(unsigned bits) {
+            std::uint64_t v = 0;
+            for (unsigned got = 0; got < bits;) {
+                if (m_avail == 0) {
+                    std::memcpy(&m_acc, m_p, sizeof m_acc);
+                    m_p += sizeof m_acc;
+                    m_avail = 64;
+                }
+                const unsigned take = std::min(bits - got, m_avail);
+                const std::uint64_t part = take == 64 ? m_acc : m_acc & ((std::uint64_t(1) << take) - 1);
+                v |= part << got;
+                m_acc = take == 64 ? 0 : m_acc >> take;
+                m_avail -= take;
+                got += take;
+            }
+            return v;
+        }
+
+    private:
+        const unsigned char* m_p;
+        std::uint64_t m_acc;
+        unsigned m_avail;
+};
+
+const std::size_t delta_block = 64;
+
+// Each block is its bit width in one byte, then the packed values in whole words
+template <typename U, typename T>
+bool delta_encode(const T* cells, std::size_t n, std::vector<unsigned char>& out, std::size_t limit) {
+    const unsigned width = 8 * sizeof(U);
+    U zigzag[delta_block];
+    U prev = 0;
+    for (std::size_t i = 0; i < n; i += delta_block) {
+        const std::size_t m = std::min(delta_block, n - i);
+        U all = 0;
+        for (std::size_t k = 0; k < m; ++k) {
+            const U v = tile_bits_of<U>(cells[i + k]);
+            const U d = static_cast<U>(v - prev);
+            prev = v;
+            // Small negative differences become small numbers too
+            zigzag[k] = static_cast<U>(static_cast<U>(d << 1) ^ static_cast<U>(0 - static_cast<U>(d >> (width - 1))));
+            all = static_cast<U>(all | zigzag[k]);
+        }
+        unsigned bits = 0;
+        while (bits < width && (all >> bits)) ++bits;
+        out.push_back(static_cast<unsigned char>(bits));
+        if (bits) {
+            bit_writer w{out};
+            for (std::size_t k = 0; k < m; ++k) w.put(zigzag[k], bits);
+            w.finish();
+        }
+        if (out.size() >= limit) return false;
+    }
+    return true;
+}
+
+template <typename U, typename T>
+void delta_decode(const unsigned char* p, T* cells, std::size_t n) {
+    U prev = 0;
+    for (std::size_t i = 0; i < n; i += delta_block) {
+        const std::size_t m = std::min(delta_block, n - i);
+        const unsigned bits = *p++;
+        if (bits == 0) {
+            std::fill(cells + i, cells + i + m, tile_value_of<T>(prev));
+            continue;
+        }
+        bit_reader r{p};
+        for (std::size_t k = 0; k < m; ++k) {
+            const U z = static_cast<U>(r.get(bits));
+            prev = static_cast<U>(prev + static_cast<U>((z >> 1) ^ static_cast<U>(0 - static_cast<U>(z & 1))));
+            cells[i + k] = tile_value_of<T>(prev);
+        }
+        p += (m * bits + 63) / 64 * 8;
+    }
+}
+
+#if GNB_RECTANGULAR_LZ4
+
+inline bool lz4_encode(const unsigned char* src, std::size_t bytes, std::vector<unsigned char>& out, std::size_t limit) {
+    out.resize(static_cast<std::size_t>(LZ4_compressBound(static_cast<int>(bytes))));
+    const int n = LZ4_compress_default(reinterpret_cast<const char*>(src), reinterpret_cast<char*>(out.data()),
+            static_cast<int>(bytes), static_cast<int>(out.size()));
+    out.resize(n > 0 ? static_cast<std::size_t>(n) : 0);
+    out.shrink_to_fit();
+    return n > 0 && static_cast<std::size_t>(n) < limit;
+}
+
+inline void lz4_decode(const std::vector<unsigned char>& in, unsigned char* dst, std::size_t bytes) {
+    LZ4_decompress_safe(reinterpret_cast<const char*>(in.data()), reinterpret_cast<char*>(dst),
+            static_cast<int>(in.size()), static_cast<int>(bytes));
+}
+
+#endif // GNB_RECTANGULAR_LZ4
+
+} // namespace detail
+
+/*
+ * A read-mostly 2-D grid held as compressed tiles
+ *
+ * compressed_rectangular<std::uint16_t> dem{elevations};  // compress a rectangular
+ * dem.at(y, x);                                          // decompresses one tile, if not cached
+ * dem.set(y, x, 0);                                      // re-compressed when evicted, or on flush()
+ * dem.compression_ratio();                               // e.g. 12.5
+ * dem.for_each_tile([](decltype(dem)::const_tile t) { ... });
+ *
+ * Tiles are 2^TileShift square, each compressed on its own with the chosen
+ * codec, or with whichever does best if that is tile_codec::automatic.
+ * Constant tiles come to a few bytes with either rle or delta, and smooth
+ * data packs well with delta.  The codecs work on the bits of the values, so
+ * they are lossless for floating point as well.
+ *
+ * at() and set() go through a small cache of decompressed tiles, evicting
+ * the least recently used when it is full.  Access with some locality (a
+ * row at a time, say) decompresses each tile about once.  Dirty tiles are
+ * compressed again when evicted, or by flush().  Because even const access
+ * changes the cache, an object must not be used from several threads at once.
+ *
+ * for_each_tile() decompresses each tile into a scratch buffer rather than
+ * the cache, as with sparse_rectangular: cell (t.y+dy, t.x+dx) is at
+ * t.data[dy * tile_size + dx].  The mutable version compresses each tile
+ * again after fn has seen it.
+ */
+template <typename T, unsigned TileShift = 6>
+class compressed_rectangular {
+    private:
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                "compressed_rectangular is for arithmetic and enum types");
+        using bits_type = typename detail::tile_bits<sizeof(T)>::type;
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+
+        static constexpr size_type tile_size = size_type(1) << TileShift;
+
+        template <typename Ptr>
+        struct basic_tile {
+            size_type y, x, height, width;
+            Ptr data;
+        };
+        using tile = basic_tile<T*>;
+        using const_tile = basic_tile<const T*>;
+
+        compressed_rectangular() : compressed_rectangular(0, 0) {}
+
+        // Every cell value, encoded once and copied to each tile, which holds a few bytes
+        explicit compressed_rectangular(size_type height, size_type width, value_type value = value_type(),
+                tile_codec codec = tile_codec::automatic, size_type cache_tiles = 8) :
+            compressed_rectangular(height, width, codec, cache_tiles, nullptr) {
+            std::vector<T> cells(tile_cells, value);
+            const encoded_tile e = encode(cells.data());
+            std::fill(m_tiles.begin(), m_tiles.end(), e);
+        }
+
+        template <class Allocator>
+        explicit compressed_rectangular(const rectangular<T, Allocator>& src, tile_codec codec = tile_codec::automatic,
+                size_type cache_tiles = 8) :
+            compressed_rectangular(src.height(), src.width(), codec, cache_tiles, nullptr) {
+            std::vector<T> cells(tile_cells);
+            for (size_type ty = 0; ty < m_tiles_y; ++ty)
+                for (size_type tx = 0; tx < m_tiles_x; ++tx) {
+                    const tile_extent e = extent(ty, tx);
+                    std::fill(cells.begin(), cells.end(), value_type());
+                    for (size_type dy = 0; dy < e.height; ++dy) {
+                        const T* row = src.data() + (e.y + dy) * m_width + e.x;
+                        std::copy(row, row + e.width, cells.data() + dy * tile_size);
+                    }
+                    m_tiles[ty * m_tiles_x + tx] = encode(cells.data());
+                }
+        }
+
+        size_type size() const { return m_height * m_width; }
+        bool empty() const { return size() == 0; }
+        size_type height() const { return m_height; }
+        size_type width() const { return m_width; }
+        tile_codec codec() const { return m_codec; }
+        size_type tile_count() const { return m_tiles.size(); }
+        size_type cache_capacity() const { return m_cache_capacity; }
+
+        // Bounds-checked, will throw std::out_of_range() if required
+        value_type at(size_type y, size_type x) const {
+            check(y, x);
+            return cached(y >> TileShift, x >> TileShift, false)[cell_index(y, x)];
+        }
+
+        // Bounds-checked, will throw std::out_of_range() if required
+        void set(size_type y, size_type x, value_type v) {
+            check(y, x);
+            cached(y >> TileShift, x >> TileShift, true)[cell_index(y, x)] = v;
+        }
+
+        // The codec the tile holding (y, x) was last compressed with
+        tile_codec codec_at(size_type y, size_type x) const {
+            check(y, x);
+            return m_tiles[(y >> TileShift) * m_tiles_x + (x >> TileShift)].codec;
+        }
+
+        // Compress any tiles changed in the cache
+        void flush() {
+            for (cache_entry& c : m_cache)
+                if (c.dirty) {
+                    m_tiles[c.index] = encode(c.cells.data());
+                    c.dirty = false;
+                }
+        }
+
+        // Bytes of compressed tiles and their directory, as of the last flush()
+        size_type compressed_bytes() const {
+            size_type n = m_tiles.size() * sizeof(encoded_tile);
+            for (const encoded_tile& e : m_tiles) n += e.bytes.size();
+            return n;
+        }
+        size_type uncompressed_bytes() const { return size() * sizeof(T); }
+        double compression_ratio() const {
+            const size_type c = compressed_bytes();
+            return c ? static_cast<double>(uncompressed_bytes()) / static_cast<double>(c) : 1.0;
+        }
+
+        rectangular<T> decompress() const {
+            rectangular<T> out{m_height, m_width};
+            for_each_tile([&](const_tile t) {
+                for (size_type dy = 0; dy < t.height; ++dy)
+                    std::copy(t.data + dy * tile_size, t.data + dy * tile_size + t.width,
+                            out.data() + (t.y + dy) * m_width + t.x);
+            });
+            return out;
+        }
+
+        // Call fn(const_tile) for each tile in row-major order
+        template <typename Fn>
+        void for_each_tile(Fn fn) const {
+            std::vector<T> scratch(tile_cells);
+            for (size_type i = 0; i < m_tiles.size(); ++i) {
+                const cache_entry* c = find(i);
+                const T* cells = c ? c->cells.data() : scratch.data();
+                if (!c) decode(m_tiles[i], scratch.data());
+                fn(view<const_tile>(i, cells));
+            }
+        }
+
+        // Call fn(tile) for each tile in row-major order, and compress it again afterwards
+        template <typename Fn>
+        void for_each_tile(Fn fn) {
+            std::vector<T> scratch(tile_cells);
+            for (size_type i = 0; i < m_tiles.size(); ++i) {
+                if (cache_entry* c = find(i)) {
+                    fn(view<tile>(i, c->cells.data()));
+                    c->dirty = true;
+                    continue;
+                }
+                decode(m_tiles[i], scratch.data());
+                fn(view<tile>(i, scratch.data()));
+                m_tiles[i] = encode(scratch.data());
+            }
+        }
+
+        void swap(compressed_rectangular& r) {
+            std::swap(m_height, r.m_height);
+            std::swap(m_width, r.m_width);
+            std::swap(m_tiles_y, r.m_tiles_y);
+            std::swap(m_tiles_x, r.m_tiles_x);
+            std::swap(m_codec, r.m_codec);
+            std::swap(m_cache_capacity, r.m_cache_capacity);
+            std::swap(m_tiles, r.m_tiles);
+            std::swap(m_cache, r.m_cache);
+            std::swap(m_tick, r.m_tick);
+            std::swap(m_last, r.m_last);
+        }
+
+    private:
+        static constexpr size_type tile_cells = tile_size * tile_size;
+
+        struct encoded_tile {
+            tile_codec codec;
+            std::vector<unsigned char> bytes;
+        };
+
+        struct cache_entry {
+            size_type index;         // in m_tiles
+            std::uint64_t used;      // m_tick when last used
+            bool dirty;
+            std::vector<T> cells;
+        };
+
+        struct tile_extent {
+            size_type y, x, height, width;
+        };
+
+        compressed_rectangular(size_type height, size_type width, tile_codec codec, size_type cache_tiles, std::nullptr_t) :
+            m_height{height}, m_width{width},
+            m_tiles_y{(height + tile_size - 1) >> TileShift}, m_tiles_x{(width + tile_size - 1) >> TileShift},
+            m_codec{codec}, m_cache_capacity{std::max<size_type>(cache_tiles, 1)},
+            m_tiles(m_tiles_y * m_tiles_x), m_cache{}, m_tick{0}, m_last{0} {
+#if !GNB_RECTANGULAR_LZ4
+            if (codec == tile_codec::lz4)
+                throw std::invalid_argument("compressed_rectangular: LZ4 needs GNB_RECTANGULAR_LZ4");
+#endif
+        }
+
+        void check(size_type y, size_type x) const {
+            if (y >= m_height) throw std::out_of_range("compressed_rectangular Y index");
+            if (x >= m_width) throw std::out_of_range("compressed_rectangular X index");
+        }
+
+        static size_type cell_index(size_type y, size_type x) {
+            return ((y & (tile_size - 1)) << TileShift) | (x & (tile_size - 1));
+        }
+
+        tile_extent extent(size_type ty, size_type tx) const {
+            const size_type y = ty << TileShift, x = tx << TileShift;
+            return tile_extent{y, x, std::min(tile_size, m_height - y), std::min(tile_size, m_width - x)};
+        }
+
+        template <typename View>
+        View view(size_type i, typename std::conditional<std::is_same<View, tile>::value, T*, const T*>::type cells) const {
+            const tile_extent e = extent(i / m_tiles_x, i % m_tiles_x);
+            return View{e.y, e.x, e.height, e.width, cells};
+        }
+
+        // Try one codec, true if it beat limit bytes
+        static bool try_codec(tile_codec codec, const T* cells, std::vector<unsigned char>& out, std::size_t limit) {
+            switch (codec) {
+                case tile_codec::rle: return detail::rle_encode<bits_type>(cells, tile_cells, out, limit);
+                case tile_codec::delta: return detail::delta_encode<bits_type>(cells, tile_cells, out, limit);
+#if GNB_RECTANGULAR_LZ4
+                case tile_codec::lz4:
+                    return detail::lz4_encode(reinterpret_cast<const unsigned char*>(cells), tile_cells * sizeof(T), out, limit);
+#endif
+                default: return false;
+            }
+        }
+
+        encoded_tile encode(const T* cells) const {
+            static const tile_codec all[] = {tile_codec::rle, tile_codec::delta, tile_codec::lz4};
+            const unsigned char* raw = reinterpret_cast<const unsigned char*>(cells);
+            encoded_tile best{tile_codec::raw, std::vector<unsigned char>(raw, raw + tile_cells * sizeof(T))};
+            std::vector<unsigned char> out;
+            for (tile_codec c : all) {
+                if (m_codec != tile_codec::automatic && m_codec != c) continue;
+                out.clear();
+                if (try_codec(c, cells, out, best.bytes.size())) {
+                    best.codec = c;
+                    best.bytes.swap(out);
+                }
+            }
+            best.bytes.shrink_to_fit();
+            return best;
+        }
+
+        static void decode(const encoded_tile& e, T* cells) {
+            switch (e.codec) {
+                case tile_codec::rle: detail::rle_decode<bits_type>(e.bytes.data(), cells, tile_cells); break;
+                case tile_codec::delta: detail::delta_decode<bits_type>(e.bytes.data(), cells, tile_cells); break;
+#if GNB_RECTANGULAR_LZ4
+                case tile_codec::lz4: detail::lz4_decode(e.bytes, reinterpret_cast<unsigned char*>(cells), tile_cells * sizeof(T)); break;
+#endif
+                default: std::memcpy(cells, e.bytes.data(), tile_cells * sizeof(T)); break;
+            }
+        }
+
+        cache_entry* find(size_type index) const {
+            for (cache_entry& c : m_cache)
+                if (c.index == index) return &c;
+            return nullptr;
+        }
+
+        // The cells of tile (ty, tx), decompressing it into the cache if need be
+        T* cached(size_type ty, size_type tx, bool dirty) const {
+            const size_type index = ty * m_tiles_x + tx;
+            ++m_tick;
+            // Most accesses are to the same tile as the last one
+            cache_entry* c = m_last < m_cache.size() && m_cache[m_last].index == index ? &m_cache[m_last] : find(index);
+            if (!c) {
+                if (m_cache.size() < m_cache_capacity) {
+                    m_cache.push_back(cache_entry{index, 0, false, std::vector<T>(tile_cells)});
+                    c = &m_cache.back();
+                } else {
+                    c = &*std::min_element(m_cache.begin(), m_cache.end(),
+                            [](const cache_entry& a, const cache_entry& b) { return a.used < b.used; });
+                    if (c->dirty) m_tiles[c->index] = encode(c->cells.data());
+                    c->index = index;
+                    c->dirty = false;
+                }
+                decode(m_tiles[index], c->cells.data());
+            }
+            c->used = m_tick;
+            c->dirty = c->dirty || dirty;
+            m_last = static_cast<size_type>(c - m_cache.data());
+            return c->cells.data();
+        }
+
+        size_type m_height, m_width;
+        size_type m_tiles_y, m_tiles_x;
+        tile_codec m_codec;
+        size_type m_cache_capacity;
+        // The cache belongs to the logical value, so const access may update it
+        mutable std::vector<encoded_tile> m_tiles;
+        mutable std::vector<cache_entry> m_cache;
+        mutable std::uint64_t m_tick;
+        mutable size_type m_last;
+};
+
+template <typename T, unsigned TileShift> constexpr std::size_t compressed_rectangular<T, TileShift>::tile_size;
+template <typename T, unsigned TileShift> constexpr std::size_t compressed_rectangular<T, TileShift>::tile_cells;
+
+} // namespace gnb
+
+#endif // GNB_compressed_rectangular
@@ -0,0 +1,216 @@
+#ifndef GNB_concurrent_rectangular
+#define GNB_concurrent_rectangular
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "rectangular.hpp"
+#include "rectangular_parallel.hpp"
+#include "rectangular_region.hpp"
+
+namespace gnb {
+
+/*
+ * A rectangular shared between threads, locked a band of rows at a time
+ *
+ * concurrent_rectangular<long> counts{1000, 1000};
+ * counts.with_row_lock(y, [&](long* row) { ++row[x]; });              // locks row y's stripe
+ * counts.with_region_lock(region{y, x, 8, 8}, [&](rectangular<long>& g) { ... });
+ * counts.with_regions_lock({from, to}, [&](rectangular<long>& g) { ... });  // several at once
+ * auto copy = counts.snapshot();                                      // locks everything
+ *
+ * The rows are grouped into bands of band_rows (default 1), and band b is
+ * guarded by mutex b % stripe_count().  So threads touching different rows
+ * rarely contend, while the number of mutexes stays fixed however tall the
+ * grid: by default 8 per hardware thread, or one per band if there are fewer
+ * bands.  Each mutex is padded out so that no two share a cache line.
+ *
+ * A region lock holds every stripe covering the region's rows, and the
+ * multi-region and whole-grid locks hold the union of theirs, always taken
+ * in ascending order, so no set of threads using these calls can deadlock.
+ * Locks are not reentrant: fn must not take another lock on the same grid.
+ *
+ * fn gets the row, or the whole grid, and must only touch cells it has
+ * locked; that is not checked.  Bad rows and regions that don't fit the grid
+ * throw std::out_of_range before anything is locked.
+ */
+template <typename T, class Allocator = std::allocator<T> >
+class concurrent_rectangular {
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using grid_type = rectangular<T, Allocator>;
+
+        // stripes == 0 picks a default, as above
+        explicit concurrent_rectangular(size_type height, size_type width, value_type value = value_type(),
+                size_type stripes = 0, size_type band_rows = 1) :
+            concurrent_rectangular(grid_type{height, width, value}, stripes, band_rows) {}
+
+        // Takes over the contents of r
+        explicit concurrent_rectangular(grid_type&& r, size_type stripes = 0, size_type band_rows = 1) :
+            m_grid{std::move(r)}, m_band_rows{std::max<size_type>(band_rows, 1)},
+            m_stripes(choose_stripes(m_grid.height(), m_band_rows, stripes)) {}
+
+        // Not copyable or movable, as other threads may hold locks
+        concurrent_rectangular(const concurrent_rectangular&) = delete;
+        concurrent_rectangular& operator=(const concurrent_rectangular&) = delete;
+
+        size_type height() const { return m_grid.height(); }
+        size_type width() const { return m_grid.width(); }
+        size_type size() const { return m_grid.size(); }
+        bool empty() const { return m_grid.empty(); }
+        size_type band_rows() const { return m_band_rows; }
+        size_type stripe_count() const { return m_stripes.size(); }
+
+        // Which mutex guards row y
+        size_type stripe_of(size_type y) const { return (y / m_band_rows) % m_stripes.size(); }
+
+        // fn(row), where row points to the width() elements of row y
+        template <typename Fn>
+        auto with_row_lock(size_type y, Fn fn) -> decltype(fn(std::declval<T*>())) {
+            check_row(y);
+            std::lock_guard<std::mutex> lock{m_stripes[stripe_of(y)].m};
+            return fn(m_grid.data() + y * width());
+        }
+        template <typename Fn>
+        auto with_row_lock(size_type y, Fn fn) const -> decltype(fn(std::declval<const T*>())) {
+            check_row(y);
+            std::lock_guard<std::mutex> lock{m_stripes[stripe_of(y)].m};
+            return fn(m_grid.data() + y * width());
+        }
+
+        // fn(grid), holding the locks for the rows of r
+        template <typename Fn>
+        auto with_region_lock(const region& r, Fn fn) -> decltype(fn(std::declval<grid_type&>())) {
+            const stripe_guard g{*this, stripes_for(&r, &r + 1)};
+            return fn(m_grid);
+        }
+        template <typename Fn>
+        auto with_region_lock(const region& r, Fn fn) const -> decltype(fn(std::declval<const grid_type&>())) {
+            const stripe_guard g{*this, stripes_for(&r, &r + 1)};
+            return fn(m_grid);
+        }
+
+        // fn(grid), holding the locks for the rows of all of rs at once
+        template <typename Fn>
+        auto with_regions_lock(const std::vector<region>& rs, Fn fn) -> decltype(fn(std::declval<grid_type&>())) {
+            const stripe_guard g{*this, stripes_for(rs.data(), rs.data() + rs.size())};
+            return fn(m_grid);
+        }
+        template <typename Fn>
+        auto with_regions_lock(const std::vector<region>& rs, Fn fn) const
+                -> decltype(fn(std::declval<const grid_type&>())) {
+            const stripe_guard g{*this, stripes_for(rs.data(), rs.data() + rs.size())};
+            return fn(m_grid);
+        }
+
+        // Bounds-checked, will throw std::out_of_range() if required
+        value_type get(size_type y, size_type x) const {
+            check_column(x);
+            return with_row_lock(y, [x](const T* row) { return row[x]; });
+        }
+
+        // Bounds-checked, will throw std::out_of_range() if required
+        void set(size_type y, size_type x, const value_type& v) {
+            check_column(x);
+            with_row_lock(y, [x, &v](T* row) { row[x] = v; });
+        }
+
+        // A consistent copy of the whole grid
+        grid_type snapshot() const {
+            std::vector<size_type> all(m_stripes.size());
+            for (size_type s = 0; s < all.size(); ++s) all[s] = s;
+            const stripe_guard g{*this, std::move(all)};
+            return m_grid;
+        }
+
+    private:
+        // Two cache lines, so that no two mutexes share one whatever the alignment
+        struct stripe {
+            std::mutex m;
+            char pad[128 - sizeof(std::mutex) % 64];
+        };
+
+        // Locks the given stripes, which are sorted and distinct, and unlocks in reverse
+        class stripe_guard {
+            public:
+                stripe_guard(const concurrent_rectangular& c, std::vector<size_type> which) :
+                    m_c(c), m_which{std::move(which)} {
+                    size_type locked = 0;
+                    try {
+                        for (; locked < m_which.size(); ++locked) m_c.m_stripes[m_which[locked]].m.lock();
+                    } catch (...) {
+                        // The destructor won't run, so let go of those taken so far
+                        unlock(locked);
+                        throw;
+                    }
+                }
+                ~stripe_guard() { unlock(m_which.size()); }
+                stripe_guard(const stripe_guard&) = delete;
+                stripe_guard& operator=(const stripe_guard&) = delete;
+
+            private:
+                // The first n stripes, in reverse
+                void unlock(size_type n) {
+                    while (n-- > 0) m_c.m_stripes[m_which[n]].m.unlock();
+                }
+
+                const concurrent_rectangular& m_c;
+                std::vector<size_type> m_which;
+        };
+
+        static size_type choose_stripes(size_type height, size_type band_rows, size_type stripes) {
+            const size_type bands = std::max<size_type>((height + band_rows - 1) / band_rows, 1);
+            return stripes ? stripes : std::min<size_type>(bands, 8 * size_type(default_band_count()));
+        }
+
+        void check_row(size_type y) const {
+            if (y >= height()) throw std::out_of_range("concurrent_rectangular Y index");
+        }
+        void check_column(size_type x) const {
+            if (x >= width()) throw std::out_of_range("concurrent_rectangular X index");
+        }
+
+        // The stripes covering the rows of [first, last), in the order to lock them
+        std::vector<size_type> stripes_for(const region* first, const region* last) const {
+            std::vector<bool> wanted(m_stripes.size());
+            for (const region* r = first; r != last; ++r) {
+                if (r->y > height() || r->height > height() - r->y || r->x > width() || r->width > width() - r->x)
+                    throw std::out_of_range("concurrent_rectangular region");
+                if (r->height == 0 || r->width == 0) continue;
+                const size_type b0 = r->y / m_band_rows, b1 = (r->y + r->height - 1) / m_band_rows;
+                // Past stripe_count() bands, every stripe is covered
+                for (size_type b = b0; b <= b1 && b - b0 < m_stripes.size(); ++b) wanted[b % m_stripes.size()] = true;
+            }
+            std::vector<size_type> which;
+            for (size_type s = 0; s < wanted.size(); ++s)
+                if (wanted[s]) which.push_back(s);
+            return which;
+        }
+
+        grid_type m_grid;
+        size_type m_band_rows;
+        mutable std::vector<stripe> m_stripes;
+};
+
+} // namespace gnb
+
+#endif // GNB_concurrent_rectangular
@@ -0,0 +1,206 @@
+#ifndef GNB_cow_rectangular
+#define GNB_cow_rectangular
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "rectangular.hpp"
+
+namespace gnb {
+
+/*
+ * Copy-on-write 2-D container, for taking cheap snapshots of a grid
+ *
+ * The data is held in bands of whole rows, each of which is shared between
+ * copies until one of them asks for mutable access to it.  So a copy costs
+ * one pointer per band, and a copy that is then modified only duplicates the
+ * bands it touches.
+ *
+ * cow_rectangular<float> world{4096, 4096};
+ * auto snapshot = world;      // cheap
+ * world.at(10, 10) = 1.0f;    // duplicates the band holding row 10 only
+ *
+ * Mutable access (non-const at(), operator[]) may duplicate a band, which
+ * invalidates any pointers into the old one held by *this* object; pointers
+ * obtained through const access stay valid until the next mutable access.  As
+ * with any container, one object must not be mutated by several threads at
+ * once, but different copies sharing bands may be used from different threads.
+ * Each band's count of sharers is dropped with release and checked with
+ * acquire ordering, so once a copy has let go of a band, everything it read
+ * from it happens before another copy writes to the band in place.
+ */
+template <typename T, class Allocator = std::allocator<T> >
+class cow_rectangular {
+    private:
+        using Band = std::vector<T, Allocator>;
+
+        struct SharedBand {
+            explicit SharedBand(Band&& b) : data(std::move(b)), sharers{1} {}
+            Band data;
+            std::atomic<std::size_t> sharers;
+        };
+
+        // Like shared_ptr<Band>, but with a count that orders access to the band
+        class BandPtr {
+            public:
+                explicit BandPtr(Band&& b) : m_p{new SharedBand(std::move(b))} {}
+                BandPtr(const BandPtr& b) : m_p{b.m_p} { m_p->sharers.fetch_add(1, std::memory_order_relaxed); }
+                BandPtr(BandPtr&& b) noexcept : m_p{b.m_p} { b.m_p = nullptr; }
+                BandPtr& operator=(BandPtr b) noexcept { std::swap(m_p, b.m_p); return *this; }
+                ~BandPtr() {
+                    if (m_p && m_p->sharers.fetch_sub(1, std::memory_order_acq_rel) == 1) delete m_p;
+                }
+
+                Band& operator*() const { return m_p->data; }
+                Band* operator->() const { return &m_p->data; }
+                Band* get() const { return &m_p->data; }
+                std::size_t use_count() const { return m_p->sharers.load(std::memory_order_acquire); }
+
+            private:
+                SharedBand* m_p;
+        };
+    public:
+        using value_type = T;
+        using reference = T&;
+        using const_reference = const T&;
+        using pointer = T*;
+        using const_pointer = const T*;
+        using size_type = typename Band::size_type;
+        using difference_type = typename Band::difference_type;
+
+        cow_rectangular() : m_height{0}, m_width{0}, m_band_rows{1}, m_bands{} {}
+        // band_rows == 0 picks a band of about 64KiB
+        explicit cow_rectangular(size_type height, size_type width, value_type value = value_type(),
+                size_type band_rows = 0) :
+            m_height{height}, m_width{width}, m_band_rows{choose_band_rows(width, band_rows)}, m_bands{} {
+                m_bands.reserve(band_count());
+                for (size_type y = 0; y < height; y += m_band_rows)
+                    m_bands.push_back(BandPtr{Band(rows_in_band(y) * width, value)});
+        }
+        explicit cow_rectangular(const rectangular<T, Allocator>& r, size_type band_rows = 0) :
+            m_height{r.height()}, m_width{r.width()}, m_band_rows{choose_band_rows(r.width(), band_rows)}, m_bands{} {
+                m_bands.reserve(band_count());
+                for (size_type y = 0; y < m_height; y += m_band_rows)
+                    m_bands.push_back(BandPtr{Band(r.begin() + y * m_width,
+                        r.begin() + (y + rows_in_band(y)) * m_width)});
+        }
+
+        // Default dtor/copy/assign share the bands, which is the point
+        ~cow_rectangular() = default;
+        cow_rectangular(const cow_rectangular&) = default;
+        cow_rectangular& operator=(const cow_rectangular&) = default;
+
+        // Move ctor/assign need help to maintain invariants
+        cow_rectangular(cow_rectangular&& r) : m_height{0}, m_width{0}, m_band_rows{1}, m_bands{} { swap(r); }
+        cow_rectangular& operator=(cow_rectangular&& r) { swap(r); return *this; }
+
+        size_type size() const { return m_height * m_width; }
+        bool empty() const { return size() == 0; }
+
+        size_type height() const { return m_height; }
+        size_type width() const { return m_width; }
+
+        // Bounds-checked, will throw std::out_of_range() if required
+        // May duplicate the band containing row y
+        reference at(size_type y, size_type x) {
+            if (y >= m_height) throw std::out_of_range("cow_rectangular Y index");
+            if (x >= m_width) throw std::out_of_range("cow_rectangular X index");
+            return (*this)[y][x];
+        }
+
+        // Bounds-checked, will throw std::out_of_range() if required
+        const_reference at(size_type y, size_type x) const {
+            if (y >= m_height) throw std::out_of_range("cow_rectangular Y index");
+            if (x >= m_width) throw std::out_of_range("cow_rectangular X index");
+            return (*this)[y][x];
+        }
+
+        // Raw pointers, fast but no bounds checking
+        // The mutable version may duplicate the band containing row y
+        pointer operator[](size_type y) {
+            return writable_band(y / m_band_rows)->data() + (y % m_band_rows) * m_width;
+        }
+        const_pointer operator[](size_type y) const {
+            return m_bands[y / m_band_rows]->data() + (y % m_band_rows) * m_width;
+        }
+
+        // Set every element to the given value, shared bands are replaced rather than copied
+        void fill(const_reference value) {
+            for (size_type b = 0; b < m_bands.size(); ++b) {
+                if (m_bands[b].use_count() == 1)
+                    std::fill(m_bands[b]->begin(), m_bands[b]->end(), value);
+                else
+                    m_bands[b] = BandPtr{Band(m_bands[b]->size(), value)};
+            }
+        }
+
+        void swap(cow_rectangular& r) {
+            std::swap(m_height, r.m_height);
+            std::swap(m_width, r.m_width);
+            std::swap(m_band_rows, r.m_band_rows);
+            std::swap(m_bands, r.m_bands);
+        }
+
+        // A plain (deep) copy of the contents
+        rectangular<T, Allocator> to_rectangular() const {
+            Band data;
+            data.reserve(size());
+            for (const auto& b : m_bands) data.insert(data.end(), b->begin(), b->end());
+            return rectangular<T, Allocator>{m_height, m_width, data};
+        }
+
+        size_type band_rows() const { return m_band_rows; }
+        size_type band_count() const { return (m_height + m_band_rows - 1) / m_band_rows; }
+        // How many bands are still shared with some other copy
+        size_type shared_bands() const {
+            return std::count_if(m_bands.begin(), m_bands.end(),
+                [](const BandPtr& b) { return b.use_count() > 1; });
+        }
+
+        // Check invariants, mainly for unit tests
+        bool invariants() const {
+            if (m_bands.size() != band_count()) return false;
+            for (size_type b = 0; b < m_bands.size(); ++b)
+                if (m_bands[b]->size() != rows_in_band(b * m_band_rows) * m_width) return false;
+            return true;
+        }
+
+    private:
+        static size_type choose_band_rows(size_type width, size_type band_rows) {
+            if (band_rows) return band_rows;
+            size_type row_bytes = std::max<size_type>(1, width * sizeof(T));
+            return std::max<size_type>(1, 65536 / row_bytes);
+        }
+        size_type rows_in_band(size_type y) const { return std::min(m_band_rows, m_height - y); }
+
+        Band* writable_band(size_type b) {
+            BandPtr& band = m_bands[b];
+            if (band.use_count() > 1) band = BandPtr{Band(*band)};
+            return band.get();
+        }
+
+        size_type m_height, m_width, m_band_rows;
+        std::vector<BandPtr> m_bands;
+};
+
+} // namespace gnb
+
+#endif // GNB_cow_rectangular
@@ -14,7 +14,10 @@
  * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
  */
 
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -44,6 +47,7 @@ class rectangular {
         using const_pointer = typename BaseType::const_pointer;
         using size_type = typename BaseType::size_type;
         using difference_type = typename BaseType::difference_type;
+        using allocator_type = typename BaseType::allocator_type;
 
         rectangular() : m_height{0}, m_width{0}, m_data{} {}
         explicit rectangular(size_type height, size_type width, value_type value = value_type()) : 
@@ -66,7 +70,7 @@ class rectangular {
         }
         // Efficiently move a std:vector<> into a rectangular
         // NB: will erase the argument!
-        rectangular(size_type height, size_type width, std::vector<value_type>& vec) :
+        rectangular(size_type height, size_type width, std::vector<value_type, Allocator>& vec) :
             m_height{height}, m_width{width},
             m_data{} {
                 if (vec.size() != height * width) throw std::out_of_range("rectangular vector<> create");
@@ -96,6 +100,8 @@ class rectangular {
 
         size_type height() const { return m_height; }
         size_type width() const { return m_width; }
+
+        allocator_type get_allocator() const { return m_data.get_allocator(); }
         
         // Bounds-checked, will throw std::out_of_range() if required
         reference at(size_type y, size_type x) {
@@ -116,6 +122,10 @@ class rectangular {
         pointer operator[](size_type y) { return &m_data[y * m_width]; }
         const_pointer operator[](size_type y) const { return &m_data[y * m_width]; }
 
+        // The underlying row-major buffer, as per std::vector<>::data()
+        pointer data() { return m_data.data(); }
+        const_pointer data() const { return m_data.data(); }
+
         // Will retain existing data, erasing elements that are no longer 
         // required, and using value for any new data
         void resize(size_type new_height, size_type new_width, 
@@ -125,6 +135,57 @@ class rectangular {
                 m_width = new_width;
         }
 
+        // Reserve space for height x width elements, so growing to that
+        // size will not reallocate
+        void reserve(size_type height, size_type width) { m_data.reserve(height * width); }
+
+        // Insert n rows of value before row y, throws std::out_of_range if y > height()
+        // Inserting at height() appends, in amortized O(n * width())
+        void insert_rows(size_type y, size_type n, value_type value = value_type()) {
+            if (y > m_height) throw std::out_of_range("rectangular insert_rows");
+            m_data.insert(m_data.begin() + y * m_width, n * m_width, value);
+            m_height += n;
+        }
+
+        // Erase rows [y, y+n), throws std::out_of_range if they do not all exist
+        void erase_rows(size_type y, size_type n) {
+            if (n > m_height || y > m_height - n) throw std::out_of_range("rectangular erase_rows");
+            m_data.erase(m_data.begin() + y * m_width, m_data.begin() + (y + n) * m_width);
+            m_height -= n;
+        }
+
+        // Insert n columns of value before column x, throws std::out_of_range if x > width()
+        void insert_cols(size_type x, size_type n, value_type value = value_type()) {
+            if (x > m_width) throw std::out_of_range("rectangular insert_cols");
+            if (n == 0) return;
+            const size_type new_width = m_width + n;
+            m_data.resize(m_height * new_width, value);
+            // One pass from the end, each row moves right to its new place
+            for (size_type y = m_height; y-- > 0; ) {
+                iterator from = m_data.begin() + y * m_width, to = m_data.begin() + y * new_width;
+                std::move_backward(from + x, from + m_width, to + new_width);
+                // Row 0 starts in place, and self-move can lose the value
+                if (y > 0) std::move_backward(from, from + x, to + x);
+                std::fill(to + x, to + x + n, value);
+            }
+            m_width = new_width;
+        }
+
+        // Erase columns [x, x+n), throws std::out_of_range if they do not all exist
+        void erase_cols(size_type x, size_type n) {
+            if (n > m_width || x > m_width - n) throw std::out_of_range("rectangular erase_cols");
+            if (n == 0) return;
+            const size_type new_width = m_width - n;
+            // One pass from the start, each row moves left to its new place
+            for (size_type y = 0; y < m_height; ++y) {
+                iterator from = m_data.begin() + y * m_width, to = m_data.begin() + y * new_width;
+                if (y > 0) std::move(from, from + x, to);
+                std::move(from + x + n, from + m_width, to + x);
+            }
+            m_data.erase(m_data.begin() + m_height * new_width, m_data.end());
+            m_width = new_width;
+        }
+
         // Set every element to the given fallue
         void fill(const_reference value) {
             std::fill(begin(), end(), value);
@@ -144,6 +205,38 @@ class rectangular {
         BaseType m_data;
 };
 
+namespace detail {
+
+// Types where == means the bytes are the same: no padding, and not floating
+// point (0.0 == -0.0, NaN != NaN)
+template <typename T>
+struct bytewise_equality : std::integral_constant<bool,
+        std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value> {};
+
+template <typename T>
+bool elements_equal(const T* a, const T* b, std::size_t n, std::true_type) {
+    return n == 0 || std::memcmp(a, b, n * sizeof(T)) == 0;
+}
+
+template <typename T>
+bool elements_equal(const T* a, const T* b, std::size_t n, std::false_type) {
+    return std::equal(a, a + n, b);
+}
+
+} // namespace detail
+
+// Same shape and equal elements, with memcmp() where that means the same
+template <typename T, class Allocator>
+bool operator==(const rectangular<T, Allocator>& a, const rectangular<T, Allocator>& b) {
+    return a.height() == b.height() && a.width() == b.width()
+        && detail::elements_equal(a.data(), b.data(), a.size(), detail::bytewise_equality<T>{});
+}
+
+template <typename T, class Allocator>
+bool operator!=(const rectangular<T, Allocator>& a, const rectangular<T, Allocator>& b) {
+    return !(a == b);
+}
+
 /*
  * checked_rectangular IS-A rectangular
  * but r[y][x] is now range-checked and may throw std::out_of_range like r.at(y,x)
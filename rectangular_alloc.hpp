@@ -0,0 +1,321 @@
+#ifndef GNB_rectangular_alloc
+#define GNB_rectangular_alloc
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rectangular.hpp"
+#include "rectangular_parallel.hpp"
+
+#if defined(__linux__)
+#   include <sys/mman.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#   define GNB_RECTANGULAR_MMAP 1
+#   ifndef MAP_HUGE_SHIFT
+#       define MAP_HUGE_SHIFT 26
+#   endif
+#else
+#   define GNB_RECTANGULAR_MMAP 0
+#endif
+
+namespace gnb {
+
+/*
+ * What sort of pages actually back an allocation
+ *  - normal: ordinary base pages (usually 4KiB)
+ *  - transparent_huge: anonymous memory the kernel has been asked (and is
+ *    configured) to back with transparent huge pages.  These are assigned at
+ *    page-fault time, so an unlucky fragmented system may still hand out some
+ *    small pages.
+ *  - huge: explicit hugetlbfs pages, guaranteed huge
+ */
+enum class page_kind { normal, transparent_huge, huge };
+
+// How hard the allocator should try to get huge pages
+enum class hugepage_mode {
+    prefer_huge,        // MAP_HUGETLB, then madvise(MADV_HUGEPAGE), then normal pages
+    transparent_only,   // madvise(MADV_HUGEPAGE), then normal pages
+    none                // normal pages only (mainly for comparison & testing)
+};
+
+/*
+ * NUMA placement of large blocks, applied with mbind() before any page is touched
+ *  - local: the kernel default, each page goes on the node of the thread that
+ *    first touches it.  See make_first_touch() below.
+ *  - interleave: pages are spread round-robin over the nodes in nodemask
+ *  - bind: pages only come from the nodes in nodemask
+ */
+enum class numa_policy { local, interleave, bind };
+
+struct numa_placement {
+    numa_policy policy;
+    unsigned long nodemask; // bit n set for node n
+};
+
+struct page_info {
+    page_kind kind;
+    std::size_t page_size;
+    bool numa_applied; // false if the numa_placement was local, or mbind() failed
+};
+
+namespace detail {
+
+inline std::size_t base_page_size() {
+#if GNB_RECTANGULAR_MMAP
+    static const std::size_t sz = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return sz;
+#else
+    return 4096;
+#endif
+}
+
+#if GNB_RECTANGULAR_MMAP
+// MADV_HUGEPAGE succeeds even when THP is administratively disabled, so
+// check the sysfs knob to know whether it will have any effect
+inline bool transparent_hugepages_enabled() {
+    static const bool enabled = [] {
+        std::FILE* f = std::fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+        if (!f) return false;
+        char buf[128] = {};
+        bool ok = std::fgets(buf, sizeof buf, f) != nullptr && std::strstr(buf, "[never]") == nullptr;
+        std::fclose(f);
+        return ok;
+    }();
+    return enabled;
+}
+
+// Straight to the syscall, so there is no dependency on libnuma
+inline bool apply_numa(void* p, std::size_t len, numa_placement numa) {
+#if defined(SYS_mbind)
+    const int mpol_bind = 2, mpol_interleave = 3;
+    if (numa.policy == numa_policy::local) return false;
+    int mode = numa.policy == numa_policy::bind ? mpol_bind : mpol_interleave;
+    unsigned long mask = numa.nodemask;
+    // The kernel reads one bit fewer than maxnode, as libnuma also allows for
+    return ::syscall(SYS_mbind, p, len, mode, &mask, sizeof mask * 8 + 1, 0) == 0;
+#else
+    (void)p; (void)len; (void)numa;
+    return false;
+#endif
+}
+
+// Map len bytes aligned to align, by over-mapping and trimming the ends
+inline void* map_aligned(std::size_t len, std::size_t align) {
+    void* p = ::mmap(nullptr, len + align, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+    auto base = reinterpret_cast<std::uintptr_t>(p);
+    auto aligned = (base + align - 1) & ~(std::uintptr_t(align) - 1);
+    if (aligned != base) ::munmap(p, aligned - base);
+    auto tail = base + len + align - (aligned + len);
+    if (tail) ::munmap(reinterpret_cast<void*>(aligned + len), tail);
+    return reinterpret_cast<void*>(aligned);
+}
+#endif
+
+struct hugepage_state {
+    page_info info;
+    bool defer_init;
+};
+
+} // namespace detail
+
+/*
+ * Allocator for very large rectangulars (multi-GB) where random access is
+ * dominated by TLB misses.  Large blocks are mmap()ed directly and backed by
+ * huge pages where the system allows it, falling back to transparent huge pages
+ * and finally normal pages.  Small blocks just use operator new.
+ *
+ * using HR = rectangular<double, hugepage_allocator<double>>;
+ * HR grid{100000, 40000};
+ * grid.get_allocator().info().kind; // What we actually got
+ *
+ * Copies of the allocator share the page_info of the most recent large
+ * allocation, so the rectangular's allocator reports on its own buffer.
+ * Large blocks can also be given an explicit NUMA placement.
+ * On non-Linux systems this is just operator new and always reports normal pages.
+ */
+template <typename T>
+class hugepage_allocator {
+        template <typename U> friend class hugepage_allocator;
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        // Keep the page_info with the buffer it describes
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        static constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+        // Allocations smaller than this do not bother with mmap()
+        static constexpr std::size_t mmap_threshold = huge_page_size;
+
+        explicit hugepage_allocator(hugepage_mode mode = hugepage_mode::prefer_huge,
+                numa_placement numa = numa_placement{numa_policy::local, 0}) :
+            m_mode{mode}, m_numa{numa},
+            m_state{std::make_shared<detail::hugepage_state>(detail::hugepage_state{
+                page_info{page_kind::normal, detail::base_page_size(), false}, false})} {}
+        template <typename U>
+        hugepage_allocator(const hugepage_allocator<U>& a) : m_mode{a.m_mode}, m_numa{a.m_numa}, m_state{a.m_state} {}
+
+        // A copied container gets its own page_info
+        hugepage_allocator select_on_container_copy_construction() const { return hugepage_allocator{m_mode, m_numa}; }
+
+        T* allocate(size_type n) {
+            if (n > std::numeric_limits<size_type>::max() / sizeof(T)) throw std::bad_alloc();
+            size_type bytes = n * sizeof(T);
+#if GNB_RECTANGULAR_MMAP
+            if (!use_mmap(bytes)) return static_cast<T*>(::operator new(bytes));
+            size_type len = round_up(bytes);
+            void* p = MAP_FAILED;
+            if (m_mode == hugepage_mode::prefer_huge) {
+                // Ask for 2MiB pages explicitly, the default hugetlb size may be 1GiB
+                p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+                if (p != MAP_FAILED) {
+                    m_state->info = page_info{page_kind::huge, huge_page_size, detail::apply_numa(p, len, m_numa)};
+                    return static_cast<T*>(p);
+                }
+            }
+            p = detail::map_aligned(len, huge_page_size);
+            if (!p) throw std::bad_alloc();
+            if (m_mode != hugepage_mode::none && detail::transparent_hugepages_enabled()
+                    && ::madvise(p, len, MADV_HUGEPAGE) == 0) {
+                m_state->info = page_info{page_kind::transparent_huge, huge_page_size, false};
+            } else {
+                m_state->info = page_info{page_kind::normal, detail::base_page_size(), false};
+            }
+            m_state->info.numa_applied = detail::apply_numa(p, len, m_numa);
+            return static_cast<T*>(p);
+#else
+            return static_cast<T*>(::operator new(bytes));
+#endif
+        }
+
+        void deallocate(T* p, size_type n) noexcept {
+            size_type bytes = n * sizeof(T);
+            if (!use_mmap(bytes)) {
+                ::operator delete(p);
+                return;
+            }
+#if GNB_RECTANGULAR_MMAP
+            // Both explicit and transparent mappings are exactly round_up(bytes) long
+            ::munmap(p, round_up(bytes));
+#endif
+        }
+
+        /*
+         * Value-initialise as usual, unless make_first_touch() has asked to
+         * defer initialisation so that pages are first touched by the right thread
+         */
+        template <typename U>
+        void construct(U* p) {
+            if (m_state->defer_init) ::new(static_cast<void*>(p)) U;
+            else ::new(static_cast<void*>(p)) U();
+        }
+        template <typename U, typename... Args>
+        void construct(U* p, Args&&... args) { ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+
+        // Pages backing the most recent large allocation
+        page_info info() const { return m_state->info; }
+        hugepage_mode mode() const { return m_mode; }
+        numa_placement numa() const { return m_numa; }
+        void defer_init(bool defer) { m_state->defer_init = defer; }
+
+        // Any instance can free memory from any other
+        template <typename U>
+        bool operator==(const hugepage_allocator<U>&) const { return true; }
+        template <typename U>
+        bool operator!=(const hugepage_allocator<U>&) const { return false; }
+
+    private:
+        static bool use_mmap(size_type bytes) { return GNB_RECTANGULAR_MMAP && bytes >= mmap_threshold; }
+        static size_type round_up(size_type bytes) {
+            return (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+        }
+
+        hugepage_mode m_mode;
+        numa_placement m_numa;
+        std::shared_ptr<detail::hugepage_state> m_state;
+};
+
+template <typename T> constexpr std::size_t hugepage_allocator<T>::huge_page_size;
+template <typename T> constexpr std::size_t hugepage_allocator<T>::mmap_threshold;
+
+namespace detail {
+// Only hugepage_allocator can skip the initial value-initialisation.  It gets
+// a state of its own, so the deferral never reaches other containers sharing a's
+template <typename A> A first_touch_allocator(const A& a) { return a; }
+template <typename T> hugepage_allocator<T> first_touch_allocator(const hugepage_allocator<T>& a) {
+    return hugepage_allocator<T>{a.mode(), a.numa()};
+}
+template <typename A> void defer_init(A&, bool) {}
+template <typename T> void defer_init(hugepage_allocator<T>& a, bool defer) { a.defer_init(defer); }
+} // namespace detail
+
+/*
+ * Create a rectangular whose row bands are first touched in parallel, by the
+ * same row_band_of() partitioning that parallel_row_bands() uses.  With the
+ * kernel's default first-touch NUMA policy, each band's pages then land on the
+ * node of the thread that initialised it, rather than all on the node of the
+ * constructing thread.
+ *
+ * auto grid = make_first_touch<float>(height, width, 0.0f, nthreads);
+ * parallel_row_bands(grid.height(), nthreads, [&](unsigned, row_band b) { ... });
+ *
+ * This needs an allocator that hands out untouched memory and can skip
+ * value-initialisation, i.e. hugepage_allocator and a trivially
+ * default-constructible T.  Any other allocator still works, but the buffer is
+ * zeroed by the calling thread first so there is no placement benefit.  A
+ * hugepage_allocator is copied with fresh page_info, so alloc and its other
+ * copies don't report on the new buffer.  The OS may migrate threads, so pin
+ * them if placement really matters.
+ */
+template <typename T, class Allocator = hugepage_allocator<T> >
+rectangular<T, Allocator> make_first_touch(std::size_t height, std::size_t width,
+        const T& value = T(), unsigned nbands = default_band_count(),
+        const Allocator& alloc = Allocator()) {
+    std::vector<T, Allocator> vec{detail::first_touch_allocator(alloc)};
+    Allocator a = vec.get_allocator();
+    detail::defer_init(a, true);
+    try {
+        vec.resize(height * width);
+    } catch (...) {
+        detail::defer_init(a, false);
+        throw;
+    }
+    detail::defer_init(a, false);
+    T* data = vec.data();
+    parallel_row_bands(height, nbands, [=](unsigned, row_band b) {
+        std::fill(data + b.begin * width, data + b.end * width, value);
+    });
+    return rectangular<T, Allocator>{height, width, vec};
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_alloc
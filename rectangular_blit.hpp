@@ -0,0 +1,92 @@
+#ifndef GNB_rectangular_blit
+#define GNB_rectangular_blit
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+
+#include "rectangular.hpp"
+
+namespace gnb {
+
+/*
+ * Copy a sub-rectangle between rectangulars, or within one
+ *
+ * copy_region(tile, 0, 0, 16, 16, screen, 100, 200);  // blit a 16x16 tile
+ * copy_region(screen, 1, 0, 99, 320, screen, 0, 0);   // scroll up one row
+ *
+ * The region is bounds-checked once per call, against both grids, and throws
+ * std::out_of_range if it does not fit.  Rows are then copied with one
+ * memmove() each for trivially copyable T, otherwise with std::copy.
+ *
+ * The source and destination may overlap when they are the same grid: rows
+ * are copied bottom up when moving down, and each row handles its own
+ * overlap, so the result is as if the region were copied via a temporary.
+ */
+
+namespace detail {
+
+inline bool region_fits(std::size_t y, std::size_t x, std::size_t h, std::size_t w,
+        std::size_t height, std::size_t width) {
+    return h <= height && y <= height - h && w <= width && x <= width - w;
+}
+
+// Copy one row of n elements, which may overlap
+template <typename T>
+void copy_row(const T* src, T* dst, std::size_t n, std::true_type) {
+    std::memmove(dst, src, n * sizeof(T));
+}
+
+template <typename T>
+void copy_row(const T* src, T* dst, std::size_t n, std::false_type) {
+    std::less<const T*> before;
+    if (before(src, dst) && before(dst, src + n))
+        std::copy_backward(src, src + n, dst + n);
+    else
+        std::copy(src, src + n, dst);
+}
+
+} // namespace detail
+
+// Copy the h x w region at (sy, sx) of src to (dy, dx) of dst
+template <typename T, class A1, class A2>
+void copy_region(const rectangular<T, A1>& src, std::size_t sy, std::size_t sx, std::size_t h, std::size_t w,
+        rectangular<T, A2>& dst, std::size_t dy, std::size_t dx) {
+    if (!detail::region_fits(sy, sx, h, w, src.height(), src.width()))
+        throw std::out_of_range("rectangular copy_region source");
+    if (!detail::region_fits(dy, dx, h, w, dst.height(), dst.width()))
+        throw std::out_of_range("rectangular copy_region destination");
+    if (h == 0 || w == 0) return;
+
+    using trivial = std::integral_constant<bool, std::is_trivially_copyable<T>::value>;
+    const T* s = src.data() + sy * src.width() + sx;
+    T* d = dst.data() + dy * dst.width() + dx;
+    // Only the same grid can overlap, and then the strides are equal
+    if (static_cast<const void*>(&src) == static_cast<const void*>(&dst) && dy > sy) {
+        for (std::size_t y = h; y-- > 0; )
+            detail::copy_row(s + y * src.width(), d + y * dst.width(), w, trivial{});
+    } else {
+        for (std::size_t y = 0; y < h; ++y)
+            detail::copy_row(s + y * src.width(), d + y * dst.width(), w, trivial{});
+    }
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_blit
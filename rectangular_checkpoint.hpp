@@ -0,0 +1,482 @@
+#ifndef GNB_rectangular_checkpoint
+#define GNB_rectangular_checkpoint
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "rectangular.hpp"
+#include "cow_rectangular.hpp"
+
+#if defined(__linux__) && defined(__has_include)
+#   if __has_include(<linux/io_uring.h>)
+#       include <linux/io_uring.h>
+#       include <sys/mman.h>
+#       include <sys/syscall.h>
+#   endif
+#endif
+#if defined(IORING_OFF_SQES) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#   define GNB_RECTANGULAR_IO_URING 1
+#else
+#   define GNB_RECTANGULAR_IO_URING 0
+#endif
+
+namespace gnb {
+
+/*
+ * Saving grids to disk in the background (POSIX)
+ *
+ * auto done = save_async("step42.ckpt", world);   // copies world, then returns
+ * auto done = save_async("step42.ckpt", cow);     // cow_rectangular: shares its bands instead
+ * ...carry on changing world or cow...
+ * done.get();                                    // wait, and rethrow any error
+ * auto back = load_checkpoint<float>("step42.ckpt");
+ *
+ * save_async() takes a snapshot and returns a std::future<void> at once; a
+ * new thread writes the snapshot out.  A rectangular is copied (or moved, if
+ * passed as an rvalue); a cow_rectangular is copied the cheap way, so the
+ * snapshot shares its bands and the caller's next change to each band makes
+ * a private copy of just that band, until the future is ready, when the
+ * snapshot has been released.  Dropping the future does not wait.
+ *
+ * The file is a 4KiB header (shape and element size) followed by the raw
+ * elements, written as 1MiB pieces at page-aligned offsets.  On Linux they
+ * are queued through io_uring, several at a time, where the kernel allows
+ * it; otherwise, or with checkpoint_io::pwrite, the thread pwrite()s them in
+ * turn.  The data goes to a temporary file beside path, named for the
+ * process and the save, is fsync()ed, and is then renamed to path, so path is
+ * always either the old checkpoint or the whole of one new one, even when
+ * saves to the same path overlap.
+ *
+ * Errors throw std::runtime_error, from the future for save_async().
+ * Element types must be trivially copyable, and the file is only readable
+ * on machines with the same byte order.
+ */
+enum class checkpoint_io { automatic, pwrite };
+
+namespace detail {
+
+const std::size_t checkpoint_header_bytes = 4096;
+const std::size_t checkpoint_piece_bytes = std::size_t(1) << 20;
+const char checkpoint_magic[8] = {'G', 'N', 'B', 'C', 'K', 'P', 'T', '1'};
+
+[[noreturn]] inline void checkpoint_fail(const std::string& path, const char* why, int err = 0) {
+    std::string msg = "rectangular checkpoint " + path + ": " + why;
+    if (err) msg += std::string(": ") + std::strerror(err);
+    throw std::runtime_error(msg);
+}
+
+// "<path>.tmp.<pid>.<n>", different for every save in every process
+inline std::string checkpoint_temp_path(const std::string& path) {
+    static std::atomic<unsigned long> saves{0};
+    return path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(saves.fetch_add(1));
+}
+
+// Bytes to write at a file offset
+struct checkpoint_piece {
+    const unsigned char* data;
+    std::size_t bytes;
+    std::uint64_t offset;
+};
+
+// Closes on destruction, and removes the file unless told to keep it
+class checkpoint_fd {
+    public:
+        checkpoint_fd(const std::string& path, int flags) : m_path{path}, m_fd{::open(path.c_str(), flags | O_CLOEXEC, 0644)},
+            m_remove{(flags & O_CREAT) != 0} {
+            if (m_fd < 0) checkpoint_fail(path, "cannot open", errno);
+        }
+        ~checkpoint_fd() {
+            if (m_fd >= 0) ::close(m_fd);
+            if (m_remove) std::remove(m_path.c_str());
+        }
+        checkpoint_fd(const checkpoint_fd&) = delete;
+        checkpoint_fd& operator=(const checkpoint_fd&) = delete;
+
+        int get() const { return m_fd; }
+
+        // Flush to disk, close, and rename over to
+        void commit(const std::string& to) {
+            if (::fsync(m_fd) != 0) checkpoint_fail(m_path, "fsync failed", errno);
+            const int fd = m_fd;
+            m_fd = -1;
+            if (::close(fd) != 0) checkpoint_fail(m_path, "write failed", errno);
+            if (std::rename(m_path.c_str(), to.c_str()) != 0) checkpoint_fail(to, "rename failed", errno);
+            m_remove = false;
+        }
+
+    private:
+        std::string m_path;
+        int m_fd;
+        bool m_remove;
+};
+
+// 0, or the errno of the write that failed
+inline int pwrite_piece(int fd, checkpoint_piece p) {
+    while (p.bytes) {
+        const ssize_t n = ::pwrite(fd, p.data, p.bytes, static_cast<off_t>(p.offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        p.data += n;
+        p.bytes -= static_cast<std::size_t>(n);
+        p.offset += static_cast<std::uint64_t>(n);
+    }
+    return 0;
+}
+
+inline void pwrite_all(int fd, checkpoint_piece p, const std::string& path) {
+    if (const int e = pwrite_piece(fd, p)) checkpoint_fail(path, "write failed", e);
+}
+
+inline void pread_all(int fd, void* dst, std::size_t bytes, std::uint64_t offset, const std::string& path) {
+    unsigned char* p = static_cast<unsigned char*>(dst);
+    while (bytes) {
+        const ssize_t n = ::pread(fd, p, std::min(bytes, checkpoint_piece_bytes), static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            checkpoint_fail(path, "read failed", errno);
+        }
+        if (n == 0) checkpoint_fail(path, "truncated");
+        p += n;
+        bytes -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+}
+
+#if GNB_RECTANGULAR_IO_URING
+
+// Just enough of io_uring, by raw system calls, to queue writes and reap them
+class io_uring_queue {
+    public:
+        explicit io_uring_queue(unsigned entries) : m_fd{-1}, m_sq{nullptr}, m_cq{nullptr}, m_sqes{nullptr}, m_pending{0} {
+            io_uring_params p;
+            std::memset(&p, 0, sizeof p);
+            m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+            if (m_fd < 0) return;
+            m_sq_bytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+            m_cq_bytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+            const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (single) m_sq_bytes = m_cq_bytes = std::max(m_sq_bytes, m_cq_bytes);
+            m_sq = map(m_sq_bytes, IORING_OFF_SQ_RING);
+            m_cq = single ? m_sq : map(m_cq_bytes, IORING_OFF_CQ_RING);
+            m_sqe_bytes = p.sq_entries * sizeof(io_uring_sqe);
+            m_sqes = static_cast<io_uring_sqe*>(map(m_sqe_bytes, IORING_OFF_SQES));
+            if (!m_sq || !m_cq || !m_sqes) return;
+
+            unsigned char* sq = static_cast<unsigned char*>(m_sq);
+            m_sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+            m_sq_mask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+            m_sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+            unsigned char* cq = static_cast<unsigned char*>(m_cq);
+            m_cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+            m_cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+            m_cq_mask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+            m_cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+            m_entries = p.sq_entries;
+        }
+        ~io_uring_queue() {
+            if (m_sqes) ::munmap(m_sqes, m_sqe_bytes);
+            if (m_cq && m_cq != m_sq) ::munmap(m_cq, m_cq_bytes);
+            if (m_sq) ::munmap(m_sq, m_sq_bytes);
+            if (m_fd >= 0) ::close(m_fd);
+        }
+        io_uring_queue(const io_uring_queue&) = delete;
+        io_uring_queue& operator=(const io_uring_queue&) = delete;
+
+        // False if the kernel (or a seccomp filter) refused
+        bool ok() const { return m_sq && m_cq && m_sqes; }
+        unsigned entries() const { return m_entries; }
+        // Prepared, but not yet taken by the kernel
+        unsigned unsubmitted() const { return m_pending; }
+
+        // The caller must keep no more than entries() writes in flight
+        void prepare_write(int fd, const checkpoint_piece& piece, std::uint64_t tag) {
+            const unsigned tail = *m_sq_tail;
+            const unsigned index = tail & m_sq_mask;
+            io_uring_sqe& s = m_sqes[index];
+            std::memset(&s, 0, sizeof s);
+            s.opcode = IORING_OP_WRITE;
+            s.fd = fd;
+            s.addr = reinterpret_cast<std::uintptr_t>(piece.data);
+            s.len = static_cast<unsigned>(piece.bytes);
+            s.off = piece.offset;
+            s.user_data = tag;
+            m_sq_array[index] = index;
+            __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+            ++m_pending;
+        }
+
+        // Submit what has been prepared, and wait for at least one completion
+        int submit_and_wait() {
+            for (;;) {
+                const long n = ::syscall(__NR_io_uring_enter, m_fd, m_pending, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (n >= 0) {
+                    m_pending -= static_cast<unsigned>(n);
+                    return 0;
+                }
+                if (errno != EINTR) return errno;
+            }
+        }
+
+        // Take the next completion, if there is one
+        bool completion(std::uint64_t& tag, int& result) {
+            const unsigned head = *m_cq_head;
+            if (head == __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE)) return false;
+            const io_uring_cqe& c = m_cqes[head & m_cq_mask];
+            tag = c.user_data;
+            result = c.res;
+            __atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+
+    private:
+        void* map(std::size_t bytes, off_t what) {
+            void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, what);
+            return p == MAP_FAILED ? nullptr : p;
+        }
+
+        int m_fd;
+        void* m_sq;
+        void* m_cq;
+        io_uring_sqe* m_sqes;
+        std::size_t m_sq_bytes, m_cq_bytes, m_sqe_bytes;
+        unsigned* m_sq_tail;
+        unsigned* m_sq_array;
+        unsigned* m_cq_head;
+        unsigned* m_cq_tail;
+        io_uring_cqe* m_cqes;
+        unsigned m_sq_mask, m_cq_mask, m_entries, m_pending;
+};
+
+// Keeps up to the queue depth of writes in flight; false if io_uring can't be used
+inline bool io_uring_write_all(int fd, std::vector<checkpoint_piece> todo, const std::string& path) {
+    io_uring_queue q{8};
+    if (!q.ok()) return false;
+    std::vector<checkpoint_piece> slots(q.entries());
+    std::vector<std::uint64_t> free_slots;
+    for (std::uint64_t s = 0; s < slots.size(); ++s) free_slots.push_back(s);
+    std::size_t next = 0, busy = 0;
+    int error = 0;
+    const char* why = "write failed";
+    // Errors are only recorded here, and thrown once nothing is in flight,
+    // as until then the kernel may still be reading the buffers
+    auto reap = [&]() -> bool {
+        bool any = false;
+        std::uint64_t s;
+        int result;
+        while (q.completion(s, result)) {
+            any = true;
+            --busy;
+            free_slots.push_back(s);
+            checkpoint_piece p = slots[s];
+            if (result == -EINTR || result == -EAGAIN) {
+                todo.push_back(p);
+            } else if (result == -EINVAL || result == -EOPNOTSUPP) {
+                // A kernel too old for IORING_OP_WRITE
+                if (!error) error = pwrite_piece(fd, p);
+            } else if (result < 0) {
+                if (!error) error = -result;
+            } else if (static_cast<std::size_t>(result) < p.bytes) {
+                p.data += result;
+                p.bytes -= static_cast<std::size_t>(result);
+                p.offset += static_cast<std::uint64_t>(result);
+                todo.push_back(p);
+            }
+        }
+        return any;
+    };
+    bool stalled = false;
+    while (busy || (next < todo.size() && !error)) {
+        while (!error && next < todo.size() && !free_slots.empty()) {
+            const std::uint64_t s = free_slots.back();
+            free_slots.pop_back();
+            slots[s] = todo[next++];
+            q.prepare_write(fd, slots[s], s);
+            ++busy;
+        }
+        if (const int e = q.submit_and_wait()) {
+            if (!error) {
+                error = e;
+                why = "io_uring_enter failed";
+            }
+            if (stalled) {
+                // Twice with nothing completing in between: what was never
+                // submitted never will be, and the rest is polled for
+                while (busy > q.unsubmitted())
+                    if (!reap()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                break;
+            }
+            stalled = true;
+        }
+        if (reap()) stalled = false;
+    }
+    if (error) checkpoint_fail(path, why, error);
+    return true;
+}
+
+#endif // GNB_RECTANGULAR_IO_URING
+
+inline void write_pieces(int fd, const std::vector<checkpoint_piece>& pieces, checkpoint_io how, const std::string& path) {
+#if GNB_RECTANGULAR_IO_URING
+    if (how == checkpoint_io::automatic && io_uring_write_all(fd, pieces, path)) return;
+#else
+    (void)how;
+#endif
+    for (const checkpoint_piece& p : pieces) pwrite_all(fd, p, path);
+}
+
+// Where the elements of a snapshot are, in row-major order
+template <typename T, class Allocator>
+void add_elements(std::vector<checkpoint_piece>& out, const rectangular<T, Allocator>& r) {
+    out.push_back(checkpoint_piece{reinterpret_cast<const unsigned char*>(r.data()), r.size() * sizeof(T), 0});
+}
+
+template <typename T, class Allocator>
+void add_elements(std::vector<checkpoint_piece>& out, const cow_rectangular<T, Allocator>& r) {
+    for (std::size_t b = 0; b < r.band_count(); ++b) {
+        const std::size_t y = b * r.band_rows(), rows = std::min(r.band_rows(), r.height() - y);
+        out.push_back(checkpoint_piece{reinterpret_cast<const unsigned char*>(r[y]), rows * r.width() * sizeof(T), 0});
+    }
+}
+
+template <typename Snapshot>
+void write_checkpoint(const std::string& path, const Snapshot& snap, checkpoint_io how) {
+    using T = typename Snapshot::value_type;
+    static_assert(std::is_trivially_copyable<T>::value, "checkpoints are for trivially copyable types");
+    std::vector<unsigned char> header(checkpoint_header_bytes);
+    const std::uint64_t fields[3] = {snap.height(), snap.width(), sizeof(T)};
+    std::memcpy(header.data(), checkpoint_magic, sizeof checkpoint_magic);
+    std::memcpy(header.data() + sizeof checkpoint_magic, fields, sizeof fields);
+
+    std::vector<checkpoint_piece> elements, pieces;
+    if (!snap.empty()) add_elements(elements, snap);
+    pieces.push_back(checkpoint_piece{header.data(), header.size(), 0});
+    // Cut into large pieces at file offsets that are multiples of the piece size
+    std::uint64_t offset = checkpoint_header_bytes;
+    for (checkpoint_piece e : elements) {
+        while (e.bytes) {
+            const std::size_t n = std::min<std::uint64_t>(e.bytes, checkpoint_piece_bytes - offset % checkpoint_piece_bytes);
+            pieces.push_back(checkpoint_piece{e.data, n, offset});
+            e.data += n;
+            e.bytes -= n;
+            offset += n;
+        }
+    }
+
+    checkpoint_fd f{checkpoint_temp_path(path), O_WRONLY | O_CREAT | O_EXCL};
+    write_pieces(f.get(), pieces, how, path);
+    f.commit(path);
+}
+
+template <typename Snapshot>
+void run_checkpoint(std::promise<void> done, std::string path, Snapshot snap, checkpoint_io how) {
+    std::exception_ptr error;
+    try {
+        write_checkpoint(path, snap, how);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    // Let go of the snapshot before the future is ready, so a cow_rectangular
+    // no longer shares any bands with it once get() returns
+    {
+        const Snapshot released{std::move(snap)};
+    }
+    if (error)
+        done.set_exception(error);
+    else
+        done.set_value();
+}
+
+template <typename Snapshot>
+std::future<void> start_checkpoint(const std::string& path, Snapshot&& snap, checkpoint_io how) {
+    using S = typename std::decay<Snapshot>::type;
+    std::promise<void> done;
+    std::future<void> f = done.get_future();
+    std::thread(run_checkpoint<S>, std::move(done), path, std::forward<Snapshot>(snap), how).detach();
+    return f;
+}
+
+} // namespace detail
+
+// Copies r, then writes the copy in the background
+template <typename T, class Allocator>
+std::future<void> save_async(const std::string& path, const rectangular<T, Allocator>& r,
+        checkpoint_io how = checkpoint_io::automatic) {
+    return detail::start_checkpoint(path, rectangular<T, Allocator>{r}, how);
+}
+
+// Takes over r's buffer, so there is no copy at all
+template <typename T, class Allocator>
+std::future<void> save_async(const std::string& path, rectangular<T, Allocator>&& r,
+        checkpoint_io how = checkpoint_io::automatic) {
+    return detail::start_checkpoint(path, std::move(r), how);
+}
+
+// Shares r's bands, which r copies as it changes them
+template <typename T, class Allocator>
+std::future<void> save_async(const std::string& path, const cow_rectangular<T, Allocator>& r,
+        checkpoint_io how = checkpoint_io::automatic) {
+    return detail::start_checkpoint(path, cow_rectangular<T, Allocator>{r}, how);
+}
+
+template <typename T, class Allocator = std::allocator<T> >
+rectangular<T, Allocator> load_checkpoint(const std::string& path) {
+    static_assert(std::is_trivially_copyable<T>::value, "checkpoints are for trivially copyable types");
+    detail::checkpoint_fd f{path, O_RDONLY};
+    char magic[sizeof detail::checkpoint_magic];
+    std::uint64_t fields[3];
+    detail::pread_all(f.get(), magic, sizeof magic, 0, path);
+    detail::pread_all(f.get(), fields, sizeof fields, sizeof magic, path);
+    if (std::memcmp(magic, detail::checkpoint_magic, sizeof magic) != 0) detail::checkpoint_fail(path, "not a checkpoint");
+    if (fields[2] != sizeof(T)) detail::checkpoint_fail(path, "element size does not match");
+    const std::size_t height = static_cast<std::size_t>(fields[0]), width = static_cast<std::size_t>(fields[1]);
+    if (width && height > std::size_t(-1) / sizeof(T) / width) detail::checkpoint_fail(path, "bad header");
+    // Before allocating, so a damaged header can't ask for more than the file holds
+    struct stat st;
+    if (::fstat(f.get(), &st) != 0) detail::checkpoint_fail(path, "cannot stat", errno);
+    const std::uint64_t file_bytes = static_cast<std::uint64_t>(st.st_size);
+    if (file_bytes < detail::checkpoint_header_bytes ||
+            std::uint64_t(height) * width * sizeof(T) > file_bytes - detail::checkpoint_header_bytes)
+        detail::checkpoint_fail(path, "truncated");
+    std::vector<T, Allocator> buf(height * width);
+    detail::pread_all(f.get(), buf.data(), buf.size() * sizeof(T), detail::checkpoint_header_bytes, path);
+    return rectangular<T, Allocator>{height, width, buf};
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_checkpoint
@@ -0,0 +1,431 @@
+#ifndef GNB_rectangular_csv
+#define GNB_rectangular_csv
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "rectangular.hpp"
+#include "rectangular_parallel.hpp"
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#   if __has_include(<charconv>)
+#       include <charconv>
+#   endif
+#endif
+#if defined(__cpp_lib_to_chars)
+#   define GNB_RECTANGULAR_CHARCONV 1
+#else
+#   define GNB_RECTANGULAR_CHARCONV 0
+#endif
+
+#if defined(__linux__)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#   define GNB_RECTANGULAR_MMAP 1
+#else
+#   define GNB_RECTANGULAR_MMAP 0
+#endif
+
+namespace gnb {
+
+/*
+ * Reading and writing numeric grids as CSV or TSV
+ *
+ * auto grid = read_csv<double>("in.csv");             // width from the first row
+ * auto counts = read_csv<int>("in.tsv", '\t', 8);     // parsed in 8 chunks at once
+ * auto small = parse_csv<float>("1,2\n3,4\n");         // from memory
+ * write_csv("out.csv", grid);
+ *
+ * Each non-blank line is a row of numbers separated by the delimiter, with
+ * optional spaces or tabs around each.  The first row sets the width and
+ * every other row must match it.  Blank lines are skipped, and lines may end
+ * in \n or \r\n.  There are no quotes or header rows: this is for numbers.
+ *
+ * Files are mmap()ed on Linux and otherwise read in one go, and numbers are
+ * parsed in place with std::from_chars when the library has it (C++17 with
+ * floating point support), or else with a hand-written integer parser and
+ * strtod() (which follows the C locale's decimal point).  With nbands > 1 the
+ * text is cut into that many chunks at line ends; the chunks count their rows
+ * in parallel, then parse them in parallel straight into the grid's buffer,
+ * which the rectangular then adopts.  Writing formats into a large buffer
+ * with std::to_chars (or by hand and snprintf()), giving the shortest text
+ * that reads back to the same value, and fwrite()s it.
+ *
+ * Files that can't be opened, malformed numbers, and rows of the wrong width
+ * throw std::runtime_error, naming the line.  Row widths are all checked
+ * before the grid is allocated.
+ */
+
+namespace detail {
+
+inline bool csv_blank(char c, char delimiter) {
+    return c != delimiter && (c == ' ' || c == '\t' || c == '\r');
+}
+
+inline const char* csv_skip_blanks(const char* p, const char* last, char delimiter) {
+    while (p != last && csv_blank(*p, delimiter)) ++p;
+    return p;
+}
+
+inline const char* csv_line_end(const char* p, const char* last) {
+    const void* nl = std::memchr(p, '\n', static_cast<std::size_t>(last - p));
+    return nl ? static_cast<const char*>(nl) : last;
+}
+
+#if GNB_RECTANGULAR_CHARCONV
+
+// Parse a number at the start of [first, last): where it ends, or nullptr
+template <typename T>
+const char* csv_parse(const char* first, const char* last, T& out) {
+    const std::from_chars_result r = std::from_chars(first, last, out);
+    return r.ec == std::errc() ? r.ptr : nullptr;
+}
+
+// Enough room for any number
+const std::size_t csv_field_max = 64;
+
+template <typename T>
+char* csv_format(char* p, T v) {
+    return std::to_chars(p, p + csv_field_max, v).ptr;
+}
+
+#else
+
+template <typename T>
+const char* csv_parse_number(const char* first, const char* last, T& out, std::true_type /* integral */) {
+    const bool negative = first != last && *first == '-';
+    if (negative) {
+        if (!std::is_signed<T>::value) return nullptr;
+        ++first;
+    }
+    // The magnitude of min() is one more than max()
+    const unsigned long long limit = static_cast<unsigned long long>(std::numeric_limits<T>::max()) + (negative ? 1 : 0);
+    unsigned long long v = 0;
+    const char* p = first;
+    for (; p != last; ++p) {
+        const unsigned d = static_cast<unsigned>(*p - '0');
+        if (d > 9) break;
+        if (v > (limit - d) / 10) return nullptr;
+        v = v * 10 + d;
+    }
+    if (p == first) return nullptr;
+    out = negative ? static_cast<T>(-static_cast<long long>(v - 1) - 1) : static_cast<T>(v);
+    return p;
+}
+
+inline void csv_strto(const char* s, char** end, float& out) { out = std::strtof(s, end); }
+inline void csv_strto(const char* s, char** end, double& out) { out = std::strtod(s, end); }
+inline void csv_strto(const char* s, char** end, long double& out) { out = std::strtold(s, end); }
+
+template <typename T>
+const char* csv_parse_number(const char* first, const char* last, T& out, std::false_type /* integral */) {
+    // strtod() wants a terminated string, and accepts more than from_chars() would
+    char buf[128];
+    const std::size_t n = std::min<std::size_t>(static_cast<std::size_t>(last - first), sizeof buf - 1);
+    if (n == 0 || *first == '+' || csv_blank(*first, '\0') || *first == '\n') return nullptr;
+    std::memcpy(buf, first, n);
+    buf[n] = '\0';
+    char* end = nullptr;
+    csv_strto(buf, &end, out);
+    return end == buf ? nullptr : first + (end - buf);
+}
+
+template <typename T>
+const char* csv_parse(const char* first, const char* last, T& out) {
+    return csv_parse_number(first, last, out, std::is_integral<T>());
+}
+
+const std::size_t csv_field_max = 64;
+
+template <typename T>
+bool csv_negative(T v, std::true_type /* signed */) { return v < 0; }
+
+template <typename T>
+bool csv_negative(T, std::false_type /* signed */) { return false; }
+
+template <typename T>
+char* csv_format_number(char* p, T v, std::true_type /* integral */) {
+    const bool negative = csv_negative(v, std::is_signed<T>());
+    unsigned long long u = static_cast<unsigned long long>(v);
+    if (negative) {
+        *p++ = '-';
+        u = 0 - u;
+    }
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + u % 10);
+        u /= 10;
+    } while (u);
+    while (n) *p++ = digits[--n];
+    return p;
+}
+
+// max_digits10 significant digits always read back exactly
+inline char* csv_format_number(char* p, double v, std::false_type /* integral */, int digits) {
+    return p + std::snprintf(p, csv_field_max, "%.*g", digits, v);
+}
+
+inline char* csv_format_number(char* p, long double v, std::false_type /* integral */, int digits) {
+    return p + std::snprintf(p, csv_field_max, "%.*Lg", digits, v);
+}
+
+template <typename T>
+char* csv_format_number(char* p, T v, std::false_type is_integral) {
+    using wide = typename std::conditional<std::is_same<T, long double>::value, long double, double>::type;
+    return csv_format_number(p, static_cast<wide>(v), is_integral, std::numeric_limits<T>::max_digits10);
+}
+
+template <typename T>
+char* csv_format(char* p, T v) {
+    return csv_format_number(p, v, std::is_integral<T>());
+}
+
+#endif // GNB_RECTANGULAR_CHARCONV
+
+// The whole of a file, mapped or read into memory
+class csv_input {
+    public:
+        explicit csv_input(const std::string& path) : m_map{nullptr}, m_size{0} {
+#if GNB_RECTANGULAR_MMAP
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) fail(path);
+            struct stat st;
+            if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+                void* p = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                    ::madvise(p, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL);
+                    m_map = p;
+                    m_size = static_cast<std::size_t>(st.st_size);
+                }
+            }
+            ::close(fd);
+            if (m_map) return;
+#endif
+            read_all(path);
+        }
+        ~csv_input() {
+#if GNB_RECTANGULAR_MMAP
+            if (m_map) ::munmap(m_map, m_size);
+#endif
+        }
+        csv_input(const csv_input&) = delete;
+        csv_input& operator=(const csv_input&) = delete;
+
+        const char* data() const { return m_map ? static_cast<const char*>(m_map) : m_buffer.data(); }
+        std::size_t size() const { return m_map ? m_size : m_buffer.size(); }
+
+    private:
+        [[noreturn]] static void fail(const std::string& path) {
+            throw std::runtime_error("rectangular csv " + path + ": cannot open");
+        }
+
+        // For pipes and the like, and where there is no mmap()
+        void read_all(const std::string& path) {
+            std::FILE* f = std::fopen(path.c_str(), "rb");
+            if (!f) fail(path);
+            const std::size_t chunk = std::size_t(1) << 20;
+            std::size_t n;
+            do {
+                const std::size_t used = m_buffer.size();
+                m_buffer.resize(used + chunk);
+                n = std::fread(&m_buffer[used], 1, chunk, f);
+                m_buffer.resize(used + n);
+            } while (n == chunk);
+            const bool bad = std::ferror(f) != 0;
+            std::fclose(f);
+            if (bad) throw std::runtime_error("rectangular csv " + path + ": read failed");
+        }
+
+        void* m_map;
+        std::size_t m_size;
+        std::vector<char> m_buffer;
+};
+
+inline bool csv_blank_line(const char* p, const char* eol) {
+    return csv_skip_blanks(p, eol, '\0') == eol;
+}
+
+[[noreturn]] inline void csv_fail(const std::string& source, std::size_t line, const std::string& why) {
+    throw std::runtime_error("rectangular csv " + source + ": line " + std::to_string(line) + ": " + why);
+}
+
+// Parse one line of exactly width numbers into out
+template <typename T>
+void csv_parse_row(const char* p, const char* eol, char delimiter, T* out, std::size_t width,
+        const std::string& source, std::size_t line) {
+    for (std::size_t x = 0;; ++x) {
+        if (x == width) csv_fail(source, line, "more than " + std::to_string(width) + " fields");
+        p = csv_skip_blanks(p, eol, delimiter);
+        const char* end = csv_parse(p, eol, out[x]);
+        if (!end) csv_fail(source, line, "bad number in field " + std::to_string(x + 1));
+        p = csv_skip_blanks(end, eol, delimiter);
+        if (p == eol) {
+            if (x + 1 != width)
+                csv_fail(source, line, std::to_string(x + 1) + " fields, expected " + std::to_string(width));
+            return;
+        }
+        if (*p != delimiter) csv_fail(source, line, "bad number in field " + std::to_string(x + 1));
+        ++p;
+    }
+}
+
+// A piece of the text starting at a line, and where it falls in the grid
+struct csv_chunk {
+    const char* first;
+    const char* last;
+    std::size_t rows, lines;              // counted in the first pass
+    std::size_t bad_line, bad_fields;     // the first row of the wrong width, from 1, or 0
+    std::size_t first_row, first_line;    // totals of the chunks before
+};
+
+template <typename T>
+rectangular<T> parse_csv_text(const char* text, std::size_t size, char delimiter, unsigned nbands,
+        const std::string& source) {
+    static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "CSV is for numeric types");
+    const char* const last = text + size;
+
+    // The first non-blank line sets the width
+    const char* p = text;
+    const char* eol = csv_line_end(p, last);
+    while (p != last && csv_blank_line(p, eol)) {
+        p = eol == last ? last : eol + 1;
+        eol = csv_line_end(p, last);
+    }
+    if (p == last) return rectangular<T>{};
+    const std::size_t width = static_cast<std::size_t>(std::count(p, eol, delimiter)) + 1;
+
+    // Cut into chunks at line ends
+    if (nbands == 0) nbands = 1;
+    std::vector<csv_chunk> chunks(nbands);
+    const char* start = text;
+    for (unsigned k = 0; k < nbands; ++k) {
+        const char* end = text + static_cast<std::size_t>(static_cast<unsigned long long>(size) * (k + 1) / nbands);
+        if (end < start) end = start;
+        if (end != last && end != text && end[-1] != '\n') {
+            end = csv_line_end(end, last);
+            if (end != last) ++end;
+        }
+        chunks[k] = csv_chunk{start, end, 0, 0, 0, 0, 0, 0};
+        start = end;
+    }
+
+    // Count the rows in each chunk, and check their widths before the grid
+    // is allocated, then see where they go
+    parallel_row_bands(nbands, nbands, [&](unsigned, row_band band) {
+        for (std::size_t k = band.begin; k < band.end; ++k) {
+            csv_chunk& c = chunks[k];
+            for (const char* q = c.first; q != c.last;) {
+                const char* e = csv_line_end(q, c.last);
+                ++c.lines;
+                if (!csv_blank_line(q, e)) {
+                    ++c.rows;
+                    const std::size_t fields = static_cast<std::size_t>(std::count(q, e, delimiter)) + 1;
+                    if (fields != width && !c.bad_line) {
+                        c.bad_line = c.lines;
+                        c.bad_fields = fields;
+                    }
+                }
+                q = e == c.last ? e : e + 1;
+            }
+        }
+    });
+    std::size_t height = 0, lines = 0;
+    for (csv_chunk& c : chunks) {
+        if (c.bad_line) {
+            const std::string w = std::to_string(width);
+            csv_fail(source, lines + c.bad_line, c.bad_fields > width ? "more than " + w + " fields" :
+                    std::to_string(c.bad_fields) + " fields, expected " + w);
+        }
+        c.first_row = height;
+        c.first_line = lines;
+        height += c.rows;
+        lines += c.lines;
+    }
+
+    std::vector<T> buf(height * width);
+    parallel_row_bands(nbands, nbands, [&](unsigned, row_band band) {
+        for (std::size_t k = band.begin; k < band.end; ++k) {
+            const csv_chunk& c = chunks[k];
+            T* out = buf.data() + c.first_row * width;
+            std::size_t line = c.first_line;
+            for (const char* q = c.first; q != c.last;) {
+                const char* e = csv_line_end(q, c.last);
+                ++line;
+                if (!csv_blank_line(q, e)) {
+                    csv_parse_row(q, e, delimiter, out, width, source, line);
+                    out += width;
+                }
+                q = e == c.last ? e : e + 1;
+            }
+        }
+    });
+    return rectangular<T>{height, width, buf};
+}
+
+} // namespace detail
+
+// Parse CSV held in memory
+template <typename T>
+rectangular<T> parse_csv(const std::string& text, char delimiter = ',', unsigned nbands = 1) {
+    return detail::parse_csv_text<T>(text.data(), text.size(), delimiter, nbands, "text");
+}
+
+template <typename T>
+rectangular<T> read_csv(const std::string& path, char delimiter = ',', unsigned nbands = 1) {
+    const detail::csv_input in{path};
+    return detail::parse_csv_text<T>(in.data(), in.size(), delimiter, nbands, path);
+}
+
+template <typename T, class Allocator>
+void write_csv(const std::string& path, const rectangular<T, Allocator>& r, char delimiter = ',') {
+    static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "CSV is for numeric types");
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) throw std::runtime_error("rectangular csv " + path + ": cannot open");
+    std::vector<char> buf(std::size_t(1) << 20);
+    char* const flush_at = buf.data() + buf.size() - detail::csv_field_max - 2;
+    char* p = buf.data();
+    bool ok = true;
+    for (std::size_t y = 0; y < r.height() && ok; ++y) {
+        const T* row = r.data() + y * r.width();
+        for (std::size_t x = 0; x < r.width(); ++x) {
+            if (p > flush_at) {
+                ok = std::fwrite(buf.data(), 1, static_cast<std::size_t>(p - buf.data()), f) == static_cast<std::size_t>(p - buf.data());
+                p = buf.data();
+            }
+            p = detail::csv_format(p, row[x]);
+            *p++ = x + 1 == r.width() ? '\n' : delimiter;
+        }
+    }
+    const std::size_t n = static_cast<std::size_t>(p - buf.data());
+    if (ok && n) ok = std::fwrite(buf.data(), 1, n, f) == n;
+    if (std::fclose(f) != 0) ok = false;
+    if (!ok) throw std::runtime_error("rectangular csv " + path + ": write failed");
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_csv
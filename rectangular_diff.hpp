@@ -0,0 +1,271 @@
+#ifndef GNB_rectangular_diff
+#define GNB_rectangular_diff
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "rectangular.hpp"
+#include "rectangular_region.hpp"
+#include "rectangular_simd.hpp"
+
+namespace gnb {
+
+/*
+ * Finding what changed between two grids of the same shape
+ *
+ * for (const region& r : diff(before, after)) redraw(r);
+ *
+ * auto delta = make_changeset(before, after);   // runs of changed cells and their new values
+ * apply_changeset(replica, delta);              // replica now matches after
+ *
+ * diff() returns one region per run of consecutive rows that have changes,
+ * as wide as the changes within those rows.  A changeset is a list of runs
+ * of cells, by row-major index, plus the new values of all of them in order.
+ * Runs separated by only a few unchanged cells are joined, when sending those
+ * cells costs less than another run.
+ *
+ * Arithmetic, enum and pointer types are compared by their bytes, 16 or 32 at
+ * a time with SSE2 or AVX2, so for floating point 0.0 and -0.0 differ and a
+ * NaN is unchanged if its bits are: what a replica needs.  Other types,
+ * including long double with its padding bytes, use operator==.
+ *
+ * Grids of different shapes throw std::out_of_range, as does a changeset
+ * that does not fit the grid it is applied to, in which case the grid is
+ * not changed.
+ */
+
+// Cells [index, index + count) in row-major order
+struct change_run {
+    std::size_t index, count;
+};
+
+template <typename T>
+struct changeset {
+    std::size_t height, width;
+    std::vector<change_run> runs;
+    std::vector<T> values; // for all the runs, in order
+
+    bool empty() const { return runs.empty(); }
+};
+
+namespace detail {
+
+// Index of the first byte where a and b differ, or n
+inline std::size_t first_diff_scalar(const unsigned char* a, const unsigned char* b, std::size_t n) {
+    std::size_t i = 0;
+    while (i < n && a[i] == b[i]) ++i;
+    return i;
+}
+
+// Index of the last byte where a and b differ, or n
+inline std::size_t last_diff_scalar(const unsigned char* a, const unsigned char* b, std::size_t n) {
+    for (std::size_t i = n; i-- > 0;)
+        if (a[i] != b[i]) return i;
+    return n;
+}
+
+#if GNB_RECTANGULAR_X86
+
+GNB_TARGET("sse2")
+inline std::size_t first_diff_sse2(const unsigned char* a, const unsigned char* b, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const unsigned same = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)))));
+        if (same != 0xffff) return i + static_cast<std::size_t>(__builtin_ctz(~same));
+    }
+    return i + first_diff_scalar(a + i, b + i, n - i);
+}
+
+GNB_TARGET("sse2")
+inline std::size_t last_diff_sse2(const unsigned char* a, const unsigned char* b, std::size_t n) {
+    std::size_t j = n;
+    for (; j >= 16; j -= 16) {
+        const unsigned same = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + j - 16)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j - 16)))));
+        if (same != 0xffff) return j - 16 + static_cast<std::size_t>(31 - __builtin_clz(~same & 0xffff));
+    }
+    const std::size_t k = last_diff_scalar(a, b, j);
+    return k == j ? n : k;
+}
+
+GNB_TARGET("avx2")
+inline std::size_t first_diff_avx2(const unsigned char* a, const unsigned char* b, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const unsigned same = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)))));
+        if (same != 0xffffffffu) return i + static_cast<std::size_t>(__builtin_ctz(~same));
+    }
+    return i + first_diff_sse2(a + i, b + i, n - i);
+}
+
+GNB_TARGET("avx2")
+inline std::size_t last_diff_avx2(const unsigned char* a, const unsigned char* b, std::size_t n) {
+    std::size_t j = n;
+    for (; j >= 32; j -= 32) {
+        const unsigned same = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + j - 32)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j - 32)))));
+        if (same != 0xffffffffu) return j - 32 + static_cast<std::size_t>(31 - __builtin_clz(~same));
+    }
+    const std::size_t k = last_diff_sse2(a, b, j);
+    return k == j ? n : k;
+}
+
+#endif // GNB_RECTANGULAR_X86
+
+using diff_fn = std::size_t (*)(const unsigned char*, const unsigned char*, std::size_t);
+
+inline diff_fn first_diff_bytes() {
+    static const dispatch_table<diff_fn> table{first_diff_scalar, GNB_SIMD_KERNEL(first_diff_sse2), nullptr,
+        GNB_SIMD_KERNEL(first_diff_avx2), nullptr};
+    return table.get();
+}
+
+inline diff_fn last_diff_bytes() {
+    static const dispatch_table<diff_fn> table{last_diff_scalar, GNB_SIMD_KERNEL(last_diff_sse2), nullptr,
+        GNB_SIMD_KERNEL(last_diff_avx2), nullptr};
+    return table.get();
+}
+
+// Types that change exactly when their bytes do; long double has padding bytes
+template <typename T>
+struct bytewise_diff : std::integral_constant<bool,
+        (std::is_arithmetic<T>::value && !std::is_same<T, long double>::value) ||
+        std::is_enum<T>::value || std::is_pointer<T>::value> {};
+
+// Searches by element: first and last return n if there is no difference
+template <typename T, bool Bytes = bytewise_diff<T>::value>
+struct diff_kernels {
+    static bool differs(const T& a, const T& b) { return std::memcmp(&a, &b, sizeof(T)) != 0; }
+    static std::size_t first(const T* a, const T* b, std::size_t n) {
+        return first_diff_bytes()(reinterpret_cast<const unsigned char*>(a), reinterpret_cast<const unsigned char*>(b),
+                n * sizeof(T)) / sizeof(T);
+    }
+    static std::size_t last(const T* a, const T* b, std::size_t n) {
+        return last_diff_bytes()(reinterpret_cast<const unsigned char*>(a), reinterpret_cast<const unsigned char*>(b),
+                n * sizeof(T)) / sizeof(T);
+    }
+};
+
+template <typename T>
+struct diff_kernels<T, false> {
+    static bool differs(const T& a, const T& b) { return !(a == b); }
+    static std::size_t first(const T* a, const T* b, std::size_t n) {
+        return static_cast<std::size_t>(std::mismatch(a, a + n, b).first - a);
+    }
+    static std::size_t last(const T* a, const T* b, std::size_t n) {
+        for (std::size_t i = n; i-- > 0;)
+            if (!(a[i] == b[i])) return i;
+        return n;
+    }
+};
+
+template <typename T, class Allocator>
+void check_same_shape(const rectangular<T, Allocator>& a, const rectangular<T, Allocator>& b) {
+    if (a.height() != b.height() || a.width() != b.width()) throw std::out_of_range("rectangular diff shape");
+}
+
+} // namespace detail
+
+// The changed cells, as one region per run of changed rows
+template <typename T, class Allocator>
+std::vector<region> diff(const rectangular<T, Allocator>& a, const rectangular<T, Allocator>& b) {
+    detail::check_same_shape(a, b);
+    using K = detail::diff_kernels<T>;
+    std::vector<region> out;
+    const std::size_t n = a.size(), w = a.width();
+    const T* pa = a.data();
+    const T* pb = b.data();
+    std::size_t pos = 0;
+    while (pos < n) {
+        // Skip unchanged cells, across rows, in one search
+        const std::size_t i = pos + K::first(pa + pos, pb + pos, n - pos);
+        if (i == n) break;
+        const std::size_t y = i / w, row = y * w;
+        const std::size_t x0 = i - row, x1 = K::last(pa + i, pb + i, w - x0) + x0;
+        if (!out.empty() && out.back().y + out.back().height == y) {
+            region& r = out.back();
+            const std::size_t left = std::min(r.x, x0), right = std::max(r.x + r.width, x1 + 1);
+            r.x = left;
+            r.width = right - left;
+            ++r.height;
+        } else {
+            out.push_back(region{y, x0, 1, x1 + 1 - x0});
+        }
+        pos = row + w;
+    }
+    return out;
+}
+
+// What to apply to from to turn it into to
+template <typename T, class Allocator>
+changeset<T> make_changeset(const rectangular<T, Allocator>& from, const rectangular<T, Allocator>& to) {
+    detail::check_same_shape(from, to);
+    using K = detail::diff_kernels<T>;
+    changeset<T> out{from.height(), from.width(), {}, {}};
+    // Join runs with fewer unchanged cells than this between them
+    const std::size_t gap = std::max<std::size_t>(1, sizeof(change_run) / sizeof(T));
+    const std::size_t n = from.size();
+    const T* a = from.data();
+    const T* b = to.data();
+    std::size_t pos = 0;
+    while (pos < n) {
+        const std::size_t start = pos + K::first(a + pos, b + pos, n - pos);
+        if (start == n) break;
+        std::size_t end = start + 1;
+        for (;;) {
+            while (end < n && K::differs(a[end], b[end])) ++end;
+            const std::size_t look = std::min(gap, n - end);
+            const std::size_t next = K::first(a + end, b + end, look);
+            if (next == look) break;
+            end += next + 1;
+        }
+        out.runs.push_back(change_run{start, end - start});
+        out.values.insert(out.values.end(), b + start, b + end);
+        pos = end;
+    }
+    return out;
+}
+
+// Write the new values into grid, which must be the shape the changeset was made for
+template <typename T, class Allocator>
+void apply_changeset(rectangular<T, Allocator>& grid, const changeset<T>& cs) {
+    if (grid.height() != cs.height || grid.width() != cs.width) throw std::out_of_range("rectangular changeset shape");
+    // Check it all first, so a bad changeset changes nothing
+    std::size_t total = 0;
+    for (const change_run& r : cs.runs) {
+        if (r.index > grid.size() || r.count > grid.size() - r.index) throw std::out_of_range("rectangular changeset run");
+        total += r.count;
+    }
+    if (total != cs.values.size()) throw std::out_of_range("rectangular changeset values");
+    const T* v = cs.values.data();
+    for (const change_run& r : cs.runs) {
+        std::copy(v, v + r.count, grid.data() + r.index);
+        v += r.count;
+    }
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_diff
@@ -0,0 +1,249 @@
+#ifndef GNB_rectangular_expr
+#define GNB_rectangular_expr
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "rectangular.hpp"
+
+namespace gnb {
+
+/*
+ * Opt-in element-wise arithmetic on same-shaped rectangulars
+ *
+ * rectangular is still not a matrix type, but it is handy to be able to write
+ *
+ * rectangular<float> out = a * k + b;   // out[y][x] = a[y][x] * k + b[y][x]
+ *
+ * The operators +, -, *, / and unary - build a lazy expression object instead
+ * of a temporary rectangular per operator.  Nothing is computed until the
+ * expression is converted to a rectangular, evaluate()d, or assign()ed into an
+ * existing one, and then it is done in a single pass over flat indexes, which
+ * the compiler can vectorise.  Shapes are checked as the expression is built,
+ * and operands that do not match throw std::out_of_range.
+ *
+ * Operands may be rectangulars (of any element type) and arithmetic scalars;
+ * arithmetic is done with the usual C++ promotions, so uint8_t + uint8_t gives
+ * int.  Expressions refer to the rectangulars they were built from, so must not
+ * outlive them or survive a resize().
+ */
+
+// CRTP base of all expression nodes
+template <typename E>
+class expression {
+    public:
+        const E& self() const { return static_cast<const E&>(*this); }
+
+        std::size_t height() const { return self().height(); }
+        std::size_t width() const { return self().width(); }
+        std::size_t size() const { return height() * width(); }
+
+        // Evaluate into a new rectangular, e.g. rectangular<float> r = a + b;
+        template <typename T, class Allocator>
+        operator rectangular<T, Allocator>() const;
+};
+
+// Leaf node, refers to the data of a rectangular
+template <typename T>
+class expr_terminal : public expression<expr_terminal<T> > {
+    public:
+        using value_type = T;
+        template <class Allocator>
+        explicit expr_terminal(const rectangular<T, Allocator>& r) :
+            m_data{r.data()}, m_height{r.height()}, m_width{r.width()} {}
+
+        const T& operator[](std::size_t i) const { return m_data[i]; }
+        std::size_t height() const { return m_height; }
+        std::size_t width() const { return m_width; }
+    private:
+        const T* m_data;
+        std::size_t m_height, m_width;
+};
+
+// Leaf node for a scalar operand, which matches any shape
+template <typename S>
+class expr_scalar {
+    public:
+        using value_type = S;
+        explicit expr_scalar(S value) : m_value{value} {}
+        S operator[](std::size_t) const { return m_value; }
+    private:
+        S m_value;
+};
+
+template <typename Op, typename L, typename R>
+class expr_binary : public expression<expr_binary<Op, L, R> > {
+    public:
+        using value_type = typename std::decay<
+            decltype(Op()(std::declval<const L&>()[0], std::declval<const R&>()[0]))>::type;
+
+        expr_binary(const L& l, const R& r) : m_l{l}, m_r{r}, m_height{0}, m_width{0} {
+            set_shape(m_l, m_r);
+        }
+
+        value_type operator[](std::size_t i) const { return Op()(m_l[i], m_r[i]); }
+        std::size_t height() const { return m_height; }
+        std::size_t width() const { return m_width; }
+
+    private:
+        template <typename A, typename B>
+        void set_shape(const expression<A>& a, const expression<B>& b) {
+            if (a.height() != b.height() || a.width() != b.width())
+                throw std::out_of_range("rectangular expression shape");
+            m_height = a.height();
+            m_width = a.width();
+        }
+        template <typename A, typename S>
+        void set_shape(const expression<A>& a, const expr_scalar<S>&) {
+            m_height = a.height();
+            m_width = a.width();
+        }
+        template <typename S, typename B>
+        void set_shape(const expr_scalar<S>&, const expression<B>& b) {
+            m_height = b.height();
+            m_width = b.width();
+        }
+
+        L m_l;
+        R m_r;
+        std::size_t m_height, m_width;
+};
+
+template <typename Op, typename E>
+class expr_unary : public expression<expr_unary<Op, E> > {
+    public:
+        using value_type = typename std::decay<decltype(Op()(std::declval<const E&>()[0]))>::type;
+
+        explicit expr_unary(const E& e) : m_e{e} {}
+
+        value_type operator[](std::size_t i) const { return Op()(m_e[i]); }
+        std::size_t height() const { return m_e.height(); }
+        std::size_t width() const { return m_e.width(); }
+    private:
+        E m_e;
+};
+
+namespace detail {
+
+struct expr_plus {
+    template <typename A, typename B>
+    auto operator()(const A& a, const B& b) const -> decltype(a + b) { return a + b; }
+};
+struct expr_minus {
+    template <typename A, typename B>
+    auto operator()(const A& a, const B& b) const -> decltype(a - b) { return a - b; }
+};
+struct expr_multiplies {
+    template <typename A, typename B>
+    auto operator()(const A& a, const B& b) const -> decltype(a * b) { return a * b; }
+};
+struct expr_divides {
+    template <typename A, typename B>
+    auto operator()(const A& a, const B& b) const -> decltype(a / b) { return a / b; }
+};
+struct expr_negate {
+    template <typename A>
+    auto operator()(const A& a) const -> decltype(-a) { return -a; }
+};
+
+// Turn anything that can appear in an expression into a node
+template <typename T, class Allocator>
+expr_terminal<T> as_operand(const rectangular<T, Allocator>& r) { return expr_terminal<T>{r}; }
+template <typename E>
+const E& as_operand(const expression<E>& e) { return e.self(); }
+template <typename S, typename = typename std::enable_if<std::is_arithmetic<S>::value>::type>
+expr_scalar<S> as_operand(const S& s) { return expr_scalar<S>{s}; }
+
+template <typename X>
+using operand_t = typename std::decay<decltype(as_operand(std::declval<const X&>()))>::type;
+
+template <typename X> struct is_scalar_operand : std::false_type {};
+template <typename S> struct is_scalar_operand<expr_scalar<S> > : std::true_type {};
+
+// At least one side of a binary operator must be a rectangular or expression
+template <typename Op, typename L, typename R>
+using binary_t = typename std::enable_if<
+        !(is_scalar_operand<operand_t<L> >::value && is_scalar_operand<operand_t<R> >::value),
+        expr_binary<Op, operand_t<L>, operand_t<R> > >::type;
+
+template <typename T, class Allocator, typename E>
+void evaluate_into(rectangular<T, Allocator>& dst, const E& e) {
+    T* out = dst.data();
+    const std::size_t n = dst.size();
+    for (std::size_t i = 0; i < n; ++i) out[i] = static_cast<T>(e[i]);
+}
+
+} // namespace detail
+
+template <typename L, typename R>
+detail::binary_t<detail::expr_plus, L, R> operator+(const L& l, const R& r) {
+    return {detail::as_operand(l), detail::as_operand(r)};
+}
+template <typename L, typename R>
+detail::binary_t<detail::expr_minus, L, R> operator-(const L& l, const R& r) {
+    return {detail::as_operand(l), detail::as_operand(r)};
+}
+template <typename L, typename R>
+detail::binary_t<detail::expr_multiplies, L, R> operator*(const L& l, const R& r) {
+    return {detail::as_operand(l), detail::as_operand(r)};
+}
+template <typename L, typename R>
+detail::binary_t<detail::expr_divides, L, R> operator/(const L& l, const R& r) {
+    return {detail::as_operand(l), detail::as_operand(r)};
+}
+
+template <typename T, class Allocator>
+expr_unary<detail::expr_negate, expr_terminal<T> > operator-(const rectangular<T, Allocator>& r) {
+    return expr_unary<detail::expr_negate, expr_terminal<T> >{expr_terminal<T>{r}};
+}
+template <typename E>
+expr_unary<detail::expr_negate, E> operator-(const expression<E>& e) {
+    return expr_unary<detail::expr_negate, E>{e.self()};
+}
+
+// Evaluate into a new rectangular of the natural element type
+template <typename E>
+rectangular<typename E::value_type> evaluate(const expression<E>& e) {
+    rectangular<typename E::value_type> r{e.height(), e.width()};
+    detail::evaluate_into(r, e.self());
+    return r;
+}
+
+/*
+ * Evaluate into an existing rectangular, re-using its buffer.
+ * dst must already be the same shape, else throws std::out_of_range.
+ * dst may also be an operand, e.g. assign(a, a * 2 + b)
+ */
+template <typename T, class Allocator, typename E>
+void assign(rectangular<T, Allocator>& dst, const expression<E>& e) {
+    if (dst.height() != e.height() || dst.width() != e.width())
+        throw std::out_of_range("rectangular expression assign shape");
+    detail::evaluate_into(dst, e.self());
+}
+
+template <typename E>
+template <typename T, class Allocator>
+expression<E>::operator rectangular<T, Allocator>() const {
+    rectangular<T, Allocator> r{height(), width()};
+    detail::evaluate_into(r, self());
+    return r;
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_expr
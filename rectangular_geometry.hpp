@@ -0,0 +1,406 @@
+#ifndef GNB_rectangular_geometry
+#define GNB_rectangular_geometry
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "rectangular.hpp"
+#include "rectangular_simd.hpp"
+
+namespace gnb {
+
+/*
+ * Rotations, flips and transpose
+ *
+ * auto t = transpose(image);     // t[x][y] == image[y][x]
+ * auto r = rotate90(image);      // clockwise, r is width() x height()
+ * auto l = rotate270(image);     // anti-clockwise
+ * rotate180(image);              // these three are in place
+ * flip_horizontal(image);        // mirror left to right
+ * flip_vertical(image);          // mirror top to bottom
+ * rotate90_in_place(image);      // in place if square, else reallocates
+ *
+ * Transposes and the 90 degree rotations work a tile at a time, so that both
+ * the rows being read and the rows being written stay in cache.  The
+ * rotations are transposes that read the source rows (rotate90) or write the
+ * destination rows (rotate270) in reverse order, so cost the same.
+ *
+ * For trivially copyable T of 1 or 4 bytes the tiles are transposed in SIMD
+ * registers, and rows are reversed with byte shuffles, picked at run time by
+ * rectangular_simd.hpp.  Other types use the same blocking with plain loops.
+ */
+
+namespace detail {
+
+/*
+ * Portable kernels: dst[x * dst_stride + y] = src[y * src_stride + x] for a
+ * rows x cols tile.  Strides are in elements, and may be negative.
+ */
+template <typename T>
+void transpose_tile_scalar(const T* src, std::ptrdiff_t src_stride, T* dst, std::ptrdiff_t dst_stride,
+        std::size_t rows, std::size_t cols) {
+    for (std::size_t y = 0; y < rows; ++y)
+        for (std::size_t x = 0; x < cols; ++x)
+            dst[static_cast<std::ptrdiff_t>(x) * dst_stride + static_cast<std::ptrdiff_t>(y)] =
+                src[static_cast<std::ptrdiff_t>(y) * src_stride + static_cast<std::ptrdiff_t>(x)];
+}
+
+template <typename T>
+void reverse_scalar(T* p, std::size_t n) {
+    std::reverse(p, p + n);
+}
+
+#if GNB_RECTANGULAR_X86
+
+/*
+ * 1-byte elements, 16x16 tiles.  Four rounds of interleaving row i with row
+ * i+8 leave the tile transposed.
+ */
+template <typename T>
+GNB_TARGET("sse2")
+void transpose16_sse2(const T* src, std::ptrdiff_t src_stride, T* dst, std::ptrdiff_t dst_stride) {
+    __m128i a[16], b[16];
+    for (int i = 0; i < 16; ++i) a[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * src_stride));
+    for (int round = 0; round < 4; ++round) {
+        for (int i = 0; i < 8; ++i) {
+            b[2 * i] = _mm_unpacklo_epi8(a[i], a[i + 8]);
+            b[2 * i + 1] = _mm_unpackhi_epi8(a[i], a[i + 8]);
+        }
+        std::copy(b, b + 16, a);
+    }
+    for (int i = 0; i < 16; ++i) _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * dst_stride), a[i]);
+}
+
+/*
+ * 4-byte elements, 8x8 tiles
+ */
+template <typename T>
+GNB_TARGET("sse2")
+void transpose4x4_sse2(const T* src, std::ptrdiff_t src_stride, T* dst, std::ptrdiff_t dst_stride) {
+    __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + src_stride));
+    __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * src_stride));
+    __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * src_stride));
+    __m128i t0 = _mm_unpacklo_epi32(r0, r1), t1 = _mm_unpackhi_epi32(r0, r1);
+    __m128i t2 = _mm_unpacklo_epi32(r2, r3), t3 = _mm_unpackhi_epi32(r2, r3);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi64(t0, t2));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dst_stride), _mm_unpackhi_epi64(t0, t2));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * dst_stride), _mm_unpacklo_epi64(t1, t3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * dst_stride), _mm_unpackhi_epi64(t1, t3));
+}
+
+template <typename T>
+GNB_TARGET("sse2")
+void transpose8_sse2(const T* src, std::ptrdiff_t src_stride, T* dst, std::ptrdiff_t dst_stride) {
+    transpose4x4_sse2(src, src_stride, dst, dst_stride);
+    transpose4x4_sse2(src + 4, src_stride, dst + 4 * dst_stride, dst_stride);
+    transpose4x4_sse2(src + 4 * src_stride, src_stride, dst + 4, dst_stride);
+    transpose4x4_sse2(src + 4 * src_stride + 4, src_stride, dst + 4 * dst_stride + 4, dst_stride);
+}
+
+template <typename T>
+GNB_TARGET("avx2")
+void transpose8_avx2(const T* src, std::ptrdiff_t src_stride, T* dst, std::ptrdiff_t dst_stride) {
+    __m256 r[8], t[8];
+    for (int i = 0; i < 8; ++i) r[i] = _mm256_loadu_ps(reinterpret_cast<const float*>(src + i * src_stride));
+    for (int i = 0; i < 8; i += 2) {
+        t[i] = _mm256_unpacklo_ps(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+    }
+    for (int i = 0; i < 8; i += 4) {
+        r[i] = _mm256_shuffle_ps(t[i], t[i + 2], 0x44);
+        r[i + 1] = _mm256_shuffle_ps(t[i], t[i + 2], 0xEE);
+        r[i + 2] = _mm256_shuffle_ps(t[i + 1], t[i + 3], 0x44);
+        r[i + 3] = _mm256_shuffle_ps(t[i + 1], t[i + 3], 0xEE);
+    }
+    for (int i = 0; i < 4; ++i) {
+        _mm256_storeu_ps(reinterpret_cast<float*>(dst + i * dst_stride), _mm256_permute2f128_ps(r[i], r[i + 4], 0x20));
+        _mm256_storeu_ps(reinterpret_cast<float*>(dst + (i + 4) * dst_stride), _mm256_permute2f128_ps(r[i], r[i + 4], 0x31));
+    }
+}
+
+/*
+ * Reverse in place by swapping vectors from each end, reversing each one
+ */
+template <typename T>
+GNB_TARGET("ssse3")
+void reverse1_ssse3(T* p, std::size_t n) {
+    const __m128i mask = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    std::size_t i = 0, j = n;
+    for (; j - i >= 32; i += 16, j -= 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + j - 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i), _mm_shuffle_epi8(b, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + j - 16), _mm_shuffle_epi8(a, mask));
+    }
+    std::reverse(p + i, p + j);
+}
+
+template <typename T>
+GNB_TARGET("avx2")
+void reverse1_avx2(T* p, std::size_t n) {
+    const __m256i mask = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                          15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    std::size_t i = 0, j = n;
+    for (; j - i >= 64; i += 32, j -= 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + j - 32));
+        // Reverse within each 128-bit lane, then swap the lanes
+        a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, mask), 0x4E);
+        b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, mask), 0x4E);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + i), b);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + j - 32), a);
+    }
+    reverse1_ssse3(p + i, j - i);
+}
+
+template <typename T>
+GNB_TARGET("sse2")
+void reverse4_sse2(T* p, std::size_t n) {
+    std::size_t i = 0, j = n;
+    for (; j - i >= 8; i += 4, j -= 4) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + j - 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i), _mm_shuffle_epi32(b, 0x1B));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + j - 4), _mm_shuffle_epi32(a, 0x1B));
+    }
+    std::reverse(p + i, p + j);
+}
+
+template <typename T>
+GNB_TARGET("avx2")
+void reverse4_avx2(T* p, std::size_t n) {
+    const __m256i idx = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    std::size_t i = 0, j = n;
+    for (; j - i >= 16; i += 8, j -= 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + j - 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + i), _mm256_permutevar8x32_epi32(b, idx));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + j - 8), _mm256_permutevar8x32_epi32(a, idx));
+    }
+    reverse4_sse2(p + i, j - i);
+}
+
+#endif // GNB_RECTANGULAR_X86
+
+/*
+ * Kernel selection by element size.  tile is the edge of the square tile
+ * transpose_tile() works on, block the edge of the cache block, which is
+ * about one cache line of elements.
+ */
+template <typename T, std::size_t Size = std::is_trivially_copyable<T>::value ? sizeof(T) : 0>
+struct geometry_kernels {
+    static constexpr std::size_t tile = 8;
+    static constexpr std::size_t block = 8;
+
+    static void transpose_tile(const T* src, std::ptrdiff_t src_stride, T* dst, std::ptrdiff_t dst_stride) {
+        transpose_tile_scalar(src, src_stride, dst, dst_stride, tile, tile);
+    }
+    static void reverse(T* p, std::size_t n) { reverse_scalar(p, n); }
+};
+
+template <typename T>
+struct geometry_kernels<T, 1> {
+    static constexpr std::size_t tile = 16;
+    static constexpr std::size_t block = 64;
+
+    static void transpose_tile(const T* src, std::ptrdiff_t src_stride, T* dst, std::ptrdiff_t dst_stride) {
+        using Fn = void (*)(const T*, std::ptrdiff_t, T*, std::ptrdiff_t);
+        static const dispatch_table<Fn> table{scalar_tile, GNB_SIMD_KERNEL(transpose16_sse2<T>), nullptr, nullptr, nullptr};
+        table.get()(src, src_stride, dst, dst_stride);
+    }
+    static void reverse(T* p, std::size_t n) {
+        static const dispatch_table<void (*)(T*, std::size_t)> table{reverse_scalar<T>,
+            nullptr, GNB_SIMD_KERNEL(reverse1_ssse3<T>), GNB_SIMD_KERNEL(reverse1_avx2<T>), nullptr};
+        table.get()(p, n);
+    }
+    private:
+        static void scalar_tile(const T* src, std::ptrdiff_t src_stride, T* dst, std::ptrdiff_t dst_stride) {
+            transpose_tile_scalar(src, src_stride, dst, dst_stride, tile, tile);
+        }
+};
+
+template <typename T>
+struct geometry_kernels<T, 4> {
+    static constexpr std::size_t tile = 8;
+    static constexpr std::size_t block = 16;
+
+    static void transpose_tile(const T* src, std::ptrdiff_t src_stride, T* dst, std::ptrdiff_t dst_stride) {
+        using Fn = void (*)(const T*, std::ptrdiff_t, T*, std::ptrdiff_t);
+        static const dispatch_table<Fn> table{scalar_tile,
+            GNB_SIMD_KERNEL(transpose8_sse2<T>), nullptr, GNB_SIMD_KERNEL(transpose8_avx2<T>), nullptr};
+        table.get()(src, src_stride, dst, dst_stride);
+    }
+    static void reverse(T* p, std::size_t n) {
+        static const dispatch_table<void (*)(T*, std::size_t)> table{reverse_scalar<T>,
+            GNB_SIMD_KERNEL(reverse4_sse2<T>), nullptr, GNB_SIMD_KERNEL(reverse4_avx2<T>), nullptr};
+        table.get()(p, n);
+    }
+    private:
+        static void scalar_tile(const T* src, std::ptrdiff_t src_stride, T* dst, std::ptrdiff_t dst_stride) {
+            transpose_tile_scalar(src, src_stride, dst, dst_stride, tile, tile);
+        }
+};
+
+template <typename T, std::size_t Size> constexpr std::size_t geometry_kernels<T, Size>::tile;
+template <typename T, std::size_t Size> constexpr std::size_t geometry_kernels<T, Size>::block;
+template <typename T> constexpr std::size_t geometry_kernels<T, 1>::tile;
+template <typename T> constexpr std::size_t geometry_kernels<T, 1>::block;
+template <typename T> constexpr std::size_t geometry_kernels<T, 4>::tile;
+template <typename T> constexpr std::size_t geometry_kernels<T, 4>::block;
+
+/*
+ * dst[x * dst_stride + y] = src[y * src_stride + x] for a rows x cols source,
+ * a cache block at a time, with full tiles done by the kernel
+ */
+template <typename T>
+void transpose_blocked(const T* src, std::ptrdiff_t src_stride, T* dst, std::ptrdiff_t dst_stride,
+        std::size_t rows, std::size_t cols) {
+    using K = geometry_kernels<T>;
+    for (std::size_t by = 0; by < rows; by += K::block) {
+        const std::size_t y_end = std::min(rows, by + K::block);
+        for (std::size_t bx = 0; bx < cols; bx += K::block) {
+            const std::size_t x_end = std::min(cols, bx + K::block);
+            for (std::size_t y = by; y < y_end; y += K::tile) {
+                const std::size_t h = std::min(K::tile, y_end - y);
+                for (std::size_t x = bx; x < x_end; x += K::tile) {
+                    const std::size_t w = std::min(K::tile, x_end - x);
+                    const T* s = src + static_cast<std::ptrdiff_t>(y) * src_stride + static_cast<std::ptrdiff_t>(x);
+                    T* d = dst + static_cast<std::ptrdiff_t>(x) * dst_stride + static_cast<std::ptrdiff_t>(y);
+                    if (h == K::tile && w == K::tile)
+                        K::transpose_tile(s, src_stride, d, dst_stride);
+                    else
+                        transpose_tile_scalar(s, src_stride, d, dst_stride, h, w);
+                }
+            }
+        }
+    }
+}
+
+// Transpose an n x n grid in place, swapping each tile above the diagonal with its mirror
+template <typename T>
+void transpose_square_in_place(T* p, std::size_t n) {
+    using K = geometry_kernels<T>;
+    const std::ptrdiff_t stride = static_cast<std::ptrdiff_t>(n);
+    std::vector<T> tmp(K::tile * K::tile);
+    const std::ptrdiff_t ts = static_cast<std::ptrdiff_t>(K::tile);
+    for (std::size_t ty = 0; ty < n; ty += K::tile) {
+        const std::size_t h = std::min(K::tile, n - ty);
+        for (std::size_t tx = ty; tx < n; tx += K::tile) {
+            const std::size_t w = std::min(K::tile, n - tx);
+            T* a = p + ty * n + tx; // above the diagonal, h x w
+            T* b = p + tx * n + ty; // its mirror, w x h
+            if (h == K::tile && w == K::tile) {
+                K::transpose_tile(a, stride, tmp.data(), ts);
+                if (a != b) K::transpose_tile(b, stride, a, stride);
+            } else {
+                transpose_tile_scalar(a, stride, tmp.data(), ts, h, w);
+                if (a != b) transpose_tile_scalar(b, stride, a, stride, w, h);
+            }
+            for (std::size_t y = 0; y < w; ++y) std::copy(tmp.data() + y * K::tile, tmp.data() + y * K::tile + h, b + y * n);
+        }
+    }
+}
+
+template <typename T, class Allocator>
+rectangular<T, Allocator> make_like(const rectangular<T, Allocator>& r, std::size_t height, std::size_t width) {
+    std::vector<T, Allocator> v(height * width, T(), r.get_allocator());
+    return rectangular<T, Allocator>{height, width, v};
+}
+
+} // namespace detail
+
+// t[x][y] == r[y][x]
+template <typename T, class Allocator>
+rectangular<T, Allocator> transpose(const rectangular<T, Allocator>& r) {
+    rectangular<T, Allocator> out = detail::make_like(r, r.width(), r.height());
+    if (!r.empty())
+        detail::transpose_blocked(r.data(), static_cast<std::ptrdiff_t>(r.width()),
+                out.data(), static_cast<std::ptrdiff_t>(out.width()), r.height(), r.width());
+    return out;
+}
+
+// Rotate clockwise, out[x][height()-1-y] == r[y][x]
+template <typename T, class Allocator>
+rectangular<T, Allocator> rotate90(const rectangular<T, Allocator>& r) {
+    rectangular<T, Allocator> out = detail::make_like(r, r.width(), r.height());
+    // Transpose with the source rows read bottom to top
+    if (!r.empty())
+        detail::transpose_blocked(r.data() + (r.height() - 1) * r.width(), -static_cast<std::ptrdiff_t>(r.width()),
+                out.data(), static_cast<std::ptrdiff_t>(out.width()), r.height(), r.width());
+    return out;
+}
+
+// Rotate anti-clockwise, out[width()-1-x][y] == r[y][x]
+template <typename T, class Allocator>
+rectangular<T, Allocator> rotate270(const rectangular<T, Allocator>& r) {
+    rectangular<T, Allocator> out = detail::make_like(r, r.width(), r.height());
+    // Transpose with the destination rows written bottom to top
+    if (!r.empty())
+        detail::transpose_blocked(r.data(), static_cast<std::ptrdiff_t>(r.width()),
+                out.data() + (out.height() - 1) * out.width(), -static_cast<std::ptrdiff_t>(out.width()),
+                r.height(), r.width());
+    return out;
+}
+
+// Mirror left to right, in place
+template <typename T, class Allocator>
+void flip_horizontal(rectangular<T, Allocator>& r) {
+    for (std::size_t y = 0; y < r.height(); ++y) detail::geometry_kernels<T>::reverse(r[y], r.width());
+}
+
+// Mirror top to bottom, in place
+template <typename T, class Allocator>
+void flip_vertical(rectangular<T, Allocator>& r) {
+    for (std::size_t y = 0, z = r.height(); y + 1 < z; ++y, --z) std::swap_ranges(r[y], r[y] + r.width(), r[z - 1]);
+}
+
+// Rotate by 180 degrees in place, which is reversing the whole buffer
+template <typename T, class Allocator>
+void rotate180(rectangular<T, Allocator>& r) {
+    detail::geometry_kernels<T>::reverse(r.data(), r.size());
+}
+
+/*
+ * Rotate clockwise in place if r is square, otherwise into a new buffer that
+ * replaces r's, so references into r are invalidated
+ */
+template <typename T, class Allocator>
+void rotate90_in_place(rectangular<T, Allocator>& r) {
+    if (r.height() != r.width()) {
+        r = rotate90(r);
+        return;
+    }
+    // Clockwise is transpose then mirror left to right
+    detail::transpose_square_in_place(r.data(), r.height());
+    flip_horizontal(r);
+}
+
+// Transpose in place if r is square, otherwise as rotate90_in_place()
+template <typename T, class Allocator>
+void transpose_in_place(rectangular<T, Allocator>& r) {
+    if (r.height() != r.width())
+        r = transpose(r);
+    else
+        detail::transpose_square_in_place(r.data(), r.height());
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_geometry
@@ -0,0 +1,247 @@
+#ifndef GNB_rectangular_hash
+#define GNB_rectangular_hash
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "rectangular.hpp"
+#include "tracked_rectangular.hpp"
+
+namespace gnb {
+
+/*
+ * Content hashing
+ *
+ * std::uint64_t h = hash(grid);               // whole grid, shape included
+ * std::unordered_map<rectangular<float>, result> cache;   // uses the same
+ *
+ * row_hasher rows;
+ * rows.rehash(grid);                          // hash every row
+ * ...change a few rows...
+ * rows.update(grid, {3, 17});                 // rehash just those
+ * rows.update(tracked);                       // or a tracked_rectangular's dirty rows
+ * rows.value();                               // hash of the whole grid
+ *
+ * hash() runs XXH64 over the raw bytes of the buffer, with the seed mixed
+ * with the height and width so that grids of different shapes but the same
+ * bytes differ.  It is only for arithmetic and enum types, whose bytes are
+ * their value (so 0.0 and -0.0 hash differently), except long double, which
+ * has padding bytes.  On little-endian machines detail::xxh64() gives the
+ * standard XXH64 values.
+ *
+ * std::hash must agree with operator==, which compares floating point by
+ * value, so for float and double grids it hashes -0.0 as 0.0 (copying the
+ * grid only if it has any -0.0 in it).  Elsewhere it is the same as hash().
+ *
+ * row_hasher keeps a hash per row, and the whole-grid value is a sum of the
+ * row hashes, each mixed with its row number, so replacing a row's hash
+ * costs O(1) and update() costs only as much as the rows it rehashes.  Its
+ * value() is not the same as hash() of the same grid.  It is up to the
+ * caller to say which rows have changed, or to use a tracked_rectangular
+ * (and clear its dirty set afterwards, as usual).  A change of shape
+ * rehashes everything.
+ */
+
+namespace detail {
+
+const std::uint64_t xxh_p1 = 11400714785074694791ULL;
+const std::uint64_t xxh_p2 = 14029467366897019727ULL;
+const std::uint64_t xxh_p3 = 1609587929392839161ULL;
+const std::uint64_t xxh_p4 = 9650029242287828579ULL;
+const std::uint64_t xxh_p5 = 2870177450012600261ULL;
+
+inline std::uint64_t xxh_rotl(std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline std::uint64_t xxh_read64(const unsigned char* p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof v);
+    return v;
+}
+
+inline std::uint32_t xxh_read32(const unsigned char* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof v);
+    return v;
+}
+
+inline std::uint64_t xxh_round(std::uint64_t acc, std::uint64_t input) {
+    return xxh_rotl(acc + input * xxh_p2, 31) * xxh_p1;
+}
+
+inline std::uint64_t xxh_merge(std::uint64_t acc, std::uint64_t v) {
+    return (acc ^ xxh_round(0, v)) * xxh_p1 + xxh_p4;
+}
+
+inline std::uint64_t xxh_avalanche(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= xxh_p2;
+    h ^= h >> 29;
+    h *= xxh_p3;
+    return h ^ (h >> 32);
+}
+
+// XXH64: four independent accumulators over 32-byte stripes, then the tail
+inline std::uint64_t xxh64(const void* data, std::size_t len, std::uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* const end = p + len;
+    std::uint64_t h;
+    if (len >= 32) {
+        std::uint64_t v1 = seed + xxh_p1 + xxh_p2, v2 = seed + xxh_p2, v3 = seed, v4 = seed - xxh_p1;
+        for (; end - p >= 32; p += 32) {
+            v1 = xxh_round(v1, xxh_read64(p));
+            v2 = xxh_round(v2, xxh_read64(p + 8));
+            v3 = xxh_round(v3, xxh_read64(p + 16));
+            v4 = xxh_round(v4, xxh_read64(p + 24));
+        }
+        h = xxh_rotl(v1, 1) + xxh_rotl(v2, 7) + xxh_rotl(v3, 12) + xxh_rotl(v4, 18);
+        h = xxh_merge(h, v1);
+        h = xxh_merge(h, v2);
+        h = xxh_merge(h, v3);
+        h = xxh_merge(h, v4);
+    } else {
+        h = seed + xxh_p5;
+    }
+    h += len;
+    for (; end - p >= 8; p += 8) h = xxh_rotl(h ^ xxh_round(0, xxh_read64(p)), 27) * xxh_p1 + xxh_p4;
+    if (end - p >= 4) {
+        h = xxh_rotl(h ^ (xxh_read32(p) * xxh_p1), 23) * xxh_p2 + xxh_p3;
+        p += 4;
+    }
+    for (; p < end; ++p) h = xxh_rotl(h ^ (*p * xxh_p5), 11) * xxh_p1;
+    return xxh_avalanche(h);
+}
+
+template <typename T>
+struct hashable : std::integral_constant<bool,
+        (std::is_arithmetic<T>::value && !std::is_same<T, long double>::value) || std::is_enum<T>::value> {};
+
+inline std::uint64_t shape_seed(std::uint64_t seed, std::size_t height, std::size_t width) {
+    return seed ^ xxh_avalanche(height * xxh_p1 + width * xxh_p2 + xxh_p5);
+}
+
+} // namespace detail
+
+template <typename T, class Allocator>
+std::uint64_t hash(const rectangular<T, Allocator>& r, std::uint64_t seed = 0) {
+    static_assert(detail::hashable<T>::value, "rectangular hashing is for arithmetic (but not long double) and enum types");
+    return detail::xxh64(r.data(), r.size() * sizeof(T), detail::shape_seed(seed, r.height(), r.width()));
+}
+
+namespace detail {
+
+// Equal grids, by operator==, hash the same
+template <typename T, class Allocator>
+std::uint64_t equality_hash(const rectangular<T, Allocator>& r, std::false_type /* floating point */) {
+    return hash(r);
+}
+
+template <typename T, class Allocator>
+std::uint64_t equality_hash(const rectangular<T, Allocator>& r, std::true_type /* floating point */) {
+    const T* p = r.data();
+    if (std::none_of(p, p + r.size(), [](T v) { return v == 0 && std::signbit(v); })) return hash(r);
+    rectangular<T, Allocator> canonical{r};
+    for (T& v : canonical)
+        if (v == 0) v = 0;
+    return hash(canonical);
+}
+
+} // namespace detail
+
+class row_hasher {
+    public:
+        explicit row_hasher(std::uint64_t seed = 0) : m_seed{seed}, m_width{0}, m_sum{0} {}
+
+        // Hash every row of r
+        template <typename T, class Allocator>
+        std::uint64_t rehash(const rectangular<T, Allocator>& r) {
+            static_assert(detail::hashable<T>::value, "rectangular hashing is for arithmetic (but not long double) and enum types");
+            m_rows.assign(r.height(), 0);
+            m_width = r.width();
+            m_sum = 0;
+            for (std::size_t y = 0; y < r.height(); ++y) {
+                m_rows[y] = hash_row(r.data() + y * r.width(), r.width());
+                m_sum += term(y, m_rows[y]);
+            }
+            return value();
+        }
+
+        // Rehash the given rows of r, or all of them if its shape has changed
+        template <typename T, class Allocator>
+        std::uint64_t update(const rectangular<T, Allocator>& r, const std::vector<std::size_t>& rows) {
+            if (r.height() != m_rows.size() || r.width() != m_width) return rehash(r);
+            for (std::size_t y : rows)
+                if (y >= m_rows.size()) throw std::out_of_range("rectangular row_hasher row");
+            for (std::size_t y : rows) {
+                const std::uint64_t h = hash_row(r.data() + y * r.width(), r.width());
+                m_sum += term(y, h) - term(y, m_rows[y]);
+                m_rows[y] = h;
+            }
+            return value();
+        }
+
+        // Rehash the rows t has marked dirty; does not clear them
+        template <typename T, class Allocator>
+        std::uint64_t update(const tracked_rectangular<T, Allocator>& t) {
+            return update(t.contents(), t.dirty_rows());
+        }
+
+        std::uint64_t value() const {
+            return detail::xxh_avalanche(m_sum ^ detail::shape_seed(m_seed, m_rows.size(), m_width));
+        }
+
+        std::uint64_t row_hash(std::size_t y) const { return m_rows.at(y); }
+        std::size_t height() const { return m_rows.size(); }
+        std::size_t width() const { return m_width; }
+
+    private:
+        template <typename T>
+        std::uint64_t hash_row(const T* row, std::size_t width) const {
+            return detail::xxh64(row, width * sizeof(T), m_seed);
+        }
+
+        // Each row's share of the sum depends on where it is
+        static std::uint64_t term(std::size_t y, std::uint64_t h) {
+            return detail::xxh_avalanche(h + (y + 1) * detail::xxh_p3);
+        }
+
+        std::uint64_t m_seed;
+        std::size_t m_width;
+        std::uint64_t m_sum;
+        std::vector<std::uint64_t> m_rows;
+};
+
+} // namespace gnb
+
+namespace std {
+
+// So rectangulars of arithmetic types can be keys of unordered containers
+template <typename T, class Allocator>
+struct hash<gnb::rectangular<T, Allocator> > {
+    std::size_t operator()(const gnb::rectangular<T, Allocator>& r) const {
+        return static_cast<std::size_t>(gnb::detail::equality_hash(r, std::is_floating_point<T>()));
+    }
+};
+
+} // namespace std
+
+#endif // GNB_rectangular_hash
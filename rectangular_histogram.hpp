@@ -0,0 +1,205 @@
+#ifndef GNB_rectangular_histogram
+#define GNB_rectangular_histogram
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "rectangular.hpp"
+#include "rectangular_parallel.hpp"
+#include "rectangular_simd.hpp"
+
+namespace gnb {
+
+/*
+ * Histograms and lookup tables for rectangular<uint8_t> and <uint16_t>
+ *
+ * auto counts = histogram(image);     // std::vector<uint64_t>, 256 or 65536 bins
+ * std::vector<uint8_t> lut(256);      // e.g. a contrast stretch
+ * apply_lut(image, lut);              // image[y][x] = lut[image[y][x]]
+ *
+ * histogram() counts into several sub-histograms, taking consecutive pixels
+ * in turn, and adds them up at the end.  With a single table, a run of equal
+ * pixels makes each increment wait for the store of the one before; with
+ * four (two for uint16_t, whose tables are bigger and collisions rarer) the
+ * increments are independent.  The tables are kept per thread between calls,
+ * and a grid with fewer pixels than bins only clears the entries it used.
+ *
+ * For uint8_t, apply_lut() looks up 16 or 32 pixels at a time with pshufb:
+ * the table is held as 16 registers of 16 entries, the low nibble of each
+ * pixel picks the entry within each, and the high nibble picks the register.
+ * uint16_t uses plain loads, as a gather of 16-bit entries is no faster.
+ * apply_lut() throws std::out_of_range unless the table has 256 or 65536
+ * entries.
+ *
+ * Both take an optional band count, as for parallel_row_bands(): each band
+ * gets its own histogram, which are merged at the end, or its own rows to
+ * transform.
+ */
+
+namespace detail {
+
+template <typename T>
+struct histogram_traits {
+    static_assert(std::is_same<T, std::uint8_t>::value || std::is_same<T, std::uint16_t>::value,
+            "histograms are for rectangular<uint8_t> and rectangular<uint16_t>");
+    static const std::size_t bins = std::size_t(1) << (8 * sizeof(T));
+    static const std::size_t subs = sizeof(T) == 1 ? 4 : 2;
+};
+
+// Add the counts of p[0 .. n) to out[bins]
+template <typename T>
+void histogram_add(const T* p, std::size_t n, std::uint64_t* out) {
+    const std::size_t bins = histogram_traits<T>::bins, subs = histogram_traits<T>::subs;
+    // One per thread, left zeroed after each use, so that each call neither
+    // allocates nor clears all of it (512KiB for uint16_t)
+    static thread_local std::vector<std::uint32_t> counts(subs * bins);
+    std::uint32_t* c = counts.data();
+    while (n > 0) {
+        // Small enough that no 32-bit count can overflow
+        const std::size_t m = std::min<std::size_t>(n, std::uint32_t(-1));
+        std::size_t i = 0;
+        for (; i + subs <= m; i += subs)
+            for (std::size_t s = 0; s < subs; ++s) ++c[s * bins + p[i + s]];
+        for (; i < m; ++i) ++c[p[i]];
+        if (m < bins) {
+            // Fewer pixels than bins: visit just the bins they hit, zeroing
+            // each as it is added so repeats add nothing
+            for (i = 0; i < m; ++i)
+                for (std::size_t s = 0; s < subs; ++s) {
+                    std::uint32_t& k = c[s * bins + p[i]];
+                    out[p[i]] += k;
+                    k = 0;
+                }
+        } else {
+            for (std::size_t s = 0; s < subs; ++s)
+                for (std::size_t b = 0; b < bins; ++b) out[b] += c[s * bins + b];
+            std::fill(counts.begin(), counts.end(), 0);
+        }
+        p += m;
+        n -= m;
+    }
+}
+
+template <typename T>
+void lut_scalar(T* p, std::size_t n, const T* lut) {
+    for (std::size_t i = 0; i < n; ++i) p[i] = lut[p[i]];
+}
+
+#if GNB_RECTANGULAR_X86
+
+GNB_TARGET("ssse3")
+inline void lut_u8_ssse3(std::uint8_t* p, std::size_t n, const std::uint8_t* lut) {
+    __m128i table[16];
+    for (int t = 0; t < 16; ++t) table[t] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut + 16 * t));
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        const __m128i lo = _mm_and_si128(v, nibble);
+        const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+        __m128i out = _mm_setzero_si128();
+        for (int t = 0; t < 16; ++t) {
+            const __m128i hit = _mm_cmpeq_epi8(hi, _mm_set1_epi8(static_cast<char>(t)));
+            out = _mm_or_si128(out, _mm_and_si128(hit, _mm_shuffle_epi8(table[t], lo)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i), out);
+    }
+    lut_scalar(p + i, n - i, lut);
+}
+
+GNB_TARGET("avx2")
+inline void lut_u8_avx2(std::uint8_t* p, std::size_t n, const std::uint8_t* lut) {
+    // vpshufb looks up within each 128-bit lane, so both lanes hold the table
+    __m256i table[16];
+    for (int t = 0; t < 16; ++t)
+        table[t] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lut + 16 * t)));
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        const __m256i lo = _mm256_and_si256(v, nibble);
+        const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+        __m256i out = _mm256_setzero_si256();
+        for (int t = 0; t < 16; ++t) {
+            const __m256i hit = _mm256_cmpeq_epi8(hi, _mm256_set1_epi8(static_cast<char>(t)));
+            out = _mm256_or_si256(out, _mm256_and_si256(hit, _mm256_shuffle_epi8(table[t], lo)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + i), out);
+    }
+    lut_u8_ssse3(p + i, n - i, lut);
+}
+
+#endif // GNB_RECTANGULAR_X86
+
+template <typename T>
+struct lut_kernels {
+    using lut_fn = void (*)(T*, std::size_t, const T*);
+    static lut_fn lut() { return lut_scalar<T>; }
+};
+
+template <>
+struct lut_kernels<std::uint8_t> {
+    using T = std::uint8_t;
+    using lut_fn = void (*)(T*, std::size_t, const T*);
+    static lut_fn lut() {
+        static const dispatch_table<lut_fn> table{lut_scalar<T>, nullptr,
+            GNB_SIMD_KERNEL(lut_u8_ssse3), GNB_SIMD_KERNEL(lut_u8_avx2), nullptr};
+        return table.get();
+    }
+};
+
+} // namespace detail
+
+// Counts of each value, as a vector of 256 or 65536 bins
+template <typename T, class Allocator>
+std::vector<std::uint64_t> histogram(const rectangular<T, Allocator>& r, unsigned nbands = 1) {
+    const std::size_t bins = detail::histogram_traits<T>::bins;
+    std::vector<std::uint64_t> out(bins);
+    if (nbands <= 1 || r.height() <= 1) {
+        detail::histogram_add(r.data(), r.size(), out.data());
+        return out;
+    }
+    std::vector<std::uint64_t> partial(std::size_t(nbands) * bins);
+    parallel_row_bands(r.height(), nbands, [&](unsigned k, row_band band) {
+        detail::histogram_add(r.data() + band.begin * r.width(), (band.end - band.begin) * r.width(),
+                partial.data() + k * bins);
+    });
+    for (unsigned k = 0; k < nbands; ++k)
+        for (std::size_t b = 0; b < bins; ++b) out[b] += partial[k * bins + b];
+    return out;
+}
+
+// r[y][x] = lut[r[y][x]], lut must have 256 or 65536 entries to match T
+template <typename T, class Allocator>
+void apply_lut(rectangular<T, Allocator>& r, const std::vector<T>& lut, unsigned nbands = 1) {
+    if (lut.size() != detail::histogram_traits<T>::bins) throw std::out_of_range("rectangular apply_lut table size");
+    const typename detail::lut_kernels<T>::lut_fn fn = detail::lut_kernels<T>::lut();
+    if (nbands <= 1 || r.height() <= 1) {
+        fn(r.data(), r.size(), lut.data());
+        return;
+    }
+    parallel_row_bands(r.height(), nbands, [&](unsigned, row_band band) {
+        fn(r.data() + band.begin * r.width(), (band.end - band.begin) * r.width(), lut.data());
+    });
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_histogram
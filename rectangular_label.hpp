@@ -0,0 +1,171 @@
+#ifndef GNB_rectangular_label
+#define GNB_rectangular_label
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "rectangular.hpp"
+#include "rectangular_parallel.hpp"
+#include "rectangular_region.hpp"
+
+namespace gnb {
+
+/*
+ * Connected-component labelling of a mask
+ *
+ * auto blobs = label_components(mask, connectivity::eight);
+ * blobs.labels[y][x];                 // 0 for background, else 1..count()
+ * blobs.components[label - 1].area;   // and .bounds, a region
+ *
+ * Every cell that is not T() is foreground, and foreground cells that touch
+ * (across edges for connectivity::four, edges or corners for ::eight) get the
+ * same label.  Labels are numbered in raster order of each component's first
+ * cell.
+ *
+ * This is the classic two-pass algorithm, with no recursion or queue: the
+ * first pass builds a union-find forest in the label grid itself (each cell
+ * holds its parent's index + 1, and roots are always the lowest index in
+ * their set), and the second resolves each cell to its final label in raster
+ * order and collects the statistics.  Find uses path halving.
+ *
+ * With nbands > 1 the first pass runs on horizontal strips in parallel, as
+ * for parallel_row_bands(), and the strips are then merged by joining the
+ * cells each side of every strip boundary.  The result is the same.
+ *
+ * Grids of 2^32 - 1 or more cells throw std::out_of_range.
+ */
+enum class connectivity { four, eight };
+
+struct component {
+    std::size_t area;   // number of cells
+    region bounds;      // bounding box
+};
+
+struct labelled_components {
+    rectangular<std::uint32_t> labels;
+    std::vector<component> components; // components[label - 1]
+
+    std::size_t count() const { return components.size(); }
+};
+
+namespace detail {
+
+// Union-find over the label grid: lab[i] is the index of i's parent + 1
+inline std::uint32_t uf_find(std::uint32_t* lab, std::uint32_t i) {
+    while (lab[i] - 1 != i) {
+        std::uint32_t p = lab[i] - 1;
+        lab[i] = lab[p]; // path halving
+        i = p;
+    }
+    return i;
+}
+
+// Join the sets holding a and b, the lower root becomes the root
+inline void uf_unite(std::uint32_t* lab, std::uint32_t a, std::uint32_t b) {
+    a = uf_find(lab, a);
+    b = uf_find(lab, b);
+    if (a < b)
+        lab[b] = a + 1;
+    else if (b < a)
+        lab[a] = b + 1;
+}
+
+// Join cell i of row y to its foreground neighbours in row y-1
+inline void label_join_above(std::uint32_t* lab, std::size_t y, std::size_t x, std::size_t width, connectivity conn) {
+    const std::uint32_t i = static_cast<std::uint32_t>(y * width + x), up = i - static_cast<std::uint32_t>(width);
+    if (conn == connectivity::eight && x > 0 && lab[up - 1]) uf_unite(lab, i, up - 1);
+    if (lab[up]) uf_unite(lab, i, up);
+    if (conn == connectivity::eight && x + 1 < width && lab[up + 1]) uf_unite(lab, i, up + 1);
+}
+
+// First pass over rows [begin, end), only looking at rows in the same strip
+template <typename T, class Allocator>
+void label_strip(const rectangular<T, Allocator>& mask, std::uint32_t* lab, row_band band, connectivity conn) {
+    const std::size_t w = mask.width();
+    for (std::size_t y = band.begin; y < band.end; ++y) {
+        const T* row = mask[y];
+        for (std::size_t x = 0; x < w; ++x) {
+            const std::uint32_t i = static_cast<std::uint32_t>(y * w + x);
+            if (row[x] == T()) {
+                lab[i] = 0;
+                continue;
+            }
+            lab[i] = i + 1;
+            if (x > 0 && lab[i - 1]) uf_unite(lab, i, i - 1);
+            if (y > band.begin) label_join_above(lab, y, x, w, conn);
+        }
+    }
+}
+
+} // namespace detail
+
+template <typename T, class Allocator>
+labelled_components label_components(const rectangular<T, Allocator>& mask,
+        connectivity conn = connectivity::eight, unsigned nbands = 1) {
+    if (mask.size() >= std::uint32_t(-1)) throw std::out_of_range("rectangular label_components size");
+    labelled_components out{rectangular<std::uint32_t>{mask.height(), mask.width()}, {}};
+    const std::size_t h = mask.height(), w = mask.width();
+    std::uint32_t* lab = out.labels.data();
+    if (mask.empty()) return out;
+
+    // Pass 1, in strips
+    if (nbands > h) nbands = static_cast<unsigned>(h);
+    if (nbands <= 1) {
+        nbands = 1;
+        detail::label_strip(mask, lab, row_band{0, h}, conn);
+    } else {
+        parallel_row_bands(h, nbands, [&](unsigned, row_band band) { detail::label_strip(mask, lab, band, conn); });
+        for (unsigned k = 1; k < nbands; ++k) {
+            const std::size_t y = row_band_of(h, k, nbands).begin;
+            for (std::size_t x = 0; x < w; ++x)
+                if (lab[y * w + x]) detail::label_join_above(lab, y, x, w, conn);
+        }
+    }
+
+    // Pass 2, in raster order.  Parents always have lower indexes, so have
+    // already been given their final label
+    for (std::size_t y = 0; y < h; ++y) {
+        for (std::size_t x = 0; x < w; ++x) {
+            const std::size_t i = y * w + x;
+            if (!lab[i]) continue;
+            const std::size_t parent = lab[i] - 1;
+            if (parent == i) {
+                out.components.push_back(component{0, region{y, x, 1, 1}});
+                lab[i] = static_cast<std::uint32_t>(out.components.size());
+            } else {
+                lab[i] = lab[parent];
+            }
+            component& c = out.components[lab[i] - 1];
+            ++c.area;
+            // Rows only increase, x can go either way
+            c.bounds.height = y + 1 - c.bounds.y;
+            if (x < c.bounds.x) {
+                c.bounds.width += c.bounds.x - x;
+                c.bounds.x = x;
+            } else if (x >= c.bounds.x + c.bounds.width) {
+                c.bounds.width = x + 1 - c.bounds.x;
+            }
+        }
+    }
+    return out;
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_label
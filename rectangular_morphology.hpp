@@ -0,0 +1,396 @@
+#ifndef GNB_rectangular_morphology
+#define GNB_rectangular_morphology
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "rectangular.hpp"
+#include "rectangular_simd.hpp"
+
+namespace gnb {
+
+/*
+ * Morphology with rectangular structuring elements
+ *
+ * auto thin = erode(image, 3, 5);     // minimum over a 3 high, 5 wide window
+ * auto fat = dilate(image, 3, 5);     // maximum
+ * auto clean = open(image, 3, 3);     // dilate(erode()), removes small bright spots
+ * auto filled = close(image, 3, 3);   // erode(dilate()), fills small dark holes
+ *
+ * T must be arithmetic.  The element is anchored at (height / 2, width / 2),
+ * and dilation uses its reflection, so open() and close() are true openings
+ * and closings even for even sizes.  Cells outside the grid are ignored.
+ * Element sizes of 0 throw std::out_of_range.
+ *
+ * The minimum or maximum over a window of k is found with the van Herk /
+ * Gil-Werman algorithm: the line is cut into blocks of k, running minimums
+ * are taken forwards and backwards within each block, and each window is
+ * then the minimum of one backward and one forward value.  That is three
+ * comparisons per cell whatever k is.  Rows are filtered first, then the
+ * columns, and the column pass works on whole rows at a time, so it is a
+ * series of element-wise minimums of rows; for uint8_t and float these use
+ * SSE2, AVX2 or AVX-512 through rectangular_simd.hpp.
+ *
+ * binary_erode(), binary_dilate(), binary_open() and binary_close() treat
+ * cells that are not T() as set and return a rectangular<uint8_t> of 0 and
+ * 1.  They pack each row into 64-bit words, so the row pass is O(log k) word
+ * operations per 64 cells and the column pass is ANDs or ORs of whole words.
+ */
+
+namespace detail {
+
+// The operations, with the value that leaves the other operand unchanged
+struct morph_min {
+    template <typename T> static T identity() {
+        return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+    }
+    template <typename T> static T apply(T a, T b) { return b < a ? b : a; }
+};
+
+struct morph_max {
+    template <typename T> static T identity() {
+        return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+    }
+    template <typename T> static T apply(T a, T b) { return a < b ? b : a; }
+};
+
+struct morph_and {
+    template <typename T> static T identity() { return static_cast<T>(~T(0)); }
+    template <typename T> static T apply(T a, T b) { return a & b; }
+};
+
+struct morph_or {
+    template <typename T> static T identity() { return T(0); }
+    template <typename T> static T apply(T a, T b) { return a | b; }
+};
+
+// out[i] = op(a[i], b[i]), out may be a or b
+template <typename T, class Op>
+void morph_rows_scalar(T* out, const T* a, const T* b, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) out[i] = Op::apply(a[i], b[i]);
+}
+
+#if GNB_RECTANGULAR_X86
+
+#define GNB_MORPH_ROWS_KERNEL(name, isa, T, V, lanes, load, store, vop, Op) \
+    GNB_TARGET(isa) \
+    inline void name(T* out, const T* a, const T* b, std::size_t n) { \
+        std::size_t i = 0; \
+        for (; i + lanes <= n; i += lanes) \
+            store(reinterpret_cast<V*>(out + i), \
+                    vop(load(reinterpret_cast<const V*>(a + i)), load(reinterpret_cast<const V*>(b + i)))); \
+        morph_rows_scalar<T, Op>(out + i, a + i, b + i, n - i); \
+    }
+
+GNB_MORPH_ROWS_KERNEL(min_rows_u8_sse2, "sse2", std::uint8_t, __m128i, 16, _mm_loadu_si128, _mm_storeu_si128, _mm_min_epu8, morph_min)
+GNB_MORPH_ROWS_KERNEL(max_rows_u8_sse2, "sse2", std::uint8_t, __m128i, 16, _mm_loadu_si128, _mm_storeu_si128, _mm_max_epu8, morph_max)
+GNB_MORPH_ROWS_KERNEL(min_rows_u8_avx2, "avx2", std::uint8_t, __m256i, 32, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_min_epu8, morph_min)
+GNB_MORPH_ROWS_KERNEL(max_rows_u8_avx2, "avx2", std::uint8_t, __m256i, 32, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_max_epu8, morph_max)
+GNB_MORPH_ROWS_KERNEL(min_rows_u8_avx512, "avx512f,avx512bw", std::uint8_t, __m512i, 64, _mm512_loadu_si512, _mm512_storeu_si512, _mm512_min_epu8, morph_min)
+GNB_MORPH_ROWS_KERNEL(max_rows_u8_avx512, "avx512f,avx512bw", std::uint8_t, __m512i, 64, _mm512_loadu_si512, _mm512_storeu_si512, _mm512_max_epu8, morph_max)
+
+GNB_MORPH_ROWS_KERNEL(min_rows_f32_sse2, "sse2", float, float, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_min_ps, morph_min)
+GNB_MORPH_ROWS_KERNEL(max_rows_f32_sse2, "sse2", float, float, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_max_ps, morph_max)
+GNB_MORPH_ROWS_KERNEL(min_rows_f32_avx2, "avx2", float, float, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_min_ps, morph_min)
+GNB_MORPH_ROWS_KERNEL(max_rows_f32_avx2, "avx2", float, float, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_max_ps, morph_max)
+GNB_MORPH_ROWS_KERNEL(min_rows_f32_avx512, "avx512f", float, float, 16, _mm512_loadu_ps, _mm512_storeu_ps, min_ps_avx512, morph_min)
+GNB_MORPH_ROWS_KERNEL(max_rows_f32_avx512, "avx512f", float, float, 16, _mm512_loadu_ps, _mm512_storeu_ps, max_ps_avx512, morph_max)
+
+#undef GNB_MORPH_ROWS_KERNEL
+
+#endif // GNB_RECTANGULAR_X86
+
+/*
+ * Kernel selection: the generic version is portable (and simple enough for
+ * the compiler to vectorise), uint8_t and float min and max call through a
+ * dispatch_table
+ */
+template <typename T, class Op>
+struct morph_kernels {
+    using rows_fn = void (*)(T*, const T*, const T*, std::size_t);
+    static rows_fn rows() { return morph_rows_scalar<T, Op>; }
+};
+
+#define GNB_MORPH_KERNELS(T, Op, suffix) \
+    template <> \
+    struct morph_kernels<T, Op> { \
+        using rows_fn = void (*)(T*, const T*, const T*, std::size_t); \
+        static rows_fn rows() { \
+            static const dispatch_table<rows_fn> table{morph_rows_scalar<T, Op>, GNB_SIMD_KERNEL(suffix##_sse2), \
+                nullptr, GNB_SIMD_KERNEL(suffix##_avx2), GNB_SIMD_KERNEL(suffix##_avx512)}; \
+            return table.get(); \
+        } \
+    };
+
+GNB_MORPH_KERNELS(std::uint8_t, morph_min, min_rows_u8)
+GNB_MORPH_KERNELS(std::uint8_t, morph_max, max_rows_u8)
+GNB_MORPH_KERNELS(float, morph_min, min_rows_f32)
+GNB_MORPH_KERNELS(float, morph_max, max_rows_f32)
+
+#undef GNB_MORPH_KERNELS
+
+/*
+ * One line of n values: out[x] = op of in[x - before .. x - before + k - 1],
+ * ignoring values outside the line.  p, g and h each hold n + k - 1 values.
+ */
+template <typename T, class Op>
+void vhgw_line(const T* in, T* out, std::size_t n, std::size_t k, std::size_t before, T* p, T* g, T* h) {
+    const std::size_t len = n + k - 1;
+    const T id = Op::template identity<T>();
+    std::fill(p, p + before, id);
+    std::copy(in, in + n, p + before);
+    std::fill(p + before + n, p + len, id);
+    for (std::size_t s = 0; s < len; s += k) {
+        const std::size_t e = std::min(s + k, len);
+        g[s] = p[s];
+        for (std::size_t j = s + 1; j < e; ++j) g[j] = Op::apply(g[j - 1], p[j]);
+        h[e - 1] = p[e - 1];
+        for (std::size_t j = e - 1; j-- > s;) h[j] = Op::apply(h[j + 1], p[j]);
+    }
+    for (std::size_t x = 0; x < n; ++x) out[x] = Op::apply(h[x], g[x + k - 1]);
+}
+
+/*
+ * The same down the columns of a height x width grid, a whole row at a time:
+ * dst[y] = op of src[y - before .. y - before + k - 1].  Only two blocks of
+ * running values are kept, for a strip of columns narrow enough that they
+ * stay in cache.
+ */
+template <typename T, class Op>
+void vhgw_columns(const T* src, T* dst, std::size_t height, std::size_t width, std::size_t k, std::size_t before) {
+    const typename morph_kernels<T, Op>::rows_fn rows = morph_kernels<T, Op>::rows();
+    const std::size_t len = height + k - 1;
+    std::size_t strip = (std::size_t(256) << 10) / ((2 * k + 1) * sizeof(T));
+    strip = std::min(width, std::max<std::size_t>(64, strip / 64 * 64));
+    std::vector<T> hbuf(k * strip), gbuf(k * strip), id(strip, Op::template identity<T>());
+
+    for (std::size_t x0 = 0; x0 < width; x0 += strip) {
+        const std::size_t m = std::min(strip, width - x0);
+        // Row j of the padded column strip
+        auto in = [&](std::size_t j) -> const T* {
+            return j >= before && j - before < height ? src + (j - before) * width + x0 : id.data();
+        };
+        auto out = [&](std::size_t y) { return dst + y * width + x0; };
+        for (std::size_t s = 0; s < height; s += k) {
+            // Backward values for the block [s, e), hrow(j) for row j
+            const std::size_t e = std::min(s + k, len);
+            auto hrow = [&](std::size_t j) { return hbuf.data() + (j - s) * strip; };
+            std::copy(in(e - 1), in(e - 1) + m, hrow(e - 1));
+            for (std::size_t j = e - 1; j-- > s;) rows(hrow(j), hrow(j + 1), in(j), m);
+            // The window for row s is exactly this block
+            std::copy(hrow(s), hrow(s) + m, out(s));
+
+            // Forward values for as much of the next block as the outputs need
+            const std::size_t y_end = std::min(s + k, height);
+            auto grow = [&](std::size_t j) { return gbuf.data() + (j - s - k) * strip; };
+            if (y_end - s > 1) {
+                std::copy(in(s + k), in(s + k) + m, grow(s + k));
+                for (std::size_t j = s + k + 1; j < y_end + k - 1; ++j) rows(grow(j), grow(j - 1), in(j), m);
+            }
+            for (std::size_t y = s + 1; y < y_end; ++y) rows(out(y), hrow(y), grow(y + k - 1), m);
+        }
+    }
+}
+
+template <class Op, typename T, class Allocator>
+rectangular<T, Allocator> morphology(const rectangular<T, Allocator>& src, std::size_t kh, std::size_t kw, bool reflect) {
+    if (kh == 0 || kw == 0) throw std::out_of_range("rectangular morphology element size");
+    std::vector<T, Allocator> buf(src.size(), T(), src.get_allocator());
+    rectangular<T, Allocator> out{src.height(), src.width(), buf};
+    if (src.empty()) return out;
+    const std::size_t h = src.height(), w = src.width();
+    const std::size_t before_y = reflect ? kh - 1 - kh / 2 : kh / 2;
+    const std::size_t before_x = reflect ? kw - 1 - kw / 2 : kw / 2;
+
+    if (kw == 1 && kh == 1) {
+        std::copy(src.begin(), src.end(), out.begin());
+        return out;
+    }
+    // Rows into out, or into a temporary if the columns follow
+    std::vector<T> tmp(kw > 1 && kh > 1 ? src.size() : 0);
+    const T* rows_done = src.data();
+    if (kw > 1) {
+        T* rows_out = kh > 1 ? tmp.data() : out.data();
+        std::vector<T> p(w + kw - 1), g(w + kw - 1), hb(w + kw - 1);
+        for (std::size_t y = 0; y < h; ++y)
+            vhgw_line<T, Op>(src[y], rows_out + y * w, w, kw, before_x, p.data(), g.data(), hb.data());
+        rows_done = rows_out;
+    }
+    if (kh > 1) vhgw_columns<T, Op>(rows_done, out.data(), h, w, kh, before_y);
+    return out;
+}
+
+/*
+ * Masks packed 64 cells to a word, cell x of a row in bit x % 64 of word
+ * x / 64.  Bits past the end of a row are unspecified.
+ */
+inline std::size_t bit_words(std::size_t bits) { return (bits + 63) / 64; }
+
+template <typename T, class Allocator>
+rectangular<std::uint64_t> pack_mask(const rectangular<T, Allocator>& mask) {
+    const std::size_t words = bit_words(mask.width());
+    rectangular<std::uint64_t> bits{mask.height(), words};
+    for (std::size_t y = 0; y < mask.height(); ++y) {
+        const T* row = mask[y];
+        std::uint64_t* out = bits[y];
+        for (std::size_t i = 0; i < words; ++i) {
+            const std::size_t x0 = i * 64, n = std::min<std::size_t>(64, mask.width() - x0);
+            std::uint64_t v = 0;
+            for (std::size_t b = 0; b < n; ++b) v |= std::uint64_t(row[x0 + b] != T()) << b;
+            out[i] = v;
+        }
+    }
+    return bits;
+}
+
+inline rectangular<std::uint8_t> unpack_mask(const rectangular<std::uint64_t>& bits, std::size_t width) {
+    rectangular<std::uint8_t> mask{bits.height(), width};
+    for (std::size_t y = 0; y < bits.height(); ++y) {
+        const std::uint64_t* row = bits[y];
+        std::uint8_t* out = mask[y];
+        for (std::size_t x = 0; x < width; ++x) out[x] = static_cast<std::uint8_t>((row[x / 64] >> (x % 64)) & 1);
+    }
+    return mask;
+}
+
+// Bit j of dst, for j < dst_bits, becomes bit j + d of src, or fill if that
+// is outside [0, src_bits)
+inline void shift_bits(const std::uint64_t* src, std::size_t src_bits, std::uint64_t* dst, std::size_t dst_bits,
+        std::ptrdiff_t d, bool fill) {
+    const std::uint64_t fill_word = fill ? ~std::uint64_t(0) : 0;
+    const std::ptrdiff_t src_words = static_cast<std::ptrdiff_t>(bit_words(src_bits));
+    const unsigned tail = src_bits % 64;
+    auto word = [&](std::ptrdiff_t j) -> std::uint64_t {
+        if (j < 0 || j >= src_words) return fill_word;
+        if (j + 1 < src_words || tail == 0) return src[j];
+        const std::uint64_t keep = (std::uint64_t(1) << tail) - 1;
+        return (src[j] & keep) | (fill_word & ~keep);
+    };
+    // d = q * 64 + r, 0 <= r < 64
+    const std::ptrdiff_t q = d >= 0 ? d / 64 : -((63 - d) / 64);
+    const unsigned r = static_cast<unsigned>(d - q * 64);
+    const std::size_t words = bit_words(dst_bits);
+    for (std::size_t i = 0; i < words; ++i) {
+        const std::ptrdiff_t j = static_cast<std::ptrdiff_t>(i) + q;
+        dst[i] = r ? (word(j) >> r) | (word(j + 1) << (64 - r)) : word(j);
+    }
+}
+
+/*
+ * One packed row of n cells: out bit x = op of in bits x - before ..
+ * x - before + k - 1.  The row is copied, offset by before, into cur, which
+ * is then combined with itself shifted by 1, 2, 4, ... so each bit covers a
+ * window twice as long each time, and finally by whatever is left of k.
+ * cur and tmp hold n + k - 1 bits.
+ */
+template <class Op>
+void bit_window_row(const std::uint64_t* in, std::uint64_t* out, std::size_t n, std::size_t k, std::size_t before,
+        std::uint64_t* cur, std::uint64_t* tmp) {
+    const bool fill = Op::template identity<std::uint64_t>() != 0;
+    const std::size_t len = n + k - 1, words = bit_words(len);
+    shift_bits(in, n, cur, len, -static_cast<std::ptrdiff_t>(before), fill);
+    std::size_t covered = 1;
+    while (covered < k) {
+        const std::size_t step = std::min(covered, k - covered);
+        shift_bits(cur, len, tmp, len, static_cast<std::ptrdiff_t>(step), fill);
+        for (std::size_t i = 0; i < words; ++i) cur[i] = Op::apply(cur[i], tmp[i]);
+        covered += step;
+    }
+    std::copy(cur, cur + bit_words(n), out);
+}
+
+// Packed bits of a mask width cells wide, in place
+template <class Op>
+void bit_morphology(rectangular<std::uint64_t>& bits, std::size_t width, std::size_t kh, std::size_t kw, bool reflect) {
+    if (kh == 0 || kw == 0) throw std::out_of_range("rectangular morphology element size");
+    if (bits.empty()) return;
+    const std::size_t before_y = reflect ? kh - 1 - kh / 2 : kh / 2;
+    const std::size_t before_x = reflect ? kw - 1 - kw / 2 : kw / 2;
+    const std::size_t words = bits.width();
+    if (kw > 1) {
+        std::vector<std::uint64_t> cur(bit_words(width + kw - 1)), tmp(cur.size());
+        for (std::size_t y = 0; y < bits.height(); ++y)
+            bit_window_row<Op>(bits[y], bits[y], width, kw, before_x, cur.data(), tmp.data());
+    }
+    if (kh > 1) {
+        rectangular<std::uint64_t> out{bits.height(), words};
+        vhgw_columns<std::uint64_t, Op>(bits.data(), out.data(), bits.height(), words, kh, before_y);
+        bits.swap(out);
+    }
+}
+
+} // namespace detail
+
+// Minimum over a kh high, kw wide window
+template <typename T, class Allocator>
+rectangular<T, Allocator> erode(const rectangular<T, Allocator>& src, std::size_t kh, std::size_t kw) {
+    return detail::morphology<detail::morph_min>(src, kh, kw, false);
+}
+
+// Maximum over a kh high, kw wide window (reflected)
+template <typename T, class Allocator>
+rectangular<T, Allocator> dilate(const rectangular<T, Allocator>& src, std::size_t kh, std::size_t kw) {
+    return detail::morphology<detail::morph_max>(src, kh, kw, true);
+}
+
+template <typename T, class Allocator>
+rectangular<T, Allocator> open(const rectangular<T, Allocator>& src, std::size_t kh, std::size_t kw) {
+    return dilate(erode(src, kh, kw), kh, kw);
+}
+
+template <typename T, class Allocator>
+rectangular<T, Allocator> close(const rectangular<T, Allocator>& src, std::size_t kh, std::size_t kw) {
+    return erode(dilate(src, kh, kw), kh, kw);
+}
+
+// The same for masks, bit-packed
+template <typename T, class Allocator>
+rectangular<std::uint8_t> binary_erode(const rectangular<T, Allocator>& mask, std::size_t kh, std::size_t kw) {
+    rectangular<std::uint64_t> bits = detail::pack_mask(mask);
+    detail::bit_morphology<detail::morph_and>(bits, mask.width(), kh, kw, false);
+    return detail::unpack_mask(bits, mask.width());
+}
+
+template <typename T, class Allocator>
+rectangular<std::uint8_t> binary_dilate(const rectangular<T, Allocator>& mask, std::size_t kh, std::size_t kw) {
+    rectangular<std::uint64_t> bits = detail::pack_mask(mask);
+    detail::bit_morphology<detail::morph_or>(bits, mask.width(), kh, kw, true);
+    return detail::unpack_mask(bits, mask.width());
+}
+
+template <typename T, class Allocator>
+rectangular<std::uint8_t> binary_open(const rectangular<T, Allocator>& mask, std::size_t kh, std::size_t kw) {
+    rectangular<std::uint64_t> bits = detail::pack_mask(mask);
+    detail::bit_morphology<detail::morph_and>(bits, mask.width(), kh, kw, false);
+    detail::bit_morphology<detail::morph_or>(bits, mask.width(), kh, kw, true);
+    return detail::unpack_mask(bits, mask.width());
+}
+
+template <typename T, class Allocator>
+rectangular<std::uint8_t> binary_close(const rectangular<T, Allocator>& mask, std::size_t kh, std::size_t kw) {
+    rectangular<std::uint64_t> bits = detail::pack_mask(mask);
+    detail::bit_morphology<detail::morph_or>(bits, mask.width(), kh, kw, true);
+    detail::bit_morphology<detail::morph_and>(bits, mask.width(), kh, kw, false);
+    return detail::unpack_mask(bits, mask.width());
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_morphology
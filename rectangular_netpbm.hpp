@@ -0,0 +1,353 @@
+#ifndef GNB_rectangular_netpbm
+#define GNB_rectangular_netpbm
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rectangular.hpp"
+#include "rectangular_simd.hpp"
+
+namespace gnb {
+
+/*
+ * Reading and writing Netpbm images: binary PGM (grey), PPM (colour) and
+ * PFM (floating point)
+ *
+ * write_pgm("depth.pgm", depth);                  // rectangular<uint8_t> or <uint16_t>
+ * auto img = read_pgm<std::uint8_t>("in.pgm");
+ * write_ppm("rgb.ppm", colour);                   // 3-channel pixels, e.g. rgb8 or rgb16
+ * auto heights = read_pfm<float>("terrain.pfm");  // float, or 3-float pixels
+ *
+ * Only the binary forms (P5, P6, Pf and PF) are supported.  PGM and PPM
+ * samples are 8 bits if T's channels are 1 byte (maxval 255 on writing, at
+ * most 255 on reading) and 16 bits big-endian if they are 2 bytes (maxval
+ * 65535, or 256 to 65535).  Values are not rescaled.  A PPM pixel is any
+ * trivially copyable type of three 1 or 2 byte channels in r, g, b order,
+ * and a colour PFM pixel is three floats.  PFM rows are stored bottom to
+ * top, and written little-endian.
+ *
+ * The header is parsed with stdio, not iostreams.  Reading allocates the
+ * vector once, fread()s the pixels straight into it, swaps byte order in
+ * place if needed, and hands it to the rectangular without copying.  Writing
+ * is a single fwrite() when no swap is needed, else a row at a time through
+ * a buffer.  Byte swaps use SSSE3 or AVX2 through rectangular_simd.hpp.
+ *
+ * Files that can't be opened, are malformed or truncated, or don't match T
+ * throw std::runtime_error.
+ */
+
+struct rgb8 {
+    std::uint8_t r, g, b;
+};
+
+struct rgb16 {
+    std::uint16_t r, g, b;
+};
+
+namespace detail {
+
+inline bool little_endian() {
+    const std::uint16_t one = 1;
+    unsigned char first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+inline void swap16_scalar(void* p, std::size_t n) {
+    unsigned char* b = static_cast<unsigned char*>(p);
+    for (std::size_t i = 0; i < n; ++i) std::swap(b[2 * i], b[2 * i + 1]);
+}
+
+inline void swap32_scalar(void* p, std::size_t n) {
+    unsigned char* b = static_cast<unsigned char*>(p);
+    for (std::size_t i = 0; i < n; ++i) {
+        std::swap(b[4 * i], b[4 * i + 3]);
+        std::swap(b[4 * i + 1], b[4 * i + 2]);
+    }
+}
+
+#if GNB_RECTANGULAR_X86
+
+GNB_TARGET("sse2")
+inline void swap16_sse2(void* p, std::size_t n) {
+    unsigned char* b = static_cast<unsigned char*>(p);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i* q = reinterpret_cast<__m128i*>(b + 2 * i);
+        const __m128i v = _mm_loadu_si128(q);
+        _mm_storeu_si128(q, _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+    swap16_scalar(b + 2 * i, n - i);
+}
+
+GNB_TARGET("ssse3")
+inline void swap32_ssse3(void* p, std::size_t n) {
+    unsigned char* b = static_cast<unsigned char*>(p);
+    const __m128i order = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i* q = reinterpret_cast<__m128i*>(b + 4 * i);
+        _mm_storeu_si128(q, _mm_shuffle_epi8(_mm_loadu_si128(q), order));
+    }
+    swap32_scalar(b + 4 * i, n - i);
+}
+
+GNB_TARGET("avx2")
+inline void swap16_avx2(void* p, std::size_t n) {
+    unsigned char* b = static_cast<unsigned char*>(p);
+    const __m256i order = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                           1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i* q = reinterpret_cast<__m256i*>(b + 2 * i);
+        _mm256_storeu_si256(q, _mm256_shuffle_epi8(_mm256_loadu_si256(q), order));
+    }
+    swap16_sse2(b + 2 * i, n - i);
+}
+
+GNB_TARGET("avx2")
+inline void swap32_avx2(void* p, std::size_t n) {
+    unsigned char* b = static_cast<unsigned char*>(p);
+    const __m256i order = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                           3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i* q = reinterpret_cast<__m256i*>(b + 4 * i);
+        _mm256_storeu_si256(q, _mm256_shuffle_epi8(_mm256_loadu_si256(q), order));
+    }
+    swap32_ssse3(b + 4 * i, n - i);
+}
+
+#endif // GNB_RECTANGULAR_X86
+
+using swap_fn = void (*)(void*, std::size_t);
+
+// Reverse the bytes of each of n 2-byte or 4-byte words
+inline void byte_swap(void* p, std::size_t n, std::size_t word) {
+    static const dispatch_table<swap_fn> swap16{swap16_scalar, GNB_SIMD_KERNEL(swap16_sse2), nullptr,
+        GNB_SIMD_KERNEL(swap16_avx2), nullptr};
+    static const dispatch_table<swap_fn> swap32{swap32_scalar, nullptr, GNB_SIMD_KERNEL(swap32_ssse3),
+        GNB_SIMD_KERNEL(swap32_avx2), nullptr};
+    if (word == 2)
+        swap16.get()(p, n);
+    else if (word == 4)
+        swap32.get()(p, n);
+}
+
+// Closes on destruction
+class netpbm_file {
+    public:
+        netpbm_file(const std::string& path, const char* mode) : m_path{path}, m_file{std::fopen(path.c_str(), mode)} {
+            if (!m_file) fail("cannot open");
+        }
+        ~netpbm_file() {
+            if (m_file) std::fclose(m_file);
+        }
+        netpbm_file(const netpbm_file&) = delete;
+        netpbm_file& operator=(const netpbm_file&) = delete;
+
+        [[noreturn]] void fail(const char* why) const { throw std::runtime_error("rectangular netpbm " + m_path + ": " + why); }
+
+        void write(const void* p, std::size_t n) {
+            if (n && std::fwrite(p, 1, n, m_file) != n) fail("write failed");
+        }
+        void read(void* p, std::size_t n) {
+            if (n && std::fread(p, 1, n, m_file) != n) fail("truncated");
+        }
+        void close() {
+            std::FILE* f = m_file;
+            m_file = nullptr;
+            if (std::fclose(f) != 0) fail("write failed");
+        }
+
+        // The next header token, skipping white space and # comments
+        std::string token() {
+            int c = skip_space();
+            std::string t;
+            while (c != EOF && !is_space(c) && c != '#') {
+                t += static_cast<char>(c);
+                if (t.size() > 64) fail("bad header");
+                c = std::getc(m_file);
+            }
+            if (t.empty()) fail("bad header");
+            // Exactly one white space character ends the header
+            if (c == '#') fail("bad header");
+            return t;
+        }
+
+        std::size_t number(std::size_t max) {
+            const std::string t = token();
+            if (t.find_first_not_of("0123456789") != std::string::npos) fail("bad header");
+            const unsigned long long v = std::strtoull(t.c_str(), nullptr, 10);
+            if (v == 0 || v > max) fail("bad header");
+            return static_cast<std::size_t>(v);
+        }
+
+        // Bytes after the current position, or the most there could be if it can't tell
+        std::uint64_t remaining() {
+            const long here = std::ftell(m_file);
+            if (here < 0 || std::fseek(m_file, 0, SEEK_END) != 0) return std::numeric_limits<std::uint64_t>::max();
+            const long end = std::ftell(m_file);
+            if (std::fseek(m_file, here, SEEK_SET) != 0) fail("seek failed");
+            return end > here ? static_cast<std::uint64_t>(end - here) : 0;
+        }
+
+    private:
+        static bool is_space(int c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'; }
+
+        int skip_space() {
+            int c = std::getc(m_file);
+            for (;;) {
+                if (c == '#')
+                    while (c != EOF && c != '\n' && c != '\r') c = std::getc(m_file);
+                else if (is_space(c))
+                    c = std::getc(m_file);
+                else
+                    return c;
+            }
+        }
+
+        std::string m_path;
+        std::FILE* m_file;
+};
+
+// Header then pixels, swapping words of the given size if swap is set
+template <typename T, class Allocator>
+void write_netpbm(const std::string& path, const std::string& header, const rectangular<T, Allocator>& r,
+        std::size_t word, bool swap, bool bottom_up) {
+    netpbm_file f{path, "wb"};
+    f.write(header.data(), header.size());
+    const std::size_t row_bytes = r.width() * sizeof(T);
+    if (!swap && !bottom_up) {
+        f.write(r.data(), r.size() * sizeof(T));
+    } else {
+        std::vector<unsigned char> buf(row_bytes);
+        for (std::size_t k = 0; k < r.height(); ++k) {
+            const std::size_t y = bottom_up ? r.height() - 1 - k : k;
+            std::memcpy(buf.data(), r.data() + y * r.width(), row_bytes);
+            if (swap) byte_swap(buf.data(), row_bytes / word, word);
+            f.write(buf.data(), row_bytes);
+        }
+    }
+    f.close();
+}
+
+// Reads height x width pixels into a new rectangular
+template <typename T>
+rectangular<T> read_netpbm_pixels(netpbm_file& f, std::size_t height, std::size_t width, std::size_t word,
+        bool swap, bool bottom_up) {
+    // Both dimensions are limited, so this can't overflow; check before allocating
+    if (std::uint64_t(height) * width * sizeof(T) > f.remaining()) f.fail("truncated");
+    std::vector<T> buf(height * width);
+    f.read(buf.data(), buf.size() * sizeof(T));
+    if (swap) byte_swap(buf.data(), buf.size() * sizeof(T) / word, word);
+    if (bottom_up)
+        for (std::size_t y = 0; y < height / 2; ++y)
+            std::swap_ranges(buf.begin() + y * width, buf.begin() + (y + 1) * width, buf.begin() + (height - 1 - y) * width);
+    return rectangular<T>{height, width, buf};
+}
+
+// Sizes past this are surely a corrupt header
+inline std::size_t netpbm_max_dimension() { return std::size_t(1) << 24; }
+
+// P5 or P6, with 1 or 2 byte channels
+template <std::size_t Channels, typename T, class Allocator>
+void write_pnm(const std::string& path, const char* magic, const rectangular<T, Allocator>& r) {
+    static_assert(std::is_trivially_copyable<T>::value && (sizeof(T) == Channels || sizeof(T) == 2 * Channels),
+            "netpbm pixels must have 1 or 2 byte channels");
+    const std::size_t word = sizeof(T) / Channels;
+    if (r.empty()) throw std::runtime_error("rectangular netpbm " + path + ": empty image");
+    const std::string header = std::string(magic) + "\n" + std::to_string(r.width()) + " " + std::to_string(r.height())
+        + "\n" + (word == 1 ? "255" : "65535") + "\n";
+    write_netpbm(path, header, r, word, word == 2 && little_endian(), false);
+}
+
+template <typename T, std::size_t Channels>
+rectangular<T> read_pnm(const std::string& path, const char* magic) {
+    static_assert(std::is_trivially_copyable<T>::value && (sizeof(T) == Channels || sizeof(T) == 2 * Channels),
+            "netpbm pixels must have 1 or 2 byte channels");
+    const std::size_t word = sizeof(T) / Channels;
+    netpbm_file f{path, "rb"};
+    if (f.token() != magic) f.fail("wrong format");
+    const std::size_t width = f.number(netpbm_max_dimension());
+    const std::size_t height = f.number(netpbm_max_dimension());
+    const std::size_t maxval = f.number(65535);
+    if ((maxval > 255) != (word == 2)) f.fail("sample size does not match the pixel type");
+    return read_netpbm_pixels<T>(f, height, width, word, word == 2 && little_endian(), false);
+}
+
+} // namespace detail
+
+template <typename T, class Allocator>
+void write_pgm(const std::string& path, const rectangular<T, Allocator>& r) {
+    detail::write_pnm<1>(path, "P5", r);
+}
+
+template <typename T>
+rectangular<T> read_pgm(const std::string& path) {
+    return detail::read_pnm<T, 1>(path, "P5");
+}
+
+template <typename T, class Allocator>
+void write_ppm(const std::string& path, const rectangular<T, Allocator>& r) {
+    detail::write_pnm<3>(path, "P6", r);
+}
+
+template <typename T>
+rectangular<T> read_ppm(const std::string& path) {
+    return detail::read_pnm<T, 3>(path, "P6");
+}
+
+// Pf for float, PF for three floats per pixel
+template <typename T, class Allocator>
+void write_pfm(const std::string& path, const rectangular<T, Allocator>& r) {
+    static_assert(std::is_trivially_copyable<T>::value && (sizeof(T) == sizeof(float) || sizeof(T) == 3 * sizeof(float)),
+            "PFM pixels are 1 or 3 floats");
+    if (r.empty()) throw std::runtime_error("rectangular netpbm " + path + ": empty image");
+    const std::string header = std::string(sizeof(T) == sizeof(float) ? "Pf" : "PF") + "\n" + std::to_string(r.width())
+        + " " + std::to_string(r.height()) + "\n-1.0\n";
+    detail::write_netpbm(path, header, r, 4, !detail::little_endian(), true);
+}
+
+template <typename T = float>
+rectangular<T> read_pfm(const std::string& path) {
+    static_assert(std::is_trivially_copyable<T>::value && (sizeof(T) == sizeof(float) || sizeof(T) == 3 * sizeof(float)),
+            "PFM pixels are 1 or 3 floats");
+    detail::netpbm_file f{path, "rb"};
+    if (f.token() != (sizeof(T) == sizeof(float) ? "Pf" : "PF")) f.fail("wrong format");
+    const std::size_t width = f.number(detail::netpbm_max_dimension());
+    const std::size_t height = f.number(detail::netpbm_max_dimension());
+    // The sign of the scale gives the byte order, negative for little-endian
+    const std::string scale = f.token();
+    char* end = nullptr;
+    const double s = std::strtod(scale.c_str(), &end);
+    if (*end != '\0' || s == 0.0) f.fail("bad header");
+    return detail::read_netpbm_pixels<T>(f, height, width, 4, (s < 0) != detail::little_endian(), true);
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_netpbm
@@ -0,0 +1,87 @@
+#ifndef GNB_rectangular_parallel
+#define GNB_rectangular_parallel
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace gnb {
+
+/*
+ * Split the rows of a rectangular into contiguous bands, one per thread.
+ *
+ * Everything in these headers that works in parallel over rows uses the same
+ * partitioning, so band k always covers the same rows for a given height and
+ * band count.  Construct with make_first_touch() and process with the same
+ * number of bands, and each thread's rows were first touched by the matching
+ * thread of construction.
+ */
+struct row_band {
+    std::size_t begin, end; // rows [begin, end)
+};
+
+// Band k of nbands, earlier bands get the spare rows
+inline row_band row_band_of(std::size_t height, unsigned k, unsigned nbands) {
+    std::size_t base = height / nbands, extra = height % nbands;
+    std::size_t begin = k * base + (k < extra ? k : extra);
+    return row_band{begin, begin + base + (k < extra ? 1 : 0)};
+}
+
+inline unsigned default_band_count() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+/*
+ * Call fn(k, band) for each of nbands row bands, band 0 on the calling thread
+ * and the rest on new threads, or on the calling thread too if no more
+ * threads can be started.  Empty bands are skipped, so fn is never called
+ * with begin == end.  If any call throws, the first exception (in band order)
+ * is rethrown once all threads have finished.
+ */
+template <typename Fn>
+void parallel_row_bands(std::size_t height, unsigned nbands, Fn fn) {
+    if (nbands == 0) nbands = 1;
+    if (nbands > height) nbands = height ? static_cast<unsigned>(height) : 1;
+    std::vector<std::exception_ptr> errors(nbands);
+    auto run = [&](unsigned k) {
+        row_band b = row_band_of(height, k, nbands);
+        if (b.begin == b.end) return;
+        try {
+            fn(k, b);
+        } catch (...) {
+            errors[k] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(nbands - 1);
+    unsigned k = 1;
+    try {
+        for (; k < nbands; ++k) threads.emplace_back(run, k);
+    } catch (...) {
+        // Out of threads (std::system_error): the rest run here, so those started are still joined
+    }
+    for (; k < nbands; ++k) run(k);
+    run(0);
+    for (auto& t : threads) t.join();
+    for (auto& e : errors)
+        if (e) std::rethrow_exception(e);
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_parallel
@@ -0,0 +1,361 @@
+#ifndef GNB_rectangular_path
+#define GNB_rectangular_path
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rectangular.hpp"
+#include "rectangular_label.hpp"
+
+namespace gnb {
+
+/*
+ * Distance transforms and shortest paths on grids
+ *
+ * auto d = distance_transform(obstacles);      // rectangular<float>, distance to the nearest obstacle
+ * auto d2 = squared_distance_transform(obstacles); // rectangular<double>, exact
+ *
+ * grid_pathfinder pf{costs.height(), costs.width()};
+ * if (pf.find_path(costs, {0, 0}, {99, 99}))   // A*, cell costs of 0 are walls
+ *     for (auto& p : pf.path()) ...            // (y, x) from start to goal
+ *
+ * distance_transform() is the exact Euclidean transform of Felzenszwalb and
+ * Huttenlocher: a 1-D pass down the columns (done a row at a time, so memory
+ * is read in order) then the lower envelope of parabolas along each row, so
+ * linear in the number of cells.
+ *
+ * grid_pathfinder keeps its per-cell state between queries.  Cells are
+ * numbered by their flat row-major index, and the state is stamped with a
+ * query number (as visited_grid) rather than cleared, so the cost of a
+ * query depends only on how much of the grid it explores.
+ */
+
+/*
+ * A visited flag per cell, which can be cleared in O(1)
+ *
+ * Each cell holds the epoch in which it was last visited.  clear() starts a
+ * new epoch, and only rewrites the whole grid when the 32-bit epoch wraps.
+ */
+class visited_grid {
+    public:
+        using size_type = std::size_t;
+
+        visited_grid() : visited_grid(0, 0) {}
+        visited_grid(size_type height, size_type width) : m_stamps{height, width}, m_epoch{1} {}
+
+        size_type height() const { return m_stamps.height(); }
+        size_type width() const { return m_stamps.width(); }
+
+        // Forget every visit
+        void clear() {
+            if (++m_epoch == 0) {
+                m_stamps.fill(0);
+                m_epoch = 1;
+            }
+        }
+
+        // Change the size, which also clears
+        void resize(size_type height, size_type width) {
+            m_stamps = rectangular<std::uint32_t>{height, width};
+            m_epoch = 1;
+        }
+
+        bool visited(size_type y, size_type x) const { return m_stamps[y][x] == m_epoch; }
+        // Mark (y, x) visited, returns true if it was not already
+        bool visit(size_type y, size_type x) { return visit(y * width() + x); }
+
+        // The same, by flat index y * width() + x
+        bool visited(size_type i) const { return m_stamps.data()[i] == m_epoch; }
+        bool visit(size_type i) {
+            std::uint32_t& s = m_stamps.data()[i];
+            if (s == m_epoch) return false;
+            s = m_epoch;
+            return true;
+        }
+
+    private:
+        rectangular<std::uint32_t> m_stamps;
+        std::uint32_t m_epoch;
+};
+
+namespace detail {
+
+// Squared distance to the nearest zero of f, in place, by the lower envelope of parabolas.
+// f may be infinite.  v, z and out are scratch space of at least n, n+1 and n
+inline void distance_transform_1d(double* f, std::size_t n, std::vector<std::size_t>& v, std::vector<double>& z,
+        std::vector<double>& out) {
+    const double inf = std::numeric_limits<double>::infinity();
+    std::size_t q = 0;
+    while (q < n && std::isinf(f[q])) ++q;
+    if (q == n) return; // all infinite, so stays so
+    std::size_t k = 0;
+    v[0] = q;
+    z[0] = -inf;
+    z[1] = inf;
+    for (++q; q < n; ++q) {
+        if (std::isinf(f[q])) continue;
+        // Where the parabola from q overtakes the one from v[k], z[0] is -inf so k stays >= 0
+        const double fq = f[q] + static_cast<double>(q) * static_cast<double>(q);
+        double s;
+        for (;;) {
+            const double p = static_cast<double>(v[k]);
+            s = (fq - (f[v[k]] + p * p)) / (2.0 * (static_cast<double>(q) - p));
+            if (s > z[k]) break;
+            --k;
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = inf;
+    }
+    k = 0;
+    for (q = 0; q < n; ++q) {
+        while (z[k + 1] < static_cast<double>(q)) ++k;
+        const double d = static_cast<double>(q) - static_cast<double>(v[k]);
+        out[q] = d * d + f[v[k]];
+    }
+    std::copy(out.begin(), out.begin() + n, f);
+}
+
+} // namespace detail
+
+/*
+ * Squared Euclidean distance from each cell to the nearest cell that is not
+ * T(), which is 0 for those cells, and infinity everywhere if there are none.
+ * In double, where squares stay exact far beyond any grid that fits in memory
+ */
+template <typename T, class Allocator>
+rectangular<double> squared_distance_transform(const rectangular<T, Allocator>& features) {
+    const std::size_t h = features.height(), w = features.width();
+    const double inf = std::numeric_limits<double>::infinity();
+    rectangular<double> d{h, w, inf};
+    if (d.empty()) return d;
+
+    // Down each column: distance to the nearest feature above, then below
+    for (std::size_t y = 0; y < h; ++y) {
+        const T* in = features[y];
+        double* row = d[y];
+        const double* above = y ? d[y - 1] : nullptr;
+        for (std::size_t x = 0; x < w; ++x)
+            row[x] = in[x] != T() ? 0.0 : above ? above[x] + 1.0 : inf;
+    }
+    for (std::size_t y = h - 1; y-- > 0; ) {
+        double* row = d[y];
+        const double* below = d[y + 1];
+        for (std::size_t x = 0; x < w; ++x) row[x] = std::min(row[x], below[x] + 1.0);
+    }
+
+    // Along each row, on the squared column distances
+    std::vector<std::size_t> v(w);
+    std::vector<double> z(w + 1);
+    std::vector<double> out(w);
+    for (std::size_t y = 0; y < h; ++y) {
+        double* row = d[y];
+        for (std::size_t x = 0; x < w; ++x) row[x] *= row[x];
+        detail::distance_transform_1d(row, w, v, z, out);
+    }
+    return d;
+}
+
+// Euclidean distance from each cell to the nearest cell that is not T(), rounded to float
+template <typename T, class Allocator>
+rectangular<float> distance_transform(const rectangular<T, Allocator>& features) {
+    const rectangular<double> d2 = squared_distance_transform(features);
+    rectangular<float> d{d2.height(), d2.width()};
+    std::transform(d2.begin(), d2.end(), d.begin(), [](double v) { return static_cast<float>(std::sqrt(v)); });
+    return d;
+}
+
+/*
+ * A* and Dijkstra over a grid, re-usable between queries
+ *
+ * search() is the general form, given
+ *   step(from, to, diagonal) -> float, the cost of moving between adjacent
+ *     flat indexes, negative or infinite if the move is not allowed
+ *   estimate(i) -> float, a lower bound on the cost from i to the goal,
+ *     or 0 for Dijkstra
+ * find_path() is A* on a map of integer cell costs.
+ *
+ * After a search, distance() is the cost of the best path found from the
+ * start to each cell the search settled, and path() is the route to the goal.
+ * Searching with no goal (search_all()) settles every reachable cell, which
+ * is Dijkstra's single-source shortest paths.
+ */
+class grid_pathfinder {
+    public:
+        using size_type = std::size_t;
+        using cell = std::pair<size_type, size_type>; // (y, x)
+
+        grid_pathfinder() : grid_pathfinder(0, 0) {}
+        explicit grid_pathfinder(size_type height, size_type width, connectivity conn = connectivity::eight) :
+            m_height{height}, m_width{width}, m_conn{conn}, m_seen{height, width}, m_settled{height, width},
+            m_g(height * width), m_parent(height * width), m_heap{}, m_goal{0}, m_found{false} {
+                if (height * width >= std::uint32_t(-1)) throw std::out_of_range("grid_pathfinder size");
+        }
+
+        size_type height() const { return m_height; }
+        size_type width() const { return m_width; }
+
+        template <typename Step, typename Estimate>
+        bool search(cell start, cell goal, Step step, Estimate estimate) {
+            check(goal);
+            return run(start, static_cast<std::uint32_t>(goal.first * m_width + goal.second), true, step, estimate);
+        }
+
+        template <typename Step>
+        void search_all(cell start, Step step) {
+            run(start, 0, false, step, [](std::uint32_t) { return 0.0f; });
+        }
+
+        /*
+         * A* on a map of cell costs, the cost of entering a cell, with 0 for
+         * walls.  Diagonal steps cost sqrt(2) times as much, and may not cut
+         * the corner of a wall.  T must be an integer type, so the octile
+         * distance is a lower bound.
+         */
+        template <typename T, class Allocator>
+        bool find_path(const rectangular<T, Allocator>& costs, cell start, cell goal) {
+            static_assert(std::is_integral<T>::value, "find_path() needs integer cell costs");
+            if (costs.height() != m_height || costs.width() != m_width)
+                throw std::out_of_range("grid_pathfinder find_path shape");
+            const T* c = costs.data();
+            const size_type w = m_width;
+            const float diag = std::sqrt(2.0f);
+            const float inf = std::numeric_limits<float>::infinity();
+            auto step = [c, w, diag, inf](std::uint32_t from, std::uint32_t to, bool diagonal) -> float {
+                if (c[to] == T()) return inf;
+                if (!diagonal) return static_cast<float>(c[to]);
+                // The two cells the diagonal passes between must be open
+                const size_type fy = from / w, ty = to / w;
+                if (c[fy * w + to % w] == T() || c[ty * w + from % w] == T()) return inf;
+                return static_cast<float>(c[to]) * diag;
+            };
+            const size_type gy = goal.first, gx = goal.second;
+            const bool eight = m_conn == connectivity::eight;
+            auto estimate = [w, gy, gx, diag, eight](std::uint32_t i) -> float {
+                const size_type y = i / w, x = i % w;
+                const float dy = static_cast<float>(y > gy ? y - gy : gy - y), dx = static_cast<float>(x > gx ? x - gx : gx - x);
+                if (!eight) return dy + dx;
+                return std::max(dy, dx) + (diag - 1.0f) * std::min(dy, dx);
+            };
+            return search(start, goal, step, estimate);
+        }
+
+        // Was the goal reached by the last search()
+        bool found() const { return m_found; }
+
+        // Cost of the best path from the start to (y, x), infinity if the search did not settle it
+        float distance(size_type y, size_type x) const {
+            const size_type i = y * m_width + x;
+            return m_settled.visited(i) ? m_g[i] : std::numeric_limits<float>::infinity();
+        }
+
+        // Route from the start to the goal of the last search(), empty if not found
+        std::vector<cell> path() const {
+            std::vector<cell> out;
+            if (!m_found) return out;
+            for (std::uint32_t i = m_goal; ; i = m_parent[i]) {
+                out.emplace_back(i / m_width, i % m_width);
+                if (m_parent[i] == i) break;
+            }
+            std::reverse(out.begin(), out.end());
+            return out;
+        }
+
+    private:
+        struct entry {
+            float f, g;
+            std::uint32_t i;
+            bool operator<(const entry& e) const { return f > e.f; } // min-heap
+        };
+
+        void check(cell c) const {
+            if (c.first >= m_height || c.second >= m_width) throw std::out_of_range("grid_pathfinder cell");
+        }
+
+        template <typename Step, typename Estimate>
+        bool run(cell start, std::uint32_t goal, bool has_goal, Step& step, Estimate estimate) {
+            check(start);
+            m_seen.clear();
+            m_settled.clear();
+            m_heap.clear();
+            m_goal = goal;
+            m_found = false;
+
+            const std::uint32_t s = static_cast<std::uint32_t>(start.first * m_width + start.second);
+            m_seen.visit(s);
+            m_g[s] = 0.0f;
+            m_parent[s] = s;
+            push(entry{estimate(s), 0.0f, s});
+
+            static const int dys[] = {-1, 1, 0, 0, -1, -1, 1, 1};
+            static const int dxs[] = {0, 0, -1, 1, -1, 1, -1, 1};
+            const int directions = m_conn == connectivity::eight ? 8 : 4;
+            while (!m_heap.empty()) {
+                const entry e = m_heap.front();
+                std::pop_heap(m_heap.begin(), m_heap.end());
+                m_heap.pop_back();
+                if (e.g > m_g[e.i]) continue; // stale, a better route was found since
+                m_settled.visit(e.i);
+                if (has_goal && e.i == goal) {
+                    m_found = true;
+                    return true;
+                }
+                const size_type y = e.i / m_width, x = e.i % m_width;
+                for (int d = 0; d < directions; ++d) {
+                    if ((dys[d] < 0 && y == 0) || (dys[d] > 0 && y + 1 == m_height)) continue;
+                    if ((dxs[d] < 0 && x == 0) || (dxs[d] > 0 && x + 1 == m_width)) continue;
+                    const std::uint32_t n = static_cast<std::uint32_t>(static_cast<std::ptrdiff_t>(e.i)
+                            + dys[d] * static_cast<std::ptrdiff_t>(m_width) + dxs[d]);
+                    const float c = step(e.i, n, d >= 4);
+                    if (!(c >= 0.0f) || c == std::numeric_limits<float>::infinity()) continue;
+                    const float g = e.g + c;
+                    if (m_seen.visit(n) || g < m_g[n]) {
+                        m_g[n] = g;
+                        m_parent[n] = e.i;
+                        push(entry{g + estimate(n), g, n});
+                    }
+                }
+            }
+            return false;
+        }
+
+        void push(const entry& e) {
+            m_heap.push_back(e);
+            std::push_heap(m_heap.begin(), m_heap.end());
+        }
+
+        size_type m_height, m_width;
+        connectivity m_conn;
+        visited_grid m_seen;                 // cells with a valid m_g/m_parent this query
+        visited_grid m_settled;              // cells taken off the heap, so m_g is final
+        std::vector<float> m_g;              // best cost found from the start
+        std::vector<std::uint32_t> m_parent; // previous cell on that route, the start is its own parent
+        std::vector<entry> m_heap;           // kept to re-use its capacity
+        std::uint32_t m_goal;
+        bool m_found;
+};
+
+} // namespace gnb
+
+#endif // GNB_rectangular_path
@@ -0,0 +1,460 @@
+#ifndef GNB_rectangular_reduce
+#define GNB_rectangular_reduce
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rectangular.hpp"
+#include "rectangular_simd.hpp"
+
+namespace gnb {
+
+/*
+ * Reductions over a whole rectangular, or over each row or column
+ *
+ * auto total = sum(image);          // uint64_t for rectangular<uint8_t>
+ * auto lo_hi = minmax(image);       // std::pair<T, T>
+ * auto where = argmax(image);       // std::pair (y, x) of the first maximum
+ * auto rows = row_sums(image);      // std::vector, one per row
+ * auto cols = col_sums(image);      // std::vector, one per column
+ *
+ * These work for any arithmetic T.  For uint8_t and float there are SSE2,
+ * AVX2 and AVX-512 kernels, picked at run time by rectangular_simd.hpp.  Integers are
+ * summed in a 64-bit accumulator (signed or unsigned to match T), floating
+ * point types in their own type.  The SIMD float kernels add in a different
+ * order from a simple loop, so results may differ in the last bits.
+ * minmax() and argmax() of NaNs are unspecified.
+ *
+ * col_sums() adds each row into a vector of column totals in turn, so it
+ * reads memory in order rather than striding down each column.
+ */
+template <typename T>
+using sum_type = typename std::conditional<std::is_floating_point<T>::value, T,
+        typename std::conditional<std::is_signed<T>::value, std::int64_t, std::uint64_t>::type>::type;
+
+namespace detail {
+
+/*
+ * Portable kernels, also used for the tails of the SIMD ones
+ */
+template <typename T>
+sum_type<T> sum_scalar(const T* p, std::size_t n) {
+    sum_type<T> s = 0;
+    for (std::size_t i = 0; i < n; ++i) s += p[i];
+    return s;
+}
+
+// n must be > 0
+template <typename T>
+std::pair<T, T> minmax_scalar(const T* p, std::size_t n) {
+    T lo = p[0], hi = p[0];
+    for (std::size_t i = 1; i < n; ++i) {
+        lo = p[i] < lo ? p[i] : lo;
+        hi = hi < p[i] ? p[i] : hi;
+    }
+    return std::make_pair(lo, hi);
+}
+
+template <typename Acc, typename T>
+void add_row_scalar(Acc* acc, const T* row, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) acc[i] += row[i];
+}
+
+#if GNB_RECTANGULAR_X86
+
+/*
+ * uint8_t: psadbw against zero sums 8 bytes into a 64-bit lane, with no overflow
+ */
+GNB_TARGET("sse2")
+inline std::uint64_t sum_u8_sse2(const std::uint8_t* p, std::size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), zero));
+    std::uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    return lanes[0] + lanes[1] + sum_scalar(p + i, n - i);
+}
+
+GNB_TARGET("avx2")
+inline std::uint64_t sum_u8_avx2(const std::uint8_t* p, std::size_t n) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)), zero));
+    std::uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sum_scalar(p + i, n - i);
+}
+
+GNB_TARGET("sse2")
+inline std::pair<std::uint8_t, std::uint8_t> minmax_u8_sse2(const std::uint8_t* p, std::size_t n) {
+    if (n < 16) return minmax_scalar(p, n);
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), hi = lo;
+    std::size_t i = 16;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        lo = _mm_min_epu8(lo, v);
+        hi = _mm_max_epu8(hi, v);
+    }
+    std::uint8_t los[16], his[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(los), lo);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(his), hi);
+    std::pair<std::uint8_t, std::uint8_t> r{*std::min_element(los, los + 16), *std::max_element(his, his + 16)};
+    if (i < n) {
+        auto t = minmax_scalar(p + i, n - i);
+        r.first = std::min(r.first, t.first);
+        r.second = std::max(r.second, t.second);
+    }
+    return r;
+}
+
+GNB_TARGET("avx2")
+inline std::pair<std::uint8_t, std::uint8_t> minmax_u8_avx2(const std::uint8_t* p, std::size_t n) {
+    if (n < 32) return minmax_u8_sse2(p, n);
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), hi = lo;
+    std::size_t i = 32;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        lo = _mm256_min_epu8(lo, v);
+        hi = _mm256_max_epu8(hi, v);
+    }
+    std::uint8_t los[32], his[32];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(los), lo);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(his), hi);
+    std::pair<std::uint8_t, std::uint8_t> r{*std::min_element(los, los + 32), *std::max_element(his, his + 32)};
+    if (i < n) {
+        auto t = minmax_scalar(p + i, n - i);
+        r.first = std::min(r.first, t.first);
+        r.second = std::max(r.second, t.second);
+    }
+    return r;
+}
+
+// Widen each byte to 32 bits and add to the column totals
+GNB_TARGET("sse2")
+inline void add_row_u8_sse2(std::uint32_t* acc, const std::uint8_t* row, std::size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+        __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+        _mm_storeu_si128(a + 0, _mm_add_epi32(_mm_loadu_si128(a + 0), _mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), _mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_si128(a + 2, _mm_add_epi32(_mm_loadu_si128(a + 2), _mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_si128(a + 3, _mm_add_epi32(_mm_loadu_si128(a + 3), _mm_unpackhi_epi16(hi, zero)));
+    }
+    add_row_scalar(acc + i, row + i, n - i);
+}
+
+GNB_TARGET("avx2")
+inline void add_row_u8_avx2(std::uint32_t* acc, const std::uint8_t* row, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + i)));
+        __m256i* a = reinterpret_cast<__m256i*>(acc + i);
+        _mm256_storeu_si256(a, _mm256_add_epi32(_mm256_loadu_si256(a), v));
+    }
+    add_row_scalar(acc + i, row + i, n - i);
+}
+
+/*
+ * float: two accumulators to hide the add latency
+ */
+GNB_TARGET("sse2")
+inline float sum_f32_sse2(const float* p, std::size_t n) {
+    __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        a0 = _mm_add_ps(a0, _mm_loadu_ps(p + i));
+        a1 = _mm_add_ps(a1, _mm_loadu_ps(p + i + 4));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(a0, a1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sum_scalar(p + i, n - i);
+}
+
+GNB_TARGET("avx2")
+inline float sum_f32_avx2(const float* p, std::size_t n) {
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        a0 = _mm256_add_ps(a0, _mm256_loadu_ps(p + i));
+        a1 = _mm256_add_ps(a1, _mm256_loadu_ps(p + i + 8));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, _mm256_add_ps(a0, a1));
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]))
+        + sum_scalar(p + i, n - i);
+}
+
+GNB_TARGET("sse2")
+inline std::pair<float, float> minmax_f32_sse2(const float* p, std::size_t n) {
+    if (n < 4) return minmax_scalar(p, n);
+    __m128 lo = _mm_loadu_ps(p), hi = lo;
+    std::size_t i = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(p + i);
+        lo = _mm_min_ps(lo, v);
+        hi = _mm_max_ps(hi, v);
+    }
+    float los[4], his[4];
+    _mm_storeu_ps(los, lo);
+    _mm_storeu_ps(his, hi);
+    auto r = std::make_pair(minmax_scalar(los, 4).first, minmax_scalar(his, 4).second);
+    if (i < n) {
+        auto t = minmax_scalar(p + i, n - i);
+        r.first = std::min(r.first, t.first);
+        r.second = std::max(r.second, t.second);
+    }
+    return r;
+}
+
+GNB_TARGET("avx2")
+inline std::pair<float, float> minmax_f32_avx2(const float* p, std::size_t n) {
+    if (n < 8) return minmax_f32_sse2(p, n);
+    __m256 lo = _mm256_loadu_ps(p), hi = lo;
+    std::size_t i = 8;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(p + i);
+        lo = _mm256_min_ps(lo, v);
+        hi = _mm256_max_ps(hi, v);
+    }
+    float los[8], his[8];
+    _mm256_storeu_ps(los, lo);
+    _mm256_storeu_ps(his, hi);
+    auto r = std::make_pair(minmax_scalar(los, 8).first, minmax_scalar(his, 8).second);
+    if (i < n) {
+        auto t = minmax_scalar(p + i, n - i);
+        r.first = std::min(r.first, t.first);
+        r.second = std::max(r.second, t.second);
+    }
+    return r;
+}
+
+GNB_TARGET("sse2")
+inline void add_row_f32_sse2(float* acc, const float* row, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_loadu_ps(row + i)));
+    add_row_scalar(acc + i, row + i, n - i);
+}
+
+GNB_TARGET("avx2")
+inline void add_row_f32_avx2(float* acc, const float* row, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_loadu_ps(row + i)));
+    add_row_scalar(acc + i, row + i, n - i);
+}
+
+/*
+ * AVX-512: F for float, BW for bytes
+ */
+GNB_TARGET("avx512f,avx512bw")
+inline std::uint64_t sum_u8_avx512(const std::uint8_t* p, std::size_t n) {
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i acc = zero;
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64)
+        acc = _mm512_add_epi64(acc, _mm512_sad_epu8(_mm512_loadu_si512(p + i), zero));
+    std::uint64_t lanes[8];
+    _mm512_storeu_si512(lanes, acc);
+    return sum_scalar(lanes, 8) + sum_u8_avx2(p + i, n - i);
+}
+
+GNB_TARGET("avx512f,avx512bw")
+inline std::pair<std::uint8_t, std::uint8_t> minmax_u8_avx512(const std::uint8_t* p, std::size_t n) {
+    if (n < 64) return minmax_u8_avx2(p, n);
+    __m512i lo = _mm512_loadu_si512(p), hi = lo;
+    std::size_t i = 64;
+    for (; i + 64 <= n; i += 64) {
+        __m512i v = _mm512_loadu_si512(p + i);
+        lo = _mm512_min_epu8(lo, v);
+        hi = _mm512_max_epu8(hi, v);
+    }
+    std::uint8_t los[64], his[64];
+    _mm512_storeu_si512(los, lo);
+    _mm512_storeu_si512(his, hi);
+    std::pair<std::uint8_t, std::uint8_t> r{*std::min_element(los, los + 64), *std::max_element(his, his + 64)};
+    if (i < n) {
+        auto t = minmax_scalar(p + i, n - i);
+        r.first = std::min(r.first, t.first);
+        r.second = std::max(r.second, t.second);
+    }
+    return r;
+}
+
+GNB_TARGET("avx512f,avx512bw")
+inline float sum_f32_avx512(const float* p, std::size_t n) {
+    __m512 a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        a0 = _mm512_add_ps(a0, _mm512_loadu_ps(p + i));
+        a1 = _mm512_add_ps(a1, _mm512_loadu_ps(p + i + 16));
+    }
+    float lanes[16];
+    _mm512_storeu_ps(lanes, _mm512_add_ps(a0, a1));
+    return sum_f32_avx2(lanes, 16) + sum_f32_avx2(p + i, n - i);
+}
+
+GNB_TARGET("avx512f,avx512bw")
+inline std::pair<float, float> minmax_f32_avx512(const float* p, std::size_t n) {
+    if (n < 16) return minmax_f32_avx2(p, n);
+    __m512 lo = _mm512_loadu_ps(p), hi = lo;
+    std::size_t i = 16;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(p + i);
+        lo = min_ps_avx512(lo, v);
+        hi = max_ps_avx512(hi, v);
+    }
+    float los[16], his[16];
+    _mm512_storeu_ps(los, lo);
+    _mm512_storeu_ps(his, hi);
+    auto r = std::make_pair(minmax_scalar(los, 16).first, minmax_scalar(his, 16).second);
+    if (i < n) {
+        auto t = minmax_scalar(p + i, n - i);
+        r.first = std::min(r.first, t.first);
+        r.second = std::max(r.second, t.second);
+    }
+    return r;
+}
+
+#endif // GNB_RECTANGULAR_X86
+
+/*
+ * Kernel selection: the generic version is portable, uint8_t and float call
+ * through a dispatch_table for the best SIMD kernel the CPU has
+ */
+template <typename T>
+struct reduce_kernels {
+    // Column totals are accumulated in this type, then added to the result
+    using col_acc_type = sum_type<T>;
+    // Flush column totals to the result after at most this many rows
+    static std::size_t col_block_rows() { return std::size_t(-1); }
+
+    static sum_type<T> sum(const T* p, std::size_t n) { return sum_scalar(p, n); }
+    static std::pair<T, T> minmax(const T* p, std::size_t n) { return minmax_scalar(p, n); }
+    static void add_row(col_acc_type* acc, const T* row, std::size_t n) { add_row_scalar(acc, row, n); }
+};
+
+template <>
+struct reduce_kernels<std::uint8_t> {
+    using T = std::uint8_t;
+    // 32 bits is enough for 2^24 rows of 255
+    using col_acc_type = std::uint32_t;
+    static std::size_t col_block_rows() { return std::size_t(1) << 24; }
+
+    static sum_type<T> sum(const T* p, std::size_t n) {
+        static const dispatch_table<sum_type<T> (*)(const T*, std::size_t)> table{sum_scalar<T>,
+            GNB_SIMD_KERNEL(sum_u8_sse2), nullptr, GNB_SIMD_KERNEL(sum_u8_avx2), GNB_SIMD_KERNEL(sum_u8_avx512)};
+        return table.get()(p, n);
+    }
+    static std::pair<T, T> minmax(const T* p, std::size_t n) {
+        static const dispatch_table<std::pair<T, T> (*)(const T*, std::size_t)> table{minmax_scalar<T>,
+            GNB_SIMD_KERNEL(minmax_u8_sse2), nullptr, GNB_SIMD_KERNEL(minmax_u8_avx2), GNB_SIMD_KERNEL(minmax_u8_avx512)};
+        return table.get()(p, n);
+    }
+    static void add_row(col_acc_type* acc, const T* row, std::size_t n) {
+        static const dispatch_table<void (*)(col_acc_type*, const T*, std::size_t)> table{add_row_scalar<col_acc_type, T>,
+            GNB_SIMD_KERNEL(add_row_u8_sse2), nullptr, GNB_SIMD_KERNEL(add_row_u8_avx2), nullptr};
+        table.get()(acc, row, n);
+    }
+};
+
+template <>
+struct reduce_kernels<float> {
+    using T = float;
+    using col_acc_type = float;
+    static std::size_t col_block_rows() { return std::size_t(-1); }
+
+    static sum_type<T> sum(const T* p, std::size_t n) {
+        static const dispatch_table<sum_type<T> (*)(const T*, std::size_t)> table{sum_scalar<T>,
+            GNB_SIMD_KERNEL(sum_f32_sse2), nullptr, GNB_SIMD_KERNEL(sum_f32_avx2), GNB_SIMD_KERNEL(sum_f32_avx512)};
+        return table.get()(p, n);
+    }
+    static std::pair<T, T> minmax(const T* p, std::size_t n) {
+        static const dispatch_table<std::pair<T, T> (*)(const T*, std::size_t)> table{minmax_scalar<T>,
+            GNB_SIMD_KERNEL(minmax_f32_sse2), nullptr, GNB_SIMD_KERNEL(minmax_f32_avx2), GNB_SIMD_KERNEL(minmax_f32_avx512)};
+        return table.get()(p, n);
+    }
+    static void add_row(col_acc_type* acc, const T* row, std::size_t n) {
+        static const dispatch_table<void (*)(col_acc_type*, const T*, std::size_t)> table{add_row_scalar<col_acc_type, T>,
+            GNB_SIMD_KERNEL(add_row_f32_sse2), nullptr, GNB_SIMD_KERNEL(add_row_f32_avx2), nullptr};
+        table.get()(acc, row, n);
+    }
+};
+
+} // namespace detail
+
+template <typename T, class Allocator>
+sum_type<T> sum(const rectangular<T, Allocator>& r) {
+    return detail::reduce_kernels<T>::sum(r.data(), r.size());
+}
+
+// Smallest and largest elements, throws std::out_of_range if r is empty
+template <typename T, class Allocator>
+std::pair<T, T> minmax(const rectangular<T, Allocator>& r) {
+    if (r.empty()) throw std::out_of_range("rectangular minmax of empty");
+    return detail::reduce_kernels<T>::minmax(r.data(), r.size());
+}
+
+// (y, x) of the first largest element in row-major order, throws std::out_of_range if r is empty
+template <typename T, class Allocator>
+std::pair<std::size_t, std::size_t> argmax(const rectangular<T, Allocator>& r) {
+    if (r.empty()) throw std::out_of_range("rectangular argmax of empty");
+    // Find the value with the SIMD kernel, then its first position with a
+    // plain search, which for bytes is memchr()
+    T hi = detail::reduce_kernels<T>::minmax(r.data(), r.size()).second;
+    std::size_t i = std::find(r.data(), r.data() + r.size(), hi) - r.data();
+    if (i == r.size()) i = 0; // Only if there were NaNs
+    return std::make_pair(i / r.width(), i % r.width());
+}
+
+template <typename T, class Allocator>
+std::vector<sum_type<T> > row_sums(const rectangular<T, Allocator>& r) {
+    std::vector<sum_type<T> > sums(r.height());
+    for (std::size_t y = 0; y < r.height(); ++y)
+        sums[y] = detail::reduce_kernels<T>::sum(r.data() + y * r.width(), r.width());
+    return sums;
+}
+
+template <typename T, class Allocator>
+std::vector<sum_type<T> > col_sums(const rectangular<T, Allocator>& r) {
+    using K = detail::reduce_kernels<T>;
+    std::vector<sum_type<T> > sums(r.width());
+    std::vector<typename K::col_acc_type> acc(r.width());
+    const std::size_t block = K::col_block_rows();
+    for (std::size_t y0 = 0; y0 < r.height(); y0 += std::min(block, r.height() - y0)) {
+        std::size_t y1 = y0 + std::min(block, r.height() - y0);
+        std::fill(acc.begin(), acc.end(), 0);
+        for (std::size_t y = y0; y < y1; ++y) K::add_row(acc.data(), r.data() + y * r.width(), r.width());
+        for (std::size_t x = 0; x < r.width(); ++x) sums[x] += acc[x];
+    }
+    return sums;
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_reduce
@@ -0,0 +1,33 @@
+#ifndef GNB_rectangular_region
+#define GNB_rectangular_region
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <cstddef>
+
+namespace gnb {
+
+// A sub-rectangle: rows [y, y+height), columns [x, x+width)
+struct region {
+    std::size_t y, x, height, width;
+};
+
+inline bool operator==(const region& a, const region& b) {
+    return a.y == b.y && a.x == b.x && a.height == b.height && a.width == b.width;
+}
+inline bool operator!=(const region& a, const region& b) { return !(a == b); }
+
+} // namespace gnb
+
+#endif // GNB_rectangular_region
@@ -0,0 +1,244 @@
+#ifndef GNB_rectangular_resample
+#define GNB_rectangular_resample
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "rectangular.hpp"
+
+namespace gnb {
+
+/*
+ * Resampling an image to a new size, and mip pyramids
+ *
+ * auto thumb = resample(image, 120, 160, resample_filter::area);
+ * auto levels = build_pyramid(image);   // levels[0] is half size, then quarter, ... 1x1
+ *
+ * resample() is separable: rows are filtered into a float intermediate, then
+ * the columns.  For each output column (and row) the span of source pixels
+ * and their weights are worked out once, up front.  The vertical pass adds
+ * whole weighted rows, so its inner loop runs along x over contiguous memory
+ * and the compiler can vectorise it.
+ *
+ * bilinear and bicubic (Keys, a = -0.5) widen their kernels when shrinking,
+ * so they average rather than alias.  area weights each source pixel by how
+ * much of it the output pixel covers, which is the best choice for shrinking
+ * by large factors.
+ *
+ * Integer T results are rounded and clamped to T's range.
+ */
+enum class resample_filter { bilinear, bicubic, area };
+
+namespace detail {
+
+// The source pixels [first, first + count) contributing to one output pixel
+struct resample_span {
+    std::size_t first, count;
+    std::size_t weights; // index of the first weight
+};
+
+struct resample_table {
+    std::vector<resample_span> spans;
+    std::vector<float> weights;
+};
+
+inline double resample_kernel(resample_filter f, double x) {
+    x = std::fabs(x);
+    if (f == resample_filter::bilinear) return x < 1.0 ? 1.0 - x : 0.0;
+    // Keys cubic, a = -0.5
+    const double a = -0.5;
+    if (x < 1.0) return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+    if (x < 2.0) return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+    return 0.0;
+}
+
+// Weights to resample n_in pixels to n_out, n_in and n_out both > 0
+inline resample_table make_resample_table(std::size_t n_in, std::size_t n_out, resample_filter f) {
+    resample_table t;
+    t.spans.reserve(n_out);
+    const double scale = static_cast<double>(n_in) / static_cast<double>(n_out);
+    std::vector<double> w;
+    for (std::size_t i = 0; i < n_out; ++i) {
+        std::size_t first, last;
+        w.clear();
+        if (f == resample_filter::area) {
+            // Output pixel i covers [lo, hi) of the source
+            const double lo = static_cast<double>(i) * scale, hi = lo + scale;
+            first = static_cast<std::size_t>(lo);
+            last = std::min(n_in, static_cast<std::size_t>(std::ceil(hi)));
+            for (std::size_t j = first; j < last; ++j)
+                w.push_back(std::min(hi, static_cast<double>(j + 1)) - std::max(lo, static_cast<double>(j)));
+        } else {
+            const double stretch = std::max(scale, 1.0);
+            const double support = (f == resample_filter::bilinear ? 1.0 : 2.0) * stretch;
+            const double centre = (static_cast<double>(i) + 0.5) * scale;
+            first = static_cast<std::size_t>(std::max(0.0, std::floor(centre - support + 0.5)));
+            last = std::min(n_in, static_cast<std::size_t>(std::max(0.0, std::floor(centre + support + 0.5))));
+            for (std::size_t j = first; j < last; ++j)
+                w.push_back(resample_kernel(f, (static_cast<double>(j) + 0.5 - centre) / stretch));
+        }
+        // Drop zero weights at the ends, then normalise
+        while (!w.empty() && w.back() == 0.0) {
+            w.pop_back();
+            --last;
+        }
+        std::size_t skip = 0;
+        while (skip < w.size() && w[skip] == 0.0) ++skip;
+        double total = 0.0;
+        for (std::size_t k = skip; k < w.size(); ++k) total += w[k];
+        t.spans.push_back(resample_span{first + skip, w.size() - skip, t.weights.size()});
+        for (std::size_t k = skip; k < w.size(); ++k) t.weights.push_back(static_cast<float>(w[k] / total));
+    }
+    return t;
+}
+
+template <typename T>
+T resample_store(float v, std::true_type) {
+    const float lo = static_cast<float>(std::numeric_limits<T>::lowest()), hi = static_cast<float>(std::numeric_limits<T>::max());
+    return static_cast<T>(std::lround(std::min(hi, std::max(lo, v))));
+}
+template <typename T>
+T resample_store(float v, std::false_type) { return static_cast<T>(v); }
+
+} // namespace detail
+
+// Resample to new_height x new_width, either of which may be bigger or smaller
+template <typename T, class Allocator>
+rectangular<T, Allocator> resample(const rectangular<T, Allocator>& src, std::size_t new_height, std::size_t new_width,
+        resample_filter filter = resample_filter::bilinear) {
+    std::vector<T, Allocator> buf(new_height * new_width, T(), src.get_allocator());
+    rectangular<T, Allocator> out{new_height, new_width, buf};
+    if (src.empty() || out.empty()) return out;
+
+    const detail::resample_table tx = detail::make_resample_table(src.width(), new_width, filter);
+    const detail::resample_table ty = detail::make_resample_table(src.height(), new_height, filter);
+
+    // Rows only need filtering if some output row uses them
+    const std::size_t y_first = ty.spans.front().first;
+    const std::size_t y_last = ty.spans.back().first + ty.spans.back().count;
+    rectangular<float> tmp{y_last - y_first, new_width};
+    for (std::size_t y = y_first; y < y_last; ++y) {
+        const T* in = src[y];
+        float* row = tmp[y - y_first];
+        for (std::size_t x = 0; x < new_width; ++x) {
+            const detail::resample_span& s = tx.spans[x];
+            const float* w = tx.weights.data() + s.weights;
+            float sum = 0.0f;
+            for (std::size_t k = 0; k < s.count; ++k) sum += w[k] * static_cast<float>(in[s.first + k]);
+            row[x] = sum;
+        }
+    }
+
+    using is_int = std::integral_constant<bool, std::is_integral<T>::value>;
+    std::vector<float> acc(new_width);
+    for (std::size_t y = 0; y < new_height; ++y) {
+        const detail::resample_span& s = ty.spans[y];
+        const float* w = ty.weights.data() + s.weights;
+        std::fill(acc.begin(), acc.end(), 0.0f);
+        for (std::size_t k = 0; k < s.count; ++k) {
+            const float* row = tmp[s.first + k - y_first];
+            const float wk = w[k];
+            float* a = acc.data();
+            for (std::size_t x = 0; x < new_width; ++x) a[x] += wk * row[x];
+        }
+        T* o = out[y];
+        for (std::size_t x = 0; x < new_width; ++x) o[x] = detail::resample_store<T>(acc[x], is_int{});
+    }
+    return out;
+}
+
+namespace detail {
+
+// Average of four, rounded for integers
+template <typename T>
+T average4(T a, T b, T c, T d, std::true_type) {
+    using Wide = typename std::conditional<std::is_signed<T>::value, long long, unsigned long long>::type;
+    return static_cast<T>((static_cast<Wide>(a) + b + c + d + 2) / 4);
+}
+template <typename T>
+T average4(T a, T b, T c, T d, std::false_type) {
+    return static_cast<T>((a + b + c + d) * 0.25f);
+}
+
+/*
+ * Builds the pyramid a row at a time: as soon as two rows of a level exist,
+ * the row of the next level below them is made, so each row is still in
+ * cache when it is read back
+ */
+template <typename T, class Allocator>
+class pyramid_builder {
+    public:
+        pyramid_builder(const rectangular<T, Allocator>& src, std::vector<rectangular<T, Allocator> >& levels) :
+            m_src(src), m_levels(levels) {}
+
+        // Row r of level l is complete, level 0 being the source
+        void row_done(std::size_t l, std::size_t r) {
+            if (l == m_levels.size()) return;
+            const std::size_t h = height(l);
+            // Pair rows (0,1), (2,3), ... the last of an odd height pairs with itself
+            if (r % 2 == 0 && r + 1 < h) return;
+            const std::size_t r0 = r - r % 2;
+            const T* a = row(l, r0);
+            const T* b = row(l, r);
+            T* o = m_levels[l][r0 / 2];
+            const std::size_t w = width(l), ow = m_levels[l].width();
+            using is_int = std::integral_constant<bool, std::is_integral<T>::value>;
+            for (std::size_t x = 0; x < w / 2; ++x)
+                o[x] = average4(a[2 * x], a[2 * x + 1], b[2 * x], b[2 * x + 1], is_int{});
+            if (ow > w / 2) o[ow - 1] = average4(a[w - 1], a[w - 1], b[w - 1], b[w - 1], is_int{});
+            row_done(l + 1, r0 / 2);
+        }
+
+    private:
+        const T* row(std::size_t l, std::size_t r) const { return l ? m_levels[l - 1][r] : m_src[r]; }
+        std::size_t height(std::size_t l) const { return l ? m_levels[l - 1].height() : m_src.height(); }
+        std::size_t width(std::size_t l) const { return l ? m_levels[l - 1].width() : m_src.width(); }
+
+        const rectangular<T, Allocator>& m_src;
+        std::vector<rectangular<T, Allocator> >& m_levels;
+};
+
+} // namespace detail
+
+/*
+ * Halve the size repeatedly, averaging 2x2 blocks (an odd last row or column
+ * is averaged with itself), until 1x1 or max_levels have been made.  The
+ * source is not included, levels[0] is half its size.  All levels are made
+ * in one pass over the source.
+ */
+template <typename T, class Allocator>
+std::vector<rectangular<T, Allocator> > build_pyramid(const rectangular<T, Allocator>& src, std::size_t max_levels = 0) {
+    std::vector<rectangular<T, Allocator> > levels;
+    if (src.empty()) return levels;
+    std::size_t h = src.height(), w = src.width();
+    while ((h > 1 || w > 1) && (max_levels == 0 || levels.size() < max_levels)) {
+        h = (h + 1) / 2;
+        w = (w + 1) / 2;
+        std::vector<T, Allocator> buf(h * w, T(), src.get_allocator());
+        levels.emplace_back(h, w, buf);
+    }
+    detail::pyramid_builder<T, Allocator> builder{src, levels};
+    for (std::size_t r = 0; r < src.height(); ++r) builder.row_done(0, r);
+    return levels;
+}
+
+} // namespace gnb
+
+#endif // GNB_rectangular_resample
@@ -0,0 +1,175 @@
+#ifndef GNB_rectangular_simd
+#define GNB_rectangular_simd
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+/*
+ * Run-time CPU dispatch for the SIMD kernels in the other rectangular headers.
+ *
+ * Kernels for newer instruction sets are compiled with per-function target
+ * attributes, so the binary does not need to be built with -mavx2 etc and
+ * still runs on older CPUs.  Each kernel has a dispatch_table of function
+ * pointers, one per simd_level, and calls through the entry for the active
+ * level.  The CPU is checked once, on first use.
+ *
+ * The active level is the best the CPU supports, but can be lowered (never
+ * raised) for testing or benchmarking, either by setting the environment
+ * variable GNB_RECTANGULAR_SIMD to one of scalar, sse2, sse42, avx2 or avx512
+ * before the first kernel is called, or with set_simd_level() at any time.
+ *
+ * This needs GCC or Clang on x86; elsewhere (or with GNB_RECTANGULAR_NO_SIMD
+ * defined) only the portable scalar kernels exist.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if !defined(GNB_RECTANGULAR_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) \
+        && (defined(__x86_64__) || defined(__i386__))
+#   define GNB_RECTANGULAR_X86 1
+#   include <immintrin.h>
+#   define GNB_TARGET(isa) __attribute__((target(isa)))
+// For filling in a dispatch_table, the kernel only exists on x86
+#   define GNB_SIMD_KERNEL(fn) fn
+#else
+#   define GNB_RECTANGULAR_X86 0
+#   define GNB_SIMD_KERNEL(fn) nullptr
+#endif
+
+namespace gnb {
+
+// In increasing order of capability, each level implies the ones below
+enum class simd_level {
+    scalar,     // portable C++
+    sse2,
+    sse42,      // SSE4.2 and below, including SSSE3
+    avx2,
+    avx512      // AVX-512 F and BW
+};
+
+const int simd_level_count = static_cast<int>(simd_level::avx512) + 1;
+
+struct cpu_features {
+    bool sse2, sse42, avx2, avx512f, avx512bw;
+};
+
+// What the CPU can do, checked once
+inline const cpu_features& detected_cpu_features() {
+#if GNB_RECTANGULAR_X86
+    static const cpu_features f = [] {
+        __builtin_cpu_init();
+        return cpu_features{
+            __builtin_cpu_supports("sse2") != 0,
+            __builtin_cpu_supports("sse4.2") != 0,
+            __builtin_cpu_supports("avx2") != 0,
+            __builtin_cpu_supports("avx512f") != 0,
+            __builtin_cpu_supports("avx512bw") != 0};
+    }();
+#else
+    static const cpu_features f{false, false, false, false, false};
+#endif
+    return f;
+}
+
+// The best level the CPU supports
+inline simd_level detected_simd_level() {
+    const cpu_features& f = detected_cpu_features();
+    if (f.avx512f && f.avx512bw && f.avx2) return simd_level::avx512;
+    if (f.avx2 && f.sse42) return simd_level::avx2;
+    if (f.sse42 && f.sse2) return simd_level::sse42;
+    if (f.sse2) return simd_level::sse2;
+    return simd_level::scalar;
+}
+
+// Parse a level name as used by GNB_RECTANGULAR_SIMD, returns false if not recognised
+inline bool parse_simd_level(const char* name, simd_level& level) {
+    static const char* const names[simd_level_count] = {"scalar", "sse2", "sse42", "avx2", "avx512"};
+    for (int i = 0; i < simd_level_count; ++i) {
+        if (std::strcmp(name, names[i]) == 0) {
+            level = static_cast<simd_level>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace detail {
+
+inline std::atomic<int>& active_simd_level_storage() {
+    static std::atomic<int> level{[] {
+        simd_level best = detected_simd_level(), wanted = best;
+        const char* env = std::getenv("GNB_RECTANGULAR_SIMD");
+        if (env && parse_simd_level(env, wanted) && wanted < best) best = wanted;
+        return static_cast<int>(best);
+    }()};
+    return level;
+}
+
+} // namespace detail
+
+// The level the kernels are currently using
+inline simd_level active_simd_level() {
+    return static_cast<simd_level>(detail::active_simd_level_storage().load(std::memory_order_relaxed));
+}
+
+// Use kernels of at most the given level, but no more than the CPU supports
+inline void set_simd_level(simd_level level) {
+    if (level > detected_simd_level()) level = detected_simd_level();
+    detail::active_simd_level_storage().store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+/*
+ * One function pointer per simd_level for a kernel.  Give nullptr for levels
+ * with no specific version and they use the next one down, so only the scalar
+ * version is required.
+ *
+ * static const dispatch_table<Fn> table{sum_scalar, sum_sse2, nullptr, sum_avx2, nullptr};
+ * return table.get()(p, n);
+ */
+template <typename Fn>
+class dispatch_table {
+    public:
+        dispatch_table(Fn scalar, Fn sse2, Fn sse42, Fn avx2, Fn avx512) :
+            m_fns{scalar, sse2, sse42, avx2, avx512} {
+                for (int i = 1; i < simd_level_count; ++i)
+                    if (!m_fns[i]) m_fns[i] = m_fns[i - 1];
+        }
+        explicit dispatch_table(Fn scalar) : dispatch_table(scalar, nullptr, nullptr, nullptr, nullptr) {}
+
+        Fn get() const { return m_fns[static_cast<int>(active_simd_level())]; }
+        Fn get(simd_level level) const { return m_fns[static_cast<int>(level)]; }
+
+    private:
+        Fn m_fns[simd_level_count];
+};
+
+#if GNB_RECTANGULAR_X86
+
+namespace detail {
+
+// Packed float min and max for kernels.  The masked forms avoid a spurious
+// GCC 12 -Wmaybe-uninitialized in the unmasked _mm512_min_ps/_mm512_max_ps.
+GNB_TARGET("avx512f")
+inline __m512 min_ps_avx512(__m512 a, __m512 b) { return _mm512_mask_min_ps(a, 0xffff, a, b); }
+GNB_TARGET("avx512f")
+inline __m512 max_ps_avx512(__m512 a, __m512 b) { return _mm512_mask_max_ps(a, 0xffff, a, b); }
+
+} // namespace detail
+
+#endif // GNB_RECTANGULAR_X86
+
+} // namespace gnb
+
+#endif // GNB_rectangular_simd
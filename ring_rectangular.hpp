@@ -0,0 +1,204 @@
+#ifndef GNB_ring_rectangular
+#define GNB_ring_rectangular
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rectangular.hpp"
+
+namespace gnb {
+
+/*
+ * A rectangular whose rows form a ring buffer, so scrolling is cheap
+ *
+ * ring_rectangular<float> sweep{512, 1024};
+ * sweep.scroll_rows(4, 0.0f);          // old row 4 is now row 0, rows 508..511 are cleared
+ * std::copy(in, in + 1024, sweep[511]);
+ *
+ * Logical row y is stored in physical row (base + y) % height, so
+ * scroll_rows() only moves the base, and costs nothing for the rows that
+ * stay.  Each row is still contiguous, so operator[] returns a row pointer as
+ * for rectangular, but the rows are not in order in memory unless
+ * linearize() has been called since the last scroll.
+ *
+ * shift_cols() moves the contents of every row sideways, with one memmove()
+ * per row for trivially copyable T.
+ */
+template <typename T, class Allocator = std::allocator<T> >
+class ring_rectangular {
+        using BaseType = std::vector<T, Allocator>;
+    public:
+        using value_type = typename BaseType::value_type;
+        using reference = typename BaseType::reference;
+        using const_reference = typename BaseType::const_reference;
+        using pointer = typename BaseType::pointer;
+        using const_pointer = typename BaseType::const_pointer;
+        using size_type = typename BaseType::size_type;
+        using difference_type = typename BaseType::difference_type;
+        using allocator_type = typename BaseType::allocator_type;
+
+        ring_rectangular() : m_height{0}, m_width{0}, m_base{0}, m_data{} {}
+        explicit ring_rectangular(size_type height, size_type width, value_type value = value_type()) :
+            m_height{height}, m_width{width}, m_base{0}, m_data(height * width, value) {}
+        explicit ring_rectangular(const rectangular<T, Allocator>& r) :
+            m_height{r.height()}, m_width{r.width()}, m_base{0}, m_data(r.begin(), r.end(), r.get_allocator()) {}
+
+        // Default dtor/copy/assign OK
+        ~ring_rectangular() = default;
+        ring_rectangular(const ring_rectangular&) = default;
+        ring_rectangular& operator=(const ring_rectangular&) = default;
+
+        // Move ctor/assign need help to maintain invariants
+        ring_rectangular(ring_rectangular&& r) : m_height{0}, m_width{0}, m_base{0}, m_data{} { swap(r); }
+        ring_rectangular& operator=(ring_rectangular&& r) { swap(r); return *this; }
+
+        size_type size() const { return m_data.size(); }
+        bool empty() const { return m_data.empty(); }
+
+        size_type height() const { return m_height; }
+        size_type width() const { return m_width; }
+
+        // The physical row holding logical row 0
+        size_type base_row() const { return m_base; }
+        // True if the rows are in order in memory
+        bool is_linear() const { return m_base == 0; }
+
+        // Bounds-checked, will throw std::out_of_range() if required
+        reference at(size_type y, size_type x) {
+            check(y, x);
+            return (*this)[y][x];
+        }
+        const_reference at(size_type y, size_type x) const {
+            check(y, x);
+            return (*this)[y][x];
+        }
+
+        // Raw pointers, fast but no bounds checking
+        pointer operator[](size_type y) { return m_data.data() + physical_row(y) * m_width; }
+        const_pointer operator[](size_type y) const { return m_data.data() + physical_row(y) * m_width; }
+
+        void fill(const_reference value) { std::fill(m_data.begin(), m_data.end(), value); }
+
+        /*
+         * Scroll up by n rows (down if n is negative): logical row n becomes
+         * row 0, and the rows scrolled off the top reappear at the bottom
+         * unchanged.  O(1).
+         */
+        void scroll_rows(difference_type n) {
+            if (m_height == 0) return;
+            const difference_type h = static_cast<difference_type>(m_height);
+            difference_type shift = n % h;
+            if (shift < 0) shift += h;
+            m_base = physical_row(static_cast<size_type>(shift));
+        }
+
+        // As above, and fill the rows that have wrapped round with value.  O(|n| * width)
+        void scroll_rows(difference_type n, const_reference value) {
+            scroll_rows(n);
+            const size_type count = std::min(m_height, static_cast<size_type>(n < 0 ? -n : n));
+            const size_type first = n < 0 ? 0 : m_height - count;
+            for (size_type y = first; y < first + count; ++y) std::fill((*this)[y], (*this)[y] + m_width, value);
+        }
+
+        /*
+         * Shift every row right by n columns (left if n is negative), filling
+         * the columns uncovered with value.  O(height * width)
+         */
+        void shift_cols(difference_type n, const_reference value = value_type()) {
+            const size_type count = std::min(m_width, static_cast<size_type>(n < 0 ? -n : n));
+            if (count == 0) return;
+            const size_type keep = m_width - count;
+            for (size_type y = 0; y < m_height; ++y) {
+                pointer row = m_data.data() + y * m_width;
+                if (n > 0) {
+                    move_row(row, row + count, keep);
+                    std::fill(row, row + count, value);
+                } else {
+                    move_row(row + count, row, keep);
+                    std::fill(row + keep, row + m_width, value);
+                }
+            }
+        }
+
+        // Put the rows back in order in memory, so base_row() is 0.  O(size)
+        void linearize() {
+            if (m_base == 0) return;
+            std::rotate(m_data.begin(), m_data.begin() + m_base * m_width, m_data.end());
+            m_base = 0;
+        }
+
+        // Copy out in logical row order
+        rectangular<T, Allocator> to_rectangular() const {
+            BaseType data(m_data.get_allocator());
+            data.reserve(size());
+            data.insert(data.end(), m_data.begin() + m_base * m_width, m_data.end());
+            data.insert(data.end(), m_data.begin(), m_data.begin() + m_base * m_width);
+            return rectangular<T, Allocator>{m_height, m_width, data};
+        }
+
+        allocator_type get_allocator() const { return m_data.get_allocator(); }
+
+        void swap(ring_rectangular& r) {
+            std::swap(m_height, r.m_height);
+            std::swap(m_width, r.m_width);
+            std::swap(m_base, r.m_base);
+            m_data.swap(r.m_data);
+        }
+
+        // Check invariants, mainly for unit tests
+        bool invariants() const {
+            return m_data.size() == m_height * m_width && (m_base < m_height || m_base == 0);
+        }
+
+    private:
+        size_type physical_row(size_type y) const {
+            size_type p = m_base + y;
+            return p >= m_height ? p - m_height : p;
+        }
+
+        void check(size_type y, size_type x) const {
+            if (y >= m_height) throw std::out_of_range("ring_rectangular Y index");
+            if (x >= m_width) throw std::out_of_range("ring_rectangular X index");
+        }
+
+        // Move n elements within a row, the ranges may overlap
+        static void move_row(const_pointer src, pointer dst, size_type n) {
+            move_row(src, dst, n, std::integral_constant<bool, std::is_trivially_copyable<T>::value>{});
+        }
+        static void move_row(const_pointer src, pointer dst, size_type n, std::true_type) {
+            std::memmove(dst, src, n * sizeof(T));
+        }
+        static void move_row(const_pointer src, pointer dst, size_type n, std::false_type) {
+            if (dst > src)
+                std::copy_backward(src, src + n, dst + n);
+            else
+                std::copy(src, src + n, dst);
+        }
+
+        size_type m_height, m_width;
+        size_type m_base;
+        BaseType m_data;
+};
+
+} // namespace gnb
+
+#endif // GNB_ring_rectangular
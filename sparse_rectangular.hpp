@@ -0,0 +1,221 @@
+#ifndef GNB_sparse_rectangular
+#define GNB_sparse_rectangular
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace gnb {
+
+/*
+ * A huge, mostly-empty 2-D grid that only allocates the tiles that are written to
+ *
+ * sparse_rectangular<int> world{1000000, 1000000};  // allocates ~0.5MB of directory
+ * world.at(123456, 654321) = 7;                      // allocates one 64x64 tile
+ * world.at(0, 0);                                    // still 0, and no allocation if const
+ *
+ * Tiles are 2^TileShift square.  Lookup is a fixed two-level directory, so
+ * at() costs two pointer loads and some shifts and masks: the top level is a
+ * flat array with one entry per chunk of 64x64 tiles, allocated up front, and
+ * each chunk is an array of tile pointers allocated when its first tile is.
+ *
+ * Const access to a cell in an unallocated tile returns the default value
+ * without allocating.  Mutable access allocates the tile, filled with the
+ * default value.  There is no operator[], as rows are not contiguous.
+ */
+template <typename T, unsigned TileShift = 6>
+class sparse_rectangular {
+    private:
+        static constexpr unsigned ChunkShift = 6;
+    public:
+        using value_type = T;
+        using reference = T&;
+        using const_reference = const T&;
+        using pointer = T*;
+        using const_pointer = const T*;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+
+        static constexpr size_type tile_size = size_type(1) << TileShift;
+
+        /*
+         * An allocated tile: the cells [y, y+height) x [x, x+width), clipped at
+         * the edges of the grid.  Cell (y+dy, x+dx) is data[dy * tile_size + dx].
+         */
+        template <typename Ptr>
+        struct basic_tile {
+            size_type y, x, height, width;
+            Ptr data;
+        };
+        using tile = basic_tile<pointer>;
+        using const_tile = basic_tile<const_pointer>;
+
+        sparse_rectangular() : sparse_rectangular(0, 0) {}
+        explicit sparse_rectangular(size_type height, size_type width, value_type default_value = value_type()) :
+            m_height{height}, m_width{width}, m_default{default_value},
+            m_tiles_x{(width + tile_size - 1) >> TileShift},
+            m_chunks_x{(m_tiles_x + chunk_tiles_across - 1) >> ChunkShift},
+            m_dir(m_chunks_x * ((((height + tile_size - 1) >> TileShift) + chunk_tiles_across - 1) >> ChunkShift)),
+            m_allocated{} {}
+
+        // Copy is deep, but only of the allocated tiles
+        sparse_rectangular(const sparse_rectangular& r) : sparse_rectangular(r.m_height, r.m_width, r.m_default) {
+            for (const auto& pos : r.m_allocated) {
+                const_pointer src = r.find_tile(pos.first, pos.second);
+                std::copy(src, src + tile_cells, make_tile(pos.first, pos.second));
+            }
+        }
+        sparse_rectangular& operator=(const sparse_rectangular& r) {
+            sparse_rectangular tmp{r};
+            swap(tmp);
+            return *this;
+        }
+        ~sparse_rectangular() = default;
+
+        // Move ctor/assign need help to maintain invariants
+        sparse_rectangular(sparse_rectangular&& r) : sparse_rectangular(0, 0) { swap(r); }
+        sparse_rectangular& operator=(sparse_rectangular&& r) { swap(r); return *this; }
+
+        // The logical size, not how much is allocated
+        size_type size() const { return m_height * m_width; }
+        bool empty() const { return size() == 0; }
+
+        size_type height() const { return m_height; }
+        size_type width() const { return m_width; }
+        const_reference default_value() const { return m_default; }
+
+        // Bounds-checked, will throw std::out_of_range() if required
+        // Allocates the tile holding (y, x) if need be
+        reference at(size_type y, size_type x) {
+            check(y, x);
+            size_type ty = y >> TileShift, tx = x >> TileShift;
+            pointer t = find_tile(ty, tx);
+            if (!t) t = make_tile(ty, tx);
+            return t[cell_index(y, x)];
+        }
+
+        // Bounds-checked, will throw std::out_of_range() if required
+        // Returns default_value() for unallocated tiles
+        const_reference at(size_type y, size_type x) const {
+            check(y, x);
+            const_pointer t = find_tile(y >> TileShift, x >> TileShift);
+            return t ? t[cell_index(y, x)] : m_default;
+        }
+
+        bool is_allocated(size_type y, size_type x) const {
+            check(y, x);
+            return find_tile(y >> TileShift, x >> TileShift) != nullptr;
+        }
+
+        size_type tile_count() const { return m_allocated.size(); }
+
+        // Call fn(tile) / fn(const_tile) for each allocated tile, in allocation order
+        template <typename Fn>
+        void for_each_tile(Fn fn) {
+            for (const auto& pos : m_allocated) fn(make_view<tile>(pos, find_tile(pos.first, pos.second)));
+        }
+        template <typename Fn>
+        void for_each_tile(Fn fn) const {
+            for (const auto& pos : m_allocated) fn(make_view<const_tile>(pos, find_tile(pos.first, pos.second)));
+        }
+
+        // Free every tile, so every cell has the default value
+        void clear() {
+            for (auto& chunk : m_dir) chunk.reset();
+            m_allocated.clear();
+        }
+
+        void swap(sparse_rectangular& r) {
+            std::swap(m_height, r.m_height);
+            std::swap(m_width, r.m_width);
+            std::swap(m_default, r.m_default);
+            std::swap(m_tiles_x, r.m_tiles_x);
+            std::swap(m_chunks_x, r.m_chunks_x);
+            std::swap(m_dir, r.m_dir);
+            std::swap(m_allocated, r.m_allocated);
+        }
+
+        // Check invariants, mainly for unit tests
+        bool invariants() const {
+            size_type n = 0;
+            for (const auto& chunk : m_dir)
+                if (chunk)
+                    n += std::count_if(std::begin(chunk->tiles), std::end(chunk->tiles),
+                        [](const std::unique_ptr<T[]>& t) { return t != nullptr; });
+            return n == m_allocated.size();
+        }
+
+    private:
+        static constexpr size_type chunk_tiles_across = size_type(1) << ChunkShift;
+        static constexpr size_type tile_cells = tile_size * tile_size;
+
+        struct chunk {
+            std::unique_ptr<T[]> tiles[chunk_tiles_across * chunk_tiles_across];
+        };
+
+        void check(size_type y, size_type x) const {
+            if (y >= m_height) throw std::out_of_range("sparse_rectangular Y index");
+            if (x >= m_width) throw std::out_of_range("sparse_rectangular X index");
+        }
+
+        static size_type cell_index(size_type y, size_type x) {
+            return ((y & (tile_size - 1)) << TileShift) | (x & (tile_size - 1));
+        }
+        size_type chunk_index(size_type ty, size_type tx) const {
+            return (ty >> ChunkShift) * m_chunks_x + (tx >> ChunkShift);
+        }
+        static size_type tile_index(size_type ty, size_type tx) {
+            return ((ty & (chunk_tiles_across - 1)) << ChunkShift) | (tx & (chunk_tiles_across - 1));
+        }
+
+        pointer find_tile(size_type ty, size_type tx) const {
+            const std::unique_ptr<chunk>& c = m_dir[chunk_index(ty, tx)];
+            return c ? c->tiles[tile_index(ty, tx)].get() : nullptr;
+        }
+
+        pointer make_tile(size_type ty, size_type tx) {
+            std::unique_ptr<chunk>& c = m_dir[chunk_index(ty, tx)];
+            if (!c) c.reset(new chunk);
+            std::unique_ptr<T[]>& t = c->tiles[tile_index(ty, tx)];
+            t.reset(new T[tile_cells]);
+            std::fill(t.get(), t.get() + tile_cells, m_default);
+            m_allocated.emplace_back(ty, tx);
+            return t.get();
+        }
+
+        template <typename View>
+        View make_view(const std::pair<size_type, size_type>& pos, pointer data) const {
+            size_type y = pos.first << TileShift, x = pos.second << TileShift;
+            return View{y, x, std::min(tile_size, m_height - y), std::min(tile_size, m_width - x), data};
+        }
+
+        size_type m_height, m_width;
+        value_type m_default;
+        size_type m_tiles_x, m_chunks_x;
+        std::vector<std::unique_ptr<chunk> > m_dir;
+        std::vector<std::pair<size_type, size_type> > m_allocated; // (ty, tx) of each tile
+};
+
+template <typename T, unsigned TileShift> constexpr std::size_t sparse_rectangular<T, TileShift>::tile_size;
+template <typename T, unsigned TileShift> constexpr std::size_t sparse_rectangular<T, TileShift>::chunk_tiles_across;
+template <typename T, unsigned TileShift> constexpr std::size_t sparse_rectangular<T, TileShift>::tile_cells;
+
+} // namespace gnb
+
+#endif // GNB_sparse_rectangular
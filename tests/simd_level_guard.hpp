@@ -0,0 +1,12 @@
+#ifndef GNB_simd_level_guard
+#define GNB_simd_level_guard
+
+#include "rectangular_simd.hpp"
+
+// Restore the original SIMD level even if a test fails
+struct level_guard {
+    gnb::simd_level saved = gnb::active_simd_level();
+    ~level_guard() { gnb::set_simd_level(saved); }
+};
+
+#endif // GNB_simd_level_guard
@@ -0,0 +1,139 @@
+#include "catch.hpp"
+
+#include "compressed_rectangular.hpp"
+
+#include <cstdint>
+#include <random>
+
+using namespace gnb;
+
+namespace {
+
+// Mostly constant, with a smooth patch and a noisy one
+template <typename T>
+rectangular<T> archive_like(std::size_t h, std::size_t w) {
+    std::mt19937 gen{11};
+    rectangular<T> r{h, w, T(7)};
+    for (std::size_t y = 10; y < h / 2; ++y)
+        for (std::size_t x = 20; x < w / 2; ++x) r[y][x] = static_cast<T>(100 + y + 2 * x);
+    for (std::size_t y = h / 2; y < h / 2 + 10 && y < h; ++y)
+        for (std::size_t x = 0; x < w; ++x) r[y][x] = static_cast<T>(gen() % 1000);
+    return r;
+}
+
+}
+
+TEST_CASE("compressed_rectangular round trip", "[compressed]") {
+    auto src = archive_like<std::uint16_t>(300, 257);
+    for (tile_codec codec : {tile_codec::automatic, tile_codec::raw, tile_codec::rle, tile_codec::delta}) {
+        compressed_rectangular<std::uint16_t> c{src, codec};
+        REQUIRE(c.height() == 300);
+        REQUIRE(c.width() == 257);
+        REQUIRE(c.tile_count() == 5 * 5);
+        REQUIRE(c.decompress() == src);
+        for (std::size_t y = 0; y < 300; y += 7)
+            for (std::size_t x = 0; x < 257; x += 3) REQUIRE(c.at(y, x) == src[y][x]);
+    }
+    REQUIRE_THROWS_AS(compressed_rectangular<std::uint16_t>(src, tile_codec::lz4), std::invalid_argument);
+}
+
+TEST_CASE("compressed_rectangular codecs", "[compressed]") {
+    // Float and signed data, including negative differences
+    rectangular<float> f{70, 70};
+    for (std::size_t y = 0; y < 70; ++y)
+        for (std::size_t x = 0; x < 70; ++x) f[y][x] = y < 35 ? -1.5f : static_cast<float>(x) * 0.25f - 3;
+    for (tile_codec codec : {tile_codec::rle, tile_codec::delta, tile_codec::automatic})
+        REQUIRE(compressed_rectangular<float>(f, codec).decompress() == f);
+
+    rectangular<std::int64_t> s{64, 64};
+    for (std::size_t i = 0; i < s.size(); ++i) s.data()[i] = (i % 2 ? -1 : 1) * static_cast<std::int64_t>(i * i * i);
+    s[3][3] = INT64_MIN;
+    s[3][4] = INT64_MAX;
+    REQUIRE(compressed_rectangular<std::int64_t>(s, tile_codec::delta).decompress() == s);
+
+    rectangular<std::uint8_t> ramp{64, 64};
+    for (std::size_t i = 0; i < ramp.size(); ++i) ramp.data()[i] = static_cast<std::uint8_t>(i * 3);
+    compressed_rectangular<std::uint8_t> cr{ramp};
+    REQUIRE(cr.codec_at(0, 0) == tile_codec::delta);
+    REQUIRE(cr.decompress() == ramp);
+
+    compressed_rectangular<int> flat{1000, 1000, 5};
+    REQUIRE(flat.at(999, 999) == 5);
+    REQUIRE(flat.compression_ratio() > 100);
+    REQUIRE(flat.codec_at(500, 500) != tile_codec::raw);
+
+    std::mt19937 gen{3};
+    rectangular<std::uint32_t> noise{64, 64};
+    for (auto& v : noise) v = gen();
+    compressed_rectangular<std::uint32_t> cn{noise};
+    REQUIRE(cn.codec_at(0, 0) == tile_codec::raw);
+    REQUIRE(cn.decompress() == noise);
+}
+
+TEST_CASE("compressed_rectangular ratio", "[compressed]") {
+    auto src = archive_like<std::int32_t>(512, 512);
+    compressed_rectangular<std::int32_t> c{src};
+    REQUIRE(c.uncompressed_bytes() == 512 * 512 * 4);
+    REQUIRE(c.compression_ratio() > 10);
+    REQUIRE(c.compressed_bytes() < c.uncompressed_bytes() / 10);
+}
+
+TEST_CASE("compressed_rectangular set and cache", "[compressed]") {
+    auto src = archive_like<std::uint16_t>(200, 200);
+    compressed_rectangular<std::uint16_t> c{src, tile_codec::automatic, 2};
+    REQUIRE(c.cache_capacity() == 2);
+    const std::size_t before = c.compressed_bytes();
+
+    // Touch more tiles than the cache holds, so dirty ones are evicted
+    for (std::size_t y = 0; y < 200; y += 50)
+        for (std::size_t x = 0; x < 200; x += 30) {
+            c.set(y, x, static_cast<std::uint16_t>(y + x));
+            src[y][x] = static_cast<std::uint16_t>(y + x);
+        }
+    REQUIRE(c.at(150, 180) == 330);
+    REQUIRE(c.decompress() == src);
+    c.flush();
+    REQUIRE(c.compressed_bytes() != before);
+    REQUIRE(c.decompress() == src);
+
+    const auto copy = c;
+    c.set(0, 0, 1);
+    REQUIRE(copy.at(0, 0) == 0);
+    REQUIRE(c.at(0, 0) == 1);
+
+    REQUIRE_THROWS_AS(c.at(200, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(c.set(0, 200, 1), std::out_of_range);
+}
+
+TEST_CASE("compressed_rectangular tiles", "[compressed]") {
+    using C = compressed_rectangular<int, 4>;
+    rectangular<int> src{40, 20};
+    for (std::size_t i = 0; i < src.size(); ++i) src.data()[i] = static_cast<int>(i);
+    C c{src};
+    std::size_t cells = 0, tiles = 0;
+    const C& cc = c;
+    cc.for_each_tile([&](C::const_tile t) {
+        ++tiles;
+        for (std::size_t dy = 0; dy < t.height; ++dy)
+            for (std::size_t dx = 0; dx < t.width; ++dx) {
+                REQUIRE(t.data[dy * C::tile_size + dx] == src[t.y + dy][t.x + dx]);
+                ++cells;
+            }
+    });
+    REQUIRE(tiles == 3 * 2);
+    REQUIRE(cells == src.size());
+
+    c.at(20, 5); // cached
+    c.for_each_tile([&](C::tile t) {
+        for (std::size_t dy = 0; dy < t.height; ++dy)
+            for (std::size_t dx = 0; dx < t.width; ++dx) t.data[dy * C::tile_size + dx] *= 2;
+    });
+    for (int& v : src) v *= 2;
+    REQUIRE(c.decompress() == src);
+    REQUIRE(c.at(20, 5) == src[20][5]);
+
+    C empty;
+    REQUIRE(empty.empty());
+    REQUIRE(empty.tile_count() == 0);
+    REQUIRE(empty.decompress().empty());
+}
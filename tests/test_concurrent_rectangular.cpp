@@ -0,0 +1,82 @@
+#include "catch.hpp"
+
+#include "concurrent_rectangular.hpp"
+
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace gnb;
+
+TEST_CASE("concurrent_rectangular basics", "[concurrent]") {
+    concurrent_rectangular<int> c{10, 6, 3, 4, 2};
+    REQUIRE(c.height() == 10);
+    REQUIRE(c.width() == 6);
+    REQUIRE(c.stripe_count() == 4);
+    REQUIRE(c.band_rows() == 2);
+    REQUIRE(c.stripe_of(0) == 0);
+    REQUIRE(c.stripe_of(1) == 0);
+    REQUIRE(c.stripe_of(2) == 1);
+    REQUIRE(c.stripe_of(9) == 0);
+
+    c.set(4, 5, 9);
+    REQUIRE(c.get(4, 5) == 9);
+    REQUIRE(c.with_row_lock(4, [](const int* row) { return row[0] + row[5]; }) == 12);
+    c.with_region_lock(region{1, 1, 3, 2}, [](rectangular<int>& g) { g[2][2] = 7; });
+    REQUIRE(c.snapshot()[2][2] == 7);
+
+    REQUIRE_THROWS_AS(c.get(10, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(c.set(0, 6, 1), std::out_of_range);
+    REQUIRE_THROWS_AS(c.with_region_lock(region{8, 0, 3, 1}, [](rectangular<int>&) {}), std::out_of_range);
+    REQUIRE_THROWS_AS(c.with_regions_lock({region{0, 0, 1, 1}, region{0, 5, 1, 2}}, [](rectangular<int>&) {}),
+            std::out_of_range);
+    // Empty regions lock nothing
+    c.with_region_lock(region{10, 6, 0, 0}, [](rectangular<int>&) {});
+
+    concurrent_rectangular<int> small{3, 3};
+    REQUIRE(small.stripe_count() <= 3);
+    concurrent_rectangular<double> adopted{rectangular<double>{2, 2, {1, 2, 3, 4}}};
+    REQUIRE(adopted.snapshot() == rectangular<double>(2, 2, {1, 2, 3, 4}));
+}
+
+TEST_CASE("concurrent_rectangular scattered updates", "[concurrent]") {
+    const unsigned nthreads = 8, updates = 20000;
+    concurrent_rectangular<long> c{64, 64};
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < nthreads; ++t)
+        threads.emplace_back([&c, t] {
+            std::mt19937 gen{t};
+            for (unsigned i = 0; i < updates; ++i) {
+                const std::size_t y = gen() % 64, x = gen() % 64;
+                c.with_row_lock(y, [x](long* row) { ++row[x]; });
+            }
+        });
+    for (auto& t : threads) t.join();
+    long total = 0;
+    for (long v : c.snapshot()) total += v;
+    REQUIRE(total == long(nthreads) * updates);
+}
+
+TEST_CASE("concurrent_rectangular multi-region transfers", "[concurrent]") {
+    // Few stripes and wide bands, so regions often share and overlap them
+    const unsigned nthreads = 8, transfers = 5000;
+    concurrent_rectangular<long> c{40, 10, 100, 3, 4};
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < nthreads; ++t)
+        threads.emplace_back([&c, t] {
+            std::mt19937 gen{t + 100};
+            for (unsigned i = 0; i < transfers; ++i) {
+                const region from{gen() % 40, gen() % 10, 1, 1}, to{gen() % 40, gen() % 10, 1, 1};
+                c.with_regions_lock({to, from}, [&](rectangular<long>& g) {
+                    --g[from.y][from.x];
+                    ++g[to.y][to.x];
+                });
+                // A big region, to cross all the stripes the other way round
+                if (i % 100 == 0) c.with_region_lock(region{0, 0, 40, 10}, [](rectangular<long>&) {});
+            }
+        });
+    for (auto& t : threads) t.join();
+    long total = 0;
+    for (long v : c.snapshot()) total += v;
+    REQUIRE(total == 40 * 10 * 100);
+}
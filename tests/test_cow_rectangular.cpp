@@ -0,0 +1,132 @@
+#include "catch.hpp"
+
+#include "cow_rectangular.hpp"
+
+#include <thread>
+
+using namespace gnb;
+
+using C = cow_rectangular<int>;
+
+TEST_CASE("cow_rectangular create", "[cow]") {
+    C c{10, 4, 3, 3};
+
+    REQUIRE(c.height() == 10);
+    REQUIRE(c.width() == 4);
+    REQUIRE(c.size() == 40);
+    REQUIRE(c.band_rows() == 3);
+    REQUIRE(c.band_count() == 4);
+    REQUIRE(c.invariants());
+    REQUIRE(c.at(9, 3) == 3);
+    REQUIRE_THROWS_AS(c.at(10, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(c.at(0, 4), std::out_of_range);
+
+    C d;
+    REQUIRE(d.size() == 0);
+    REQUIRE(d.invariants());
+}
+
+TEST_CASE("cow_rectangular from rectangular", "[cow]") {
+    rectangular<int> r{5, 2, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}};
+    C c{r, 2};
+
+    REQUIRE(c.invariants());
+    REQUIRE(c.at(0, 1) == 1);
+    REQUIRE(c[4][0] == 8);
+    REQUIRE(c.to_rectangular().at(2, 1) == 5);
+    REQUIRE(std::equal(r.begin(), r.end(), c.to_rectangular().begin()));
+}
+
+TEST_CASE("cow_rectangular copies share until written", "[cow]") {
+    C c{8, 4, 1, 2};
+    C snap{c};
+
+    REQUIRE(c.shared_bands() == 4);
+    REQUIRE(snap.shared_bands() == 4);
+
+    c.at(5, 1) = 42;
+
+    REQUIRE(c.at(5, 1) == 42);
+    REQUIRE(snap.at(5, 1) == 1);
+    // Only the band holding row 5 was duplicated
+    REQUIRE(c.shared_bands() == 3);
+    REQUIRE(snap.shared_bands() == 3);
+
+    // Writing again to the now-private band does not copy
+    c[4][0] = 7;
+    REQUIRE(c.shared_bands() == 3);
+    REQUIRE(snap[4][0] == 1);
+}
+
+TEST_CASE("cow_rectangular const access does not copy", "[cow]") {
+    C c{8, 4, 1, 2};
+    const C snap{c};
+
+    REQUIRE(snap.at(7, 3) == 1);
+    REQUIRE(snap[6][0] == 1);
+    const C& cc = c;
+    REQUIRE(cc[0][0] == 1);
+    REQUIRE(c.shared_bands() == 4);
+}
+
+TEST_CASE("cow_rectangular snapshot dropped", "[cow]") {
+    C c{4, 4, 0, 1};
+    {
+        C snap = c;
+        REQUIRE(c.shared_bands() == 4);
+    }
+    REQUIRE(c.shared_bands() == 0);
+}
+
+TEST_CASE("cow_rectangular fill", "[cow]") {
+    C c{6, 3, 1, 2};
+    C snap{c};
+    c[0][0] = 5; // band 0 now private
+
+    c.fill(9);
+
+    REQUIRE(c.at(0, 0) == 9);
+    REQUIRE(c.at(5, 2) == 9);
+    REQUIRE(snap.at(0, 0) == 1);
+    REQUIRE(snap.at(5, 2) == 1);
+    REQUIRE(c.shared_bands() == 0);
+}
+
+TEST_CASE("cow_rectangular move and swap", "[cow]") {
+    C c{3, 3, 4};
+    C m{std::move(c)};
+
+    REQUIRE(c.size() == 0);
+    REQUIRE(c.invariants());
+    REQUIRE(m.size() == 9);
+    REQUIRE(m.invariants());
+
+    C other{1, 1, 2};
+    m.swap(other);
+    REQUIRE(m.at(0, 0) == 2);
+    REQUIRE(other.at(2, 2) == 4);
+}
+
+TEST_CASE("cow_rectangular default band size", "[cow]") {
+    cow_rectangular<double> c{1000, 1024};
+    REQUIRE(c.band_rows() == 8); // 64KiB / 8KiB rows
+    REQUIRE(c.invariants());
+}
+
+TEST_CASE("cow_rectangular snapshot read on another thread", "[cow]") {
+    C world{64, 64, 1, 4};
+    for (int round = 0; round < 50; ++round) {
+        C snapshot = world;
+        long sum = 0;
+        std::thread reader([&sum](C s) {
+            for (std::size_t y = 0; y < s.height(); ++y)
+                for (std::size_t x = 0; x < s.width(); ++x) sum += s[y][x];
+        }, std::move(snapshot));
+        // Bands still held by the reader are copied, the rest written in place
+        for (std::size_t y = 0; y < world.height(); ++y) world[y][y] += 1;
+        reader.join();
+        REQUIRE(sum == 64 * 64 + 64 * round);
+        REQUIRE(world.shared_bands() == 0);
+        REQUIRE(world.invariants());
+    }
+}
@@ -0,0 +1,96 @@
+#include "catch.hpp"
+
+#include "rectangular.hpp"
+#include "rectangular_alloc.hpp"
+#include "rectangular_parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace gnb;
+
+TEST_CASE("row bands cover all rows exactly once", "[parallel]") {
+    for (std::size_t height : {0, 1, 7, 100, 1001}) {
+        for (unsigned nbands : {1u, 2u, 3u, 8u, 200u}) {
+            std::size_t next = 0;
+            for (unsigned k = 0; k < nbands; ++k) {
+                row_band b = row_band_of(height, k, nbands);
+                REQUIRE(b.begin == next);
+                REQUIRE(b.end >= b.begin);
+                REQUIRE(b.end - b.begin <= height / nbands + 1);
+                next = b.end;
+            }
+            REQUIRE(next == height);
+        }
+    }
+}
+
+TEST_CASE("parallel_row_bands visits every row", "[parallel]") {
+    std::vector<std::atomic<int>> seen(37);
+    for (auto& s : seen) s = 0;
+    parallel_row_bands(seen.size(), 4, [&](unsigned, row_band b) {
+        for (auto y = b.begin; y < b.end; ++y) ++seen[y];
+    });
+    REQUIRE(std::all_of(seen.begin(), seen.end(), [](const std::atomic<int>& s) { return s == 1; }));
+}
+
+TEST_CASE("parallel_row_bands rethrows", "[parallel]") {
+    REQUIRE_THROWS_AS(parallel_row_bands(10, 3, [](unsigned k, row_band) {
+        if (k == 2) throw std::out_of_range("band");
+    }), std::out_of_range);
+}
+
+TEST_CASE("make_first_touch with hugepage_allocator", "[numa]") {
+    // Big enough to be mmap()ed
+    auto r = make_first_touch<double>(1000, 1000, 2.5, 3);
+
+    REQUIRE(r.height() == 1000);
+    REQUIRE(r.width() == 1000);
+    REQUIRE(r.invariants());
+    REQUIRE(std::count(r.begin(), r.end(), 2.5) == 1000000);
+
+    // Later value-initialisation is back to normal
+    r.resize(1001, 1000);
+    REQUIRE(r.at(1000, 999) == 0.0);
+}
+
+TEST_CASE("make_first_touch small and empty", "[numa]") {
+    auto r = make_first_touch<int>(3, 2, 7, 8);
+    REQUIRE(std::count(r.begin(), r.end(), 7) == 6);
+
+    auto e = make_first_touch<int>(0, 5, 7, 4);
+    REQUIRE(e.size() == 0);
+    REQUIRE(e.width() == 5);
+}
+
+TEST_CASE("make_first_touch with std::allocator", "[numa]") {
+    auto r = make_first_touch<int, std::allocator<int>>(50, 40, -1, 4);
+    REQUIRE(std::count(r.begin(), r.end(), -1) == 2000);
+}
+
+TEST_CASE("hugepage_allocator numa placement", "[numa]") {
+    using A = hugepage_allocator<double>;
+    // Node 0 always exists; mbind() may still be refused in a container
+    A a{hugepage_mode::none, numa_placement{numa_policy::interleave, 1}};
+    auto r = make_first_touch<double>(1000, 1000, 1.0, 2, a);
+
+    REQUIRE(r.get_allocator().numa().policy == numa_policy::interleave);
+    REQUIRE(std::count(r.begin(), r.end(), 1.0) == 1000000);
+
+    A local;
+    auto l = make_first_touch<double>(1000, 1000, 1.0, 2, local);
+    REQUIRE(!l.get_allocator().info().numa_applied);
+}
+
+TEST_CASE("make_first_touch keeps its deferral to itself", "[numa]") {
+    using A = hugepage_allocator<double>;
+    A a{hugepage_mode::none};
+    auto r = make_first_touch<double>(1000, 1000, 1.0, 2, a);
+    // The grid's allocator is not shared with a, which still reports its own state
+    REQUIRE(a.info().kind == page_kind::normal);
+    std::vector<double, A> v(1000000, a);
+    REQUIRE(std::count(v.begin(), v.end(), 0.0) == 1000000);
+    REQUIRE(std::count(r.begin(), r.end(), 1.0) == 1000000);
+}
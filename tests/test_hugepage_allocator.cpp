@@ -0,0 +1,62 @@
+#include "catch.hpp"
+
+#include "rectangular.hpp"
+#include "rectangular_alloc.hpp"
+
+#include <algorithm>
+
+using namespace gnb;
+
+using A = hugepage_allocator<double>;
+using HR = rectangular<double, A>;
+
+// Big enough to go via mmap()
+static const std::size_t big_rows = 1024, big_cols = 1024;
+
+TEST_CASE("hugepage small allocation uses normal pages", "[hugepage]") {
+    HR r{10, 10, 1.5};
+
+    REQUIRE(r.at(9, 9) == 1.5);
+    REQUIRE(r.get_allocator().info().kind == page_kind::normal);
+}
+
+TEST_CASE("hugepage mode none uses normal pages", "[hugepage]") {
+    std::vector<double, A> vec{A{hugepage_mode::none}};
+    vec.resize(big_rows * big_cols, 2.0);
+    HR r{big_rows, big_cols, vec};
+
+    REQUIRE(r.get_allocator().info().kind == page_kind::normal);
+    REQUIRE(r.get_allocator().info().page_size >= 4096);
+    REQUIRE(r.at(big_rows - 1, big_cols - 1) == 2.0);
+}
+
+TEST_CASE("hugepage large allocation falls back cleanly", "[hugepage]") {
+    HR r{big_rows, big_cols, 3.0};
+    auto info = r.get_allocator().info();
+
+    // Which kind we get depends on the host, but it must be consistent
+    if (info.kind == page_kind::normal)
+        REQUIRE(info.page_size < A::huge_page_size);
+    else
+        REQUIRE(info.page_size == A::huge_page_size);
+
+    REQUIRE(std::count(r.begin(), r.end(), 3.0) == static_cast<long>(r.size()));
+    r[big_rows / 2][big_cols / 2] = 7.0;
+    REQUIRE(r.at(big_rows / 2, big_cols / 2) == 7.0);
+}
+
+TEST_CASE("hugepage resize and copy", "[hugepage]") {
+    HR r{big_rows, big_cols, 1.0};
+    r.resize(2 * big_rows, big_cols, 4.0);
+
+    REQUIRE(r.invariants());
+    REQUIRE(r.at(0, 0) == 1.0);
+    REQUIRE(r.at(2 * big_rows - 1, 0) == 4.0);
+
+    HR c{r};
+    REQUIRE(c.at(2 * big_rows - 1, 0) == 4.0);
+    r.resize(1, 1);
+    REQUIRE(c.size() == 2 * big_rows * big_cols);
+    // The copy has its own allocator state
+    REQUIRE(c.get_allocator().info().page_size >= 4096);
+}
@@ -2,6 +2,9 @@
 
 #include "rectangular.hpp"
 
+#include <limits>
+#include <string>
+
 using namespace gnb;
 
 using R = rectangular<unsigned char>;
@@ -185,3 +188,115 @@ TEST_CASE("rectangular swap", "[rectangular]") {
     REQUIRE(y.invariants());
 }   
 
+
+TEST_CASE("rectangular insert and erase rows", "[rectangular]") {
+    R i{2, 3, {1, 2, 3,
+               4, 5, 6}};
+    i.insert_rows(1, 2, 9);
+    REQUIRE(i.height() == 4);
+    REQUIRE(i.width() == 3);
+    REQUIRE(i[0][2] == 3);
+    REQUIRE(i[1][0] == 9);
+    REQUIRE(i[2][2] == 9);
+    REQUIRE(i[3][0] == 4);
+    REQUIRE(i.invariants());
+
+    i.insert_rows(4, 1, 7); // append
+    REQUIRE(i.height() == 5);
+    REQUIRE(i[4][1] == 7);
+
+    i.erase_rows(0, 3);
+    REQUIRE(i.height() == 2);
+    REQUIRE(i[0][0] == 4);
+    REQUIRE(i[1][2] == 7);
+    REQUIRE(i.invariants());
+
+    REQUIRE_THROWS_AS(i.insert_rows(3, 1), std::out_of_range);
+    REQUIRE_THROWS_AS(i.erase_rows(1, 2), std::out_of_range);
+    REQUIRE_THROWS_AS(i.erase_rows(3, 0), std::out_of_range);
+    i.erase_rows(2, 0);
+    REQUIRE(i.height() == 2);
+}
+
+TEST_CASE("rectangular insert and erase columns", "[rectangular]") {
+    R i{2, 3, {1, 2, 3,
+               4, 5, 6}};
+    i.insert_cols(1, 2, 9);
+    REQUIRE(i.width() == 5);
+    REQUIRE(std::equal(i.begin(), i.end(), std::string("\x01\x09\x09\x02\x03\x04\x09\x09\x05\x06").begin()));
+    REQUIRE(i.invariants());
+
+    i.insert_cols(5, 1, 8); // append
+    i.insert_cols(0, 1, 7); // prepend
+    REQUIRE(i.width() == 7);
+    REQUIRE(i[0][0] == 7);
+    REQUIRE(i[0][6] == 8);
+    REQUIRE(i[1][1] == 4);
+
+    i.erase_cols(1, 4);
+    REQUIRE(i.width() == 3);
+    REQUIRE(std::equal(i.begin(), i.end(), std::string("\x07\x03\x08\x07\x06\x08").begin()));
+    REQUIRE(i.invariants());
+
+    REQUIRE_THROWS_AS(i.insert_cols(4, 1), std::out_of_range);
+    REQUIRE_THROWS_AS(i.erase_cols(2, 2), std::out_of_range);
+
+    // Down to no columns and back again
+    i.erase_cols(0, 3);
+    REQUIRE(i.height() == 2);
+    REQUIRE(i.width() == 0);
+    REQUIRE(i.empty());
+    i.insert_cols(0, 2, 5);
+    REQUIRE(i.size() == 4);
+    REQUIRE(i[1][1] == 5);
+}
+
+TEST_CASE("rectangular insert and erase non trivial types", "[rectangular]") {
+    rectangular<std::string> s{2, 2, {"a", "b", "c", "d"}};
+    s.insert_cols(1, 1, "x");
+    s.insert_rows(0, 1, "y");
+    REQUIRE(s.height() == 3);
+    REQUIRE(s.width() == 3);
+    REQUIRE(s[1][0] == "a");
+    REQUIRE(s[1][1] == "x");
+    REQUIRE(s[2][2] == "d");
+    s.erase_cols(0, 1);
+    s.erase_rows(0, 1);
+    REQUIRE(s[0][0] == "x");
+    REQUIRE(s[1][1] == "d");
+}
+
+TEST_CASE("rectangular reserve", "[rectangular]") {
+    R i{0, 100};
+    i.reserve(50, 100);
+    const unsigned char* before = i.data();
+    for (int y = 0; y < 50; ++y) i.insert_rows(i.height(), 1, static_cast<unsigned char>(y));
+    REQUIRE(i.height() == 50);
+    REQUIRE(i.data() == before);
+    REQUIRE(i[49][99] == 49);
+}
+
+TEST_CASE("rectangular equality", "[rectangular]") {
+    R a{2, 3, {1, 2, 3, 4, 5, 6}};
+    R b{2, 3, {1, 2, 3, 4, 5, 6}};
+    REQUIRE(a == b);
+    REQUIRE(!(a != b));
+    b[1][2] = 7;
+    REQUIRE(a != b);
+    // Same elements, different shape
+    R c{3, 2, {1, 2, 3, 4, 5, 6}};
+    REQUIRE(a != c);
+    REQUIRE(R{0, 3} != R{0, 2});
+    REQUIRE(R{} == R{});
+
+    // Compared by value, not by bytes
+    rectangular<double> z{1, 2, {0.0, 1.0}}, nz{1, 2, {-0.0, 1.0}};
+    REQUIRE(z == nz);
+    z[0][1] = std::numeric_limits<double>::quiet_NaN();
+    REQUIRE(z != z);
+
+    rectangular<std::string> s{1, 2, {"a", "b"}};
+    REQUIRE(s == (rectangular<std::string>{1, 2, {"a", "b"}}));
+    checked_rectangular<unsigned char> ca{2, 3, {1, 2, 3, 4, 5, 6}};
+    REQUIRE(ca == a);
+}
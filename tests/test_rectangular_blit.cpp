@@ -0,0 +1,81 @@
+#include "catch.hpp"
+
+#include "rectangular_blit.hpp"
+
+#include <string>
+
+using namespace gnb;
+
+namespace {
+
+rectangular<int> numbered(std::size_t h, std::size_t w) {
+    rectangular<int> r{h, w};
+    int n = 0;
+    for (auto& v : r) v = n++;
+    return r;
+}
+
+// The obvious element-by-element copy, via a temporary so overlap is safe
+template <typename T>
+void reference_copy(const rectangular<T>& src, std::size_t sy, std::size_t sx, std::size_t h, std::size_t w,
+        rectangular<T>& dst, std::size_t dy, std::size_t dx) {
+    rectangular<T> tmp{h, w};
+    for (std::size_t y = 0; y < h; ++y)
+        for (std::size_t x = 0; x < w; ++x) tmp.at(y, x) = src.at(sy + y, sx + x);
+    for (std::size_t y = 0; y < h; ++y)
+        for (std::size_t x = 0; x < w; ++x) dst.at(dy + y, dx + x) = tmp.at(y, x);
+}
+
+}
+
+TEST_CASE("blit between grids", "[blit]") {
+    auto src = numbered(10, 12);
+    rectangular<int> dst{8, 9, -1};
+    copy_region(src, 2, 3, 4, 5, dst, 1, 4);
+
+    rectangular<int> expect{8, 9, -1};
+    reference_copy(src, 2, 3, 4, 5, expect, 1, 4);
+    REQUIRE(std::equal(dst.begin(), dst.end(), expect.begin()));
+    REQUIRE(dst[1][4] == src[2][3]);
+    REQUIRE(dst[4][8] == src[5][7]);
+    REQUIRE(dst[0][4] == -1);
+    REQUIRE(dst[5][4] == -1);
+}
+
+TEST_CASE("blit overlapping within one grid", "[blit]") {
+    // Every direction of overlap, including within a row
+    for (std::size_t dy : {0, 1, 2, 3, 4})
+        for (std::size_t dx : {0, 1, 2, 3, 4}) {
+            auto r = numbered(9, 11);
+            auto expect = r;
+            copy_region(r, 2, 2, 5, 7, r, dy, dx);
+            reference_copy(expect, 2, 2, 5, 7, expect, dy, dx);
+            REQUIRE(std::equal(r.begin(), r.end(), expect.begin()));
+        }
+}
+
+TEST_CASE("blit non trivially copyable", "[blit]") {
+    rectangular<std::string> r{4, 4};
+    for (std::size_t y = 0; y < 4; ++y)
+        for (std::size_t x = 0; x < 4; ++x) r[y][x] = std::to_string(y * 4 + x);
+    auto expect = r;
+    copy_region(r, 0, 0, 3, 3, r, 1, 1);
+    reference_copy(expect, 0, 0, 3, 3, expect, 1, 1);
+    REQUIRE(std::equal(r.begin(), r.end(), expect.begin()));
+    REQUIRE(r[3][3] == "10");
+}
+
+TEST_CASE("blit bounds", "[blit]") {
+    auto src = numbered(5, 5);
+    rectangular<int> dst{3, 3};
+    REQUIRE_THROWS_AS(copy_region(src, 0, 0, 4, 1, dst, 0, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(copy_region(src, 0, 0, 1, 4, dst, 0, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(copy_region(src, 3, 0, 3, 1, dst, 0, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(copy_region(src, 0, 0, 2, 2, dst, 2, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(copy_region(src, 0, std::size_t(-1), 1, 2, dst, 0, 0), std::out_of_range);
+
+    // Empty regions are fine anywhere up to the edge
+    copy_region(src, 5, 5, 0, 0, dst, 3, 3);
+    copy_region(src, 0, 0, 3, 3, dst, 0, 0);
+    REQUIRE(dst[2][2] == 12);
+}
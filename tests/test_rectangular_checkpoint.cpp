@@ -0,0 +1,99 @@
+#include "catch.hpp"
+
+#include "rectangular_checkpoint.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+using namespace gnb;
+
+namespace {
+
+const char* const tmp_path = "test_checkpoint.tmp";
+
+// Removes the scratch file however the test ends
+struct scratch_file {
+    ~scratch_file() { std::remove(tmp_path); }
+};
+
+rectangular<std::uint32_t> numbered(std::size_t h, std::size_t w) {
+    rectangular<std::uint32_t> r{h, w};
+    for (std::size_t i = 0; i < r.size(); ++i) r.data()[i] = static_cast<std::uint32_t>(i * 2654435761u);
+    return r;
+}
+
+}
+
+TEST_CASE("checkpoint save and load", "[checkpoint]") {
+    scratch_file scratch;
+    // Bigger than one write piece, and not a whole number of them
+    for (checkpoint_io how : {checkpoint_io::automatic, checkpoint_io::pwrite}) {
+        auto world = numbered(700, 513);
+        const auto expected = world;
+        auto done = save_async(tmp_path, world, how);
+        // The snapshot is taken, so this does not reach the file
+        world.fill(0);
+        done.get();
+        REQUIRE(load_checkpoint<std::uint32_t>(tmp_path) == expected);
+    }
+
+    auto moved = numbered(3, 5);
+    const auto expected = moved;
+    save_async(tmp_path, std::move(moved)).get();
+    REQUIRE(load_checkpoint<std::uint32_t>(tmp_path) == expected);
+
+    save_async(tmp_path, rectangular<double>{}).get();
+    REQUIRE(load_checkpoint<double>(tmp_path).empty());
+}
+
+TEST_CASE("checkpoint of cow_rectangular", "[checkpoint]") {
+    scratch_file scratch;
+    cow_rectangular<std::uint32_t> cow{numbered(300, 300), 16};
+    const auto expected = cow.to_rectangular();
+    auto done = save_async(tmp_path, cow);
+    // Goes to the caller's own copy of one band while the snapshot is written
+    cow.at(40, 40) = 12345;
+    done.get();
+    REQUIRE(load_checkpoint<std::uint32_t>(tmp_path) == expected);
+    REQUIRE(cow.at(40, 40) == 12345);
+    REQUIRE(cow.shared_bands() == 0);
+}
+
+TEST_CASE("overlapping checkpoints to one path", "[checkpoint]") {
+    scratch_file scratch;
+    const auto first = numbered(600, 600);
+    auto second = first;
+    second.fill(7);
+    auto a = save_async(tmp_path, first);
+    auto b = save_async(tmp_path, second);
+    a.get();
+    b.get();
+    // Whichever rename came last, the file is all of one save
+    const auto loaded = load_checkpoint<std::uint32_t>(tmp_path);
+    REQUIRE((loaded == first || loaded == second));
+}
+
+TEST_CASE("checkpoint errors", "[checkpoint]") {
+    scratch_file scratch;
+    auto bad = save_async("no/such/dir/file.ckpt", numbered(2, 2));
+    REQUIRE_THROWS_AS(bad.get(), std::runtime_error);
+
+    save_async(tmp_path, numbered(4, 4)).get();
+    REQUIRE_THROWS_AS(load_checkpoint<std::uint64_t>(tmp_path), std::runtime_error);
+    REQUIRE_THROWS_AS(load_checkpoint<std::uint32_t>("no/such/file.ckpt"), std::runtime_error);
+
+    // A header asking for far more than the file holds fails before allocating
+    save_async(tmp_path, numbered(4, 4)).get();
+    std::FILE* f = std::fopen(tmp_path, "r+b");
+    const std::uint64_t huge[2] = {std::uint64_t(1) << 28, std::uint64_t(1) << 28};
+    std::fseek(f, 8, SEEK_SET);
+    std::fwrite(huge, sizeof huge, 1, f);
+    std::fclose(f);
+    REQUIRE_THROWS_AS(load_checkpoint<std::uint32_t>(tmp_path), std::runtime_error);
+
+    f = std::fopen(tmp_path, "wb");
+    std::fputs("not a checkpoint at all", f);
+    std::fclose(f);
+    REQUIRE_THROWS_AS(load_checkpoint<std::uint32_t>(tmp_path), std::runtime_error);
+}
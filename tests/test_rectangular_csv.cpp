@@ -0,0 +1,132 @@
+#include "catch.hpp"
+
+#include "rectangular_csv.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+
+using namespace gnb;
+
+namespace {
+
+const char* const tmp_path = "test_csv.tmp";
+
+// Removes the scratch file however the test ends
+struct scratch_file {
+    ~scratch_file() { std::remove(tmp_path); }
+};
+
+std::string slurp(const char* path) {
+    std::string s;
+    if (std::FILE* f = std::fopen(path, "rb")) {
+        char buf[4096];
+        std::size_t n;
+        while ((n = std::fread(buf, 1, sizeof buf, f)) > 0) s.append(buf, n);
+        std::fclose(f);
+    }
+    return s;
+}
+
+void spit(const char* path, const std::string& s) {
+    std::FILE* f = std::fopen(path, "wb");
+    std::fwrite(s.data(), 1, s.size(), f);
+    std::fclose(f);
+}
+
+}
+
+TEST_CASE("csv parse", "[csv]") {
+    auto r = parse_csv<int>("1,2,3\n4,5,6\n");
+    REQUIRE(r == rectangular<int>(2, 3, {1, 2, 3, 4, 5, 6}));
+
+    // Blanks around fields, CRLF, blank lines and no final newline
+    auto s = parse_csv<double>("\n 1.5 , -2\r\n\r\n3e2,\t0.25 \r\n\n4,5");
+    REQUIRE(s == rectangular<double>(3, 2, {1.5, -2, 300, 0.25, 4, 5}));
+
+    auto t = parse_csv<float>("1\t2\n3\t4\n", '\t');
+    REQUIRE(t == rectangular<float>(2, 2, {1, 2, 3, 4}));
+
+    REQUIRE(parse_csv<int>("").empty());
+    REQUIRE(parse_csv<int>("\n \n").empty());
+
+    auto limits = parse_csv<std::int8_t>("-128,127,0,-0");
+    REQUIRE(limits == rectangular<std::int8_t>(1, 4, {-128, 127, 0, 0}));
+    auto big = parse_csv<std::uint64_t>("18446744073709551615");
+    REQUIRE(big[0][0] == std::numeric_limits<std::uint64_t>::max());
+}
+
+TEST_CASE("csv errors", "[csv]") {
+    REQUIRE_THROWS_AS(parse_csv<int>("1,2\n3\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(parse_csv<int>("1,2\n3,4,5\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(parse_csv<int>("1,,2\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(parse_csv<int>("1,2,\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(parse_csv<int>("1,x\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(parse_csv<int>("1 2\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(parse_csv<std::uint8_t>("256\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(parse_csv<std::uint8_t>("-1\n"), std::runtime_error);
+    REQUIRE_THROWS_AS(read_csv<int>("no/such/file.csv"), std::runtime_error);
+
+    // The message names the line, counting blank ones
+    try {
+        parse_csv<int>("1,2\n\n3,4\n5\n", ',', 3);
+        FAIL("no exception");
+    } catch (const std::runtime_error& e) {
+        REQUIRE(std::string(e.what()).find("line 4") != std::string::npos);
+    }
+
+    // A wide first row doesn't size the grid before the narrow rows are seen
+    std::string wide(200000, ',');
+    wide += '\n';
+    for (int i = 0; i < 200000; ++i) wide += "1\n";
+    try {
+        parse_csv<double>(wide, ',', 4);
+        FAIL("no exception");
+    } catch (const std::runtime_error& e) {
+        REQUIRE(std::string(e.what()).find("line 2:") != std::string::npos);
+    }
+}
+
+TEST_CASE("csv round trip", "[csv]") {
+    scratch_file scratch;
+    std::mt19937 gen{7};
+    std::uniform_real_distribution<double> dist(-1e6, 1e6);
+
+    rectangular<double> d{37, 11};
+    for (double& v : d) v = dist(gen) / 7;
+    write_csv(tmp_path, d);
+    REQUIRE(read_csv<double>(tmp_path) == d);
+
+    rectangular<float> f{5, 4};
+    for (float& v : f) v = static_cast<float>(dist(gen) / 3);
+    write_csv(tmp_path, f, '\t');
+    REQUIRE(read_csv<float>(tmp_path, '\t') == f);
+
+    rectangular<long long> i{3, 3, {std::numeric_limits<long long>::min(), -1, 0, 1, 42,
+        std::numeric_limits<long long>::max(), 7, 8, 9}};
+    write_csv(tmp_path, i);
+    REQUIRE(slurp(tmp_path).substr(0, 24) == "-9223372036854775808,-1,");
+    REQUIRE(read_csv<long long>(tmp_path) == i);
+
+    rectangular<int> empty;
+    write_csv(tmp_path, empty);
+    REQUIRE(slurp(tmp_path).empty());
+    REQUIRE(read_csv<int>(tmp_path).empty());
+}
+
+TEST_CASE("csv parallel parse", "[csv]") {
+    scratch_file scratch;
+    rectangular<int> big{1000, 17};
+    int n = 0;
+    for (int& v : big) v = n++ * 31 - 5000;
+    write_csv(tmp_path, big);
+    // With blank lines, so chunks hold different numbers of rows
+    std::string text = slurp(tmp_path);
+    text.insert(text.find('\n', text.size() / 3) + 1, "\n\n\r\n");
+    spit(tmp_path, text);
+    for (unsigned bands : {1u, 2u, 3u, 8u, 64u, 5000u})
+        REQUIRE(read_csv<int>(tmp_path, ',', bands) == big);
+    REQUIRE(parse_csv<int>("1\n", ',', 8) == rectangular<int>(1, 1, {1}));
+}
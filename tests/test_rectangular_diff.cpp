@@ -0,0 +1,145 @@
+#include "catch.hpp"
+
+#include "rectangular_diff.hpp"
+#include "simd_level_guard.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+using namespace gnb;
+
+namespace {
+
+// Change about one cell in every `every`, in clumps
+template <typename T>
+rectangular<T> mutate(const rectangular<T>& r, unsigned every, unsigned seed) {
+    std::mt19937 gen{seed};
+    rectangular<T> out = r;
+    for (std::size_t i = 0; i < out.size(); ++i)
+        if (gen() % every == 0)
+            for (std::size_t k = i; k < std::min(out.size(), i + gen() % 5 + 1); ++k)
+                out.data()[k] = static_cast<T>(out.data()[k] + 1);
+    return out;
+}
+
+template <typename T>
+void check_diff(const rectangular<T>& a, const rectangular<T>& b) {
+    auto regions = diff(a, b);
+    // Every changed cell is in a region, every region's rows and columns are tight
+    std::vector<bool> covered(a.size());
+    for (std::size_t k = 0; k < regions.size(); ++k) {
+        const region& r = regions[k];
+        if (k > 0) REQUIRE(regions[k - 1].y + regions[k - 1].height < r.y);
+        bool left = false, right = false;
+        for (std::size_t y = r.y; y < r.y + r.height; ++y) {
+            bool any = false;
+            for (std::size_t x = r.x; x < r.x + r.width; ++x) {
+                covered[y * a.width() + x] = true;
+                if (a[y][x] != b[y][x]) {
+                    any = true;
+                    left = left || x == r.x;
+                    right = right || x + 1 == r.x + r.width;
+                }
+            }
+            REQUIRE(any);
+        }
+        REQUIRE(left);
+        REQUIRE(right);
+    }
+    for (std::size_t i = 0; i < a.size(); ++i)
+        if (a.data()[i] != b.data()[i]) REQUIRE(covered[i]);
+
+    auto cs = make_changeset(a, b);
+    rectangular<T> c = a;
+    apply_changeset(c, cs);
+    REQUIRE(c == b);
+    REQUIRE(cs.empty() == (a == b));
+}
+
+}
+
+TEST_CASE("diff and changeset", "[diff]") {
+    level_guard guard;
+    for (simd_level l : {simd_level::scalar, simd_level::sse2, simd_level::avx2}) {
+        set_simd_level(l);
+        for (std::size_t w : {1, 15, 33, 100})
+            for (unsigned every : {3, 50, 1000}) {
+                rectangular<std::uint8_t> a{40, w};
+                std::mt19937 gen{every};
+                for (auto& v : a) v = static_cast<std::uint8_t>(gen());
+                check_diff(a, mutate(a, every, static_cast<unsigned>(w)));
+                rectangular<std::int32_t> b{17, w, 5};
+                check_diff(b, mutate(b, every, static_cast<unsigned>(w + 1)));
+            }
+    }
+}
+
+TEST_CASE("diff regions", "[diff]") {
+    rectangular<int> a{6, 8}, b{6, 8};
+    REQUIRE(diff(a, b).empty());
+    b[1][2] = 1;
+    b[2][6] = 1;
+    b[4][0] = 1;
+    auto r = diff(a, b);
+    REQUIRE(r.size() == 2);
+    REQUIRE(r[0] == (region{1, 2, 2, 5}));
+    REQUIRE(r[1] == (region{4, 0, 1, 1}));
+}
+
+TEST_CASE("changeset joins nearby runs", "[diff]") {
+    rectangular<std::uint8_t> a{1, 100}, b{1, 100};
+    b[0][10] = b[0][12] = 1; // two apart, cheaper as one run
+    b[0][80] = 1;
+    auto cs = make_changeset(a, b);
+    REQUIRE(cs.runs.size() == 2);
+    REQUIRE(cs.runs[0].index == 10);
+    REQUIRE(cs.runs[0].count == 3);
+    REQUIRE(cs.runs[1].index == 80);
+    REQUIRE(cs.values.size() == 4);
+
+    // Wide elements are not worth joining across a gap
+    rectangular<std::string> s{1, 4}, t{1, 4, {"a", "", "b", ""}};
+    auto ts = make_changeset(s, t);
+    REQUIRE(ts.runs.size() == 2);
+    check_diff(s, t);
+}
+
+TEST_CASE("changeset compares floating point by bits", "[diff]") {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    rectangular<double> a{1, 3, {0.0, nan, 1.0}}, b{1, 3, {-0.0, nan, 1.0}};
+    auto cs = make_changeset(a, b);
+    REQUIRE(cs.runs.size() == 1);
+    REQUIRE(cs.runs[0].index == 0);
+    REQUIRE(cs.runs[0].count == 1);
+    REQUIRE(make_changeset(a, a).empty());
+}
+
+TEST_CASE("long double compares by value", "[diff]") {
+    // Same values, different padding bytes
+    rectangular<long double> a{2, 3}, b{2, 3};
+    std::memset(a.data(), 0xff, a.size() * sizeof(long double));
+    std::memset(b.data(), 0, b.size() * sizeof(long double));
+    for (std::size_t i = 0; i < a.size(); ++i) a.data()[i] = b.data()[i] = 1.5L * i;
+    REQUIRE(diff(a, b).empty());
+    REQUIRE(make_changeset(a, b).empty());
+    b.at(1, 2) = 0.0L;
+    REQUIRE(make_changeset(a, b).runs.size() == 1);
+}
+
+TEST_CASE("changeset errors", "[diff]") {
+    rectangular<int> a{2, 3}, b{3, 2};
+    REQUIRE_THROWS_AS(diff(a, b), std::out_of_range);
+    REQUIRE_THROWS_AS(make_changeset(a, b), std::out_of_range);
+
+    rectangular<int> c{2, 3, 1};
+    auto cs = make_changeset(a, c);
+    REQUIRE_THROWS_AS(apply_changeset(b, cs), std::out_of_range);
+    cs.runs.push_back(change_run{5, 2});
+    cs.values.push_back(7);
+    cs.values.push_back(7);
+    REQUIRE_THROWS_AS(apply_changeset(a, cs), std::out_of_range);
+    REQUIRE(a == (rectangular<int>{2, 3}));
+}
@@ -0,0 +1,100 @@
+#include "catch.hpp"
+
+#include "rectangular_expr.hpp"
+
+#include <cstdint>
+
+using namespace gnb;
+
+using F = rectangular<float>;
+
+TEST_CASE("expression evaluate", "[expr]") {
+    F a{2, 3, {1, 2, 3, 4, 5, 6}};
+    F b{2, 3, {10, 20, 30, 40, 50, 60}};
+
+    F out = a * 2.0f + b;
+
+    REQUIRE(out.height() == 2);
+    REQUIRE(out.width() == 3);
+    REQUIRE(out.at(0, 0) == 12);
+    REQUIRE(out.at(1, 2) == 72);
+
+    auto e = evaluate(b / a - 1.0f);
+    REQUIRE(e.at(1, 1) == 9);
+    REQUIRE(e.at(0, 2) == 9);
+}
+
+TEST_CASE("expression scalar on either side", "[expr]") {
+    F a{1, 2, {2, 4}};
+
+    F l = 8.0f / a;
+    F r = a - 1.0f;
+    F s = 1.0f - a;
+
+    REQUIRE(l.at(0, 0) == 4);
+    REQUIRE(l.at(0, 1) == 2);
+    REQUIRE(r.at(0, 1) == 3);
+    REQUIRE(s.at(0, 1) == -3);
+}
+
+TEST_CASE("expression unary minus", "[expr]") {
+    F a{1, 2, {2, 4}};
+    F n = -a;
+    F m = -(a + a);
+
+    REQUIRE(n.at(0, 1) == -4);
+    REQUIRE(m.at(0, 0) == -4);
+}
+
+TEST_CASE("expression shape mismatch throws", "[expr]") {
+    F a{2, 3};
+    F b{3, 2};
+    F c{2, 3};
+
+    REQUIRE_THROWS_AS(a + b, std::out_of_range);
+    REQUIRE_THROWS_AS((a + c) * b, std::out_of_range);
+    REQUIRE_THROWS_AS(assign(b, a + c), std::out_of_range);
+}
+
+TEST_CASE("expression assign reuses buffer and allows aliasing", "[expr]") {
+    F a{2, 2, {1, 2, 3, 4}};
+    F b{2, 2, 1};
+    const float* buf = a.data();
+
+    assign(a, a * 2.0f + b);
+
+    REQUIRE(a.data() == buf);
+    REQUIRE(a.at(0, 0) == 3);
+    REQUIRE(a.at(1, 1) == 9);
+
+    a = a - b;      // conversion then move-assignment
+    REQUIRE(a.at(1, 1) == 8);
+}
+
+TEST_CASE("expression type promotion", "[expr]") {
+    rectangular<std::uint8_t> a{1, 2, {200, 100}};
+    rectangular<std::uint8_t> b{1, 2, {100, 100}};
+
+    auto sum = evaluate(a + b);
+    static_assert(std::is_same<decltype(sum), rectangular<int> >::value, "uint8 + uint8 is int");
+    REQUIRE(sum.at(0, 0) == 300);
+
+    // Narrowing on assignment into the destination type
+    rectangular<std::uint8_t> half = (a + b) / 2;
+    REQUIRE(half.at(0, 0) == 150);
+
+    rectangular<double> mixed = a * 0.5;
+    REQUIRE(mixed.at(0, 1) == 50.0);
+}
+
+TEST_CASE("expression with checked_rectangular", "[expr]") {
+    checked_rectangular<int> a{2, 2, 3};
+    rectangular<int> r = a * a;
+    REQUIRE(r.at(1, 1) == 9);
+}
+
+TEST_CASE("expression empty", "[expr]") {
+    F a;
+    F b = a + a;
+    REQUIRE(b.size() == 0);
+}
@@ -0,0 +1,156 @@
+#include "catch.hpp"
+
+#include "rectangular_geometry.hpp"
+#include "simd_level_guard.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+using namespace gnb;
+
+namespace {
+
+template <typename T>
+rectangular<T> numbered(std::size_t h, std::size_t w) {
+    rectangular<T> r{h, w};
+    std::mt19937 gen{static_cast<unsigned>(h * 1000 + w)};
+    for (auto& v : r) v = static_cast<T>(gen() % 251);
+    return r;
+}
+
+template <>
+rectangular<std::string> numbered<std::string>(std::size_t h, std::size_t w) {
+    rectangular<std::string> r{h, w};
+    for (std::size_t y = 0; y < h; ++y)
+        for (std::size_t x = 0; x < w; ++x) r[y][x] = std::to_string(y) + "," + std::to_string(x);
+    return r;
+}
+
+template <typename T>
+bool same(const rectangular<T>& a, const rectangular<T>& b) {
+    return a.height() == b.height() && a.width() == b.width() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+// Check every operation against the definitions, with plain loops
+template <typename T>
+void check_geometry(std::size_t h, std::size_t w) {
+    const rectangular<T> r = numbered<T>(h, w);
+
+    auto t = transpose(r);
+    auto cw = rotate90(r);
+    auto acw = rotate270(r);
+    REQUIRE(t.height() == w);
+    REQUIRE(t.width() == h);
+    REQUIRE(cw.height() == w);
+    REQUIRE(acw.width() == h);
+
+    auto half = r;
+    rotate180(half);
+    auto fh = r;
+    flip_horizontal(fh);
+    auto fv = r;
+    flip_vertical(fv);
+
+    rectangular<T> et{w, h}, ecw{w, h}, eacw{w, h}, ehalf{h, w}, efh{h, w}, efv{h, w};
+    for (std::size_t y = 0; y < h; ++y)
+        for (std::size_t x = 0; x < w; ++x) {
+            et[x][y] = r[y][x];
+            ecw[x][h - 1 - y] = r[y][x];
+            eacw[w - 1 - x][y] = r[y][x];
+            ehalf[h - 1 - y][w - 1 - x] = r[y][x];
+            efh[y][w - 1 - x] = r[y][x];
+            efv[h - 1 - y][x] = r[y][x];
+        }
+    REQUIRE(same(t, et));
+    REQUIRE(same(cw, ecw));
+    REQUIRE(same(acw, eacw));
+    REQUIRE(same(half, ehalf));
+    REQUIRE(same(fh, efh));
+    REQUIRE(same(fv, efv));
+
+    auto in_place = r;
+    rotate90_in_place(in_place);
+    REQUIRE(in_place.height() == w);
+    REQUIRE(same(in_place, ecw));
+    REQUIRE(in_place.invariants());
+
+    in_place = r;
+    transpose_in_place(in_place);
+    REQUIRE(in_place.height() == w);
+    REQUIRE(same(in_place, et));
+}
+
+// Sizes either side of the tile and block edges
+const std::size_t sizes[] = {1, 3, 4, 8, 15, 16, 17, 33, 64, 65, 100};
+
+}
+
+TEST_CASE("geometry uint8", "[geometry]") {
+    level_guard guard;
+    for (simd_level l : {simd_level::scalar, simd_level::sse2, simd_level::sse42, simd_level::avx2}) {
+        set_simd_level(l);
+        for (std::size_t h : sizes)
+            for (std::size_t w : {std::size_t{1}, std::size_t{16}, std::size_t{47}, std::size_t{64}, std::size_t{100}, h})
+                check_geometry<std::uint8_t>(h, w);
+    }
+}
+
+TEST_CASE("geometry 4 byte types", "[geometry]") {
+    level_guard guard;
+    for (simd_level l : {simd_level::scalar, simd_level::sse2, simd_level::avx2}) {
+        set_simd_level(l);
+        for (std::size_t h : sizes)
+            for (std::size_t w : {std::size_t{1}, std::size_t{8}, std::size_t{21}, h}) {
+                check_geometry<float>(h, w);
+                check_geometry<std::int32_t>(h, w);
+            }
+    }
+}
+
+TEST_CASE("geometry other types", "[geometry]") {
+    for (std::size_t h : {1, 7, 9, 20})
+        for (std::size_t w : {std::size_t{1}, std::size_t{10}, h}) {
+            check_geometry<double>(h, w);
+            check_geometry<std::uint16_t>(h, w);
+            check_geometry<std::string>(h, w);
+        }
+}
+
+TEST_CASE("geometry small examples", "[geometry]") {
+    rectangular<int> r{2, 3, {1, 2, 3,
+                              4, 5, 6}};
+    REQUIRE(same(rotate90(r), rectangular<int>{3, 2, {4, 1,
+                                                     5, 2,
+                                                     6, 3}}));
+    REQUIRE(same(rotate270(r), rectangular<int>{3, 2, {3, 6,
+                                                      2, 5,
+                                                      1, 4}}));
+    REQUIRE(same(transpose(r), rectangular<int>{3, 2, {1, 4,
+                                                      2, 5,
+                                                      3, 6}}));
+
+    rotate180(r);
+    REQUIRE(same(r, rectangular<int>{2, 3, {6, 5, 4, 3, 2, 1}}));
+
+    // Four quarter turns is the identity
+    auto s = numbered<std::uint8_t>(37, 37);
+    auto copy = s;
+    for (int i = 0; i < 4; ++i) rotate90_in_place(s);
+    REQUIRE(same(s, copy));
+}
+
+TEST_CASE("geometry empty", "[geometry]") {
+    rectangular<std::uint8_t> r{0, 5};
+    auto t = rotate90(r);
+    REQUIRE(t.height() == 5);
+    REQUIRE(t.width() == 0);
+    REQUIRE(rotate270(r).height() == 5);
+    REQUIRE(transpose(r).invariants());
+    rotate180(r);
+    flip_horizontal(r);
+    flip_vertical(r);
+    rotate90_in_place(r);
+    REQUIRE(r.height() == 5);
+    REQUIRE(r.empty());
+}
@@ -0,0 +1,92 @@
+#include "catch.hpp"
+
+#include "rectangular_hash.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace gnb;
+
+TEST_CASE("hash xxh64 reference values", "[hash]") {
+    REQUIRE(detail::xxh64("", 0, 0) == 0xEF46DB3751D8E999ULL);
+    REQUIRE(detail::xxh64("a", 1, 0) == 0xD24EC4F1A98C6E5BULL);
+    REQUIRE(detail::xxh64("abc", 3, 0) == 0x44BC2CF5AD770999ULL);
+    const std::string s = "Nobody inspects the spammish repetition";
+    REQUIRE(detail::xxh64(s.data(), s.size(), 0) == 0xFBCEA83C8A378BF1ULL);
+}
+
+TEST_CASE("hash depends on contents and shape", "[hash]") {
+    rectangular<std::uint8_t> a{2, 3, {1, 2, 3, 4, 5, 6}};
+    rectangular<std::uint8_t> b{3, 2, {1, 2, 3, 4, 5, 6}};
+    rectangular<std::uint8_t> c = a;
+    REQUIRE(hash(a) == hash(c));
+    REQUIRE(hash(a) != hash(b));
+    REQUIRE(hash(a) != hash(a, 1));
+    c[1][1] = 0;
+    REQUIRE(hash(a) != hash(c));
+    REQUIRE(hash(rectangular<int>{0, 3}) != hash(rectangular<int>{0, 4}));
+
+    std::unordered_map<rectangular<std::uint8_t>, int> cache;
+    cache[a] = 1;
+    cache[b] = 2;
+    REQUIRE(cache.at(rectangular<std::uint8_t>{2, 3, {1, 2, 3, 4, 5, 6}}) == 1);
+    REQUIRE(cache.size() == 2);
+}
+
+TEST_CASE("hash float keys agree with operator==", "[hash]") {
+    const rectangular<float> zero{1, 2, {0.0f, 1.0f}}, negative_zero{1, 2, {-0.0f, 1.0f}};
+    REQUIRE(zero == negative_zero);
+    REQUIRE(hash(zero) != hash(negative_zero)); // by bytes
+    REQUIRE(std::hash<rectangular<float> >()(zero) == std::hash<rectangular<float> >()(negative_zero));
+    REQUIRE(std::hash<rectangular<float> >()(zero) == hash(zero));
+
+    std::unordered_set<rectangular<double> > seen;
+    seen.insert(rectangular<double>{2, 2, {-0.0, 1.5, 2.5, -0.0}});
+    REQUIRE(seen.count(rectangular<double>{2, 2, {0.0, 1.5, 2.5, 0.0}}) == 1);
+    REQUIRE(seen.count(rectangular<double>{2, 2, {0.0, 1.5, 2.5, 1.0}}) == 0);
+
+    static_assert(!detail::hashable<long double>::value, "long double has padding bytes");
+}
+
+TEST_CASE("hash rows incrementally", "[hash]") {
+    std::mt19937 gen{1};
+    rectangular<float> r{50, 37};
+    for (auto& v : r) v = static_cast<float>(gen() % 1000);
+
+    row_hasher rows{7}, fresh{7};
+    const std::uint64_t h0 = rows.rehash(r);
+    REQUIRE(rows.height() == 50);
+    REQUIRE(rows.value() == h0);
+
+    r[3][4] = -1.0f;
+    r[40][0] = -2.0f;
+    const std::uint64_t h1 = rows.update(r, {3, 40});
+    REQUIRE(h1 != h0);
+    REQUIRE(h1 == fresh.rehash(r));
+
+    // Swapping two rows changes the value even though the row hashes are the same
+    std::swap_ranges(r[0], r[0] + r.width(), r[1]);
+    REQUIRE(rows.update(r, {0, 1}) != h1);
+    std::swap_ranges(r[0], r[0] + r.width(), r[1]);
+    REQUIRE(rows.update(r, {0, 1}) == h1);
+
+    // Shape changes rehash everything
+    r.resize(51, 37);
+    REQUIRE(rows.update(r, {}) == fresh.rehash(r));
+    REQUIRE(rows.height() == 51);
+    REQUIRE_THROWS_AS(rows.update(r, {51}), std::out_of_range);
+}
+
+TEST_CASE("hash rows of a tracked_rectangular", "[hash]") {
+    tracked_rectangular<int> t{20, 10};
+    row_hasher rows, fresh;
+    rows.rehash(t.contents());
+    t.at(5, 5) = 1;
+    t.at(12, 0) = 2;
+    REQUIRE(rows.update(t) == fresh.rehash(t.contents()));
+    t.clear_dirty();
+    REQUIRE(rows.update(t) == fresh.value());
+}
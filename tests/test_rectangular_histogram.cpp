@@ -0,0 +1,90 @@
+#include "catch.hpp"
+
+#include "rectangular_histogram.hpp"
+#include "simd_level_guard.hpp"
+
+#include <cstdint>
+#include <random>
+
+using namespace gnb;
+
+namespace {
+
+template <typename T>
+rectangular<T> random_image(std::size_t h, std::size_t w, unsigned range, unsigned seed) {
+    std::mt19937 gen{seed};
+    rectangular<T> r{h, w};
+    for (auto& v : r) v = static_cast<T>(gen() % range);
+    return r;
+}
+
+template <typename T>
+std::vector<std::uint64_t> reference_histogram(const rectangular<T>& r) {
+    std::vector<std::uint64_t> out(std::size_t(1) << (8 * sizeof(T)));
+    for (T v : r) ++out[v];
+    return out;
+}
+
+}
+
+TEST_CASE("histogram uint8", "[histogram]") {
+    for (std::size_t w : {1, 3, 64, 101})
+        for (unsigned range : {1, 7, 256}) {
+            auto img = random_image<std::uint8_t>(23, w, range, static_cast<unsigned>(w + range));
+            auto expect = reference_histogram(img);
+            for (unsigned bands : {1, 2, 5, 100}) REQUIRE(histogram(img, bands) == expect);
+        }
+    // A long run of one value, the worst case for a single table
+    rectangular<std::uint8_t> flat{100, 100, 42};
+    auto h = histogram(flat, 3);
+    REQUIRE(h.size() == 256);
+    REQUIRE(h[42] == 10000);
+    REQUIRE(histogram(rectangular<std::uint8_t>{0, 4}, 4)[0] == 0);
+}
+
+TEST_CASE("histogram uint16", "[histogram]") {
+    auto img = random_image<std::uint16_t>(31, 77, 65536, 9);
+    auto expect = reference_histogram(img);
+    REQUIRE(expect.size() == 65536);
+    REQUIRE(histogram(img) == expect);
+    REQUIRE(histogram(img, 4) == expect);
+
+    // Small and large grids in turn, re-using the same counting tables
+    for (unsigned seed = 0; seed < 20; ++seed) {
+        auto small = random_image<std::uint16_t>(3, 5, seed % 2 ? 4 : 65536, seed);
+        REQUIRE(histogram(small) == reference_histogram(small));
+        REQUIRE(histogram(img) == expect);
+    }
+}
+
+TEST_CASE("apply_lut uint8", "[histogram]") {
+    level_guard guard;
+    std::vector<std::uint8_t> lut(256);
+    std::mt19937 gen{1};
+    for (auto& v : lut) v = static_cast<std::uint8_t>(gen());
+    for (simd_level l : {simd_level::scalar, simd_level::sse42, simd_level::avx2}) {
+        set_simd_level(l);
+        for (std::size_t w : {1, 15, 16, 33, 100})
+            for (unsigned bands : {1, 3}) {
+                auto img = random_image<std::uint8_t>(9, w, 256, static_cast<unsigned>(w));
+                auto expect = img;
+                for (auto& v : expect) v = lut[v];
+                apply_lut(img, lut, bands);
+                REQUIRE(std::equal(img.begin(), img.end(), expect.begin()));
+            }
+    }
+}
+
+TEST_CASE("apply_lut uint16 and bad tables", "[histogram]") {
+    std::vector<std::uint16_t> lut(65536);
+    for (std::size_t i = 0; i < lut.size(); ++i) lut[i] = static_cast<std::uint16_t>(65535 - i);
+    auto img = random_image<std::uint16_t>(10, 20, 65536, 2);
+    auto expect = img;
+    for (auto& v : expect) v = static_cast<std::uint16_t>(65535 - v);
+    apply_lut(img, lut, 2);
+    REQUIRE(std::equal(img.begin(), img.end(), expect.begin()));
+
+    rectangular<std::uint8_t> small{2, 2};
+    REQUIRE_THROWS_AS(apply_lut(small, std::vector<std::uint8_t>(255)), std::out_of_range);
+    REQUIRE_THROWS_AS(apply_lut(img, std::vector<std::uint16_t>(256)), std::out_of_range);
+}
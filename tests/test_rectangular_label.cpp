@@ -0,0 +1,133 @@
+#include "catch.hpp"
+
+#include "rectangular_label.hpp"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace gnb;
+
+namespace {
+
+using Mask = rectangular<std::uint8_t>;
+
+Mask random_mask(std::size_t h, std::size_t w, unsigned density, unsigned seed) {
+    std::mt19937 gen{seed};
+    Mask m{h, w};
+    for (auto& v : m) v = gen() % 100 < density;
+    return m;
+}
+
+// Flood fill with an explicit stack, labelling in raster order
+rectangular<std::uint32_t> reference_labels(const Mask& m, connectivity conn) {
+    rectangular<std::uint32_t> lab{m.height(), m.width()};
+    std::uint32_t next = 0;
+    for (std::size_t y = 0; y < m.height(); ++y)
+        for (std::size_t x = 0; x < m.width(); ++x) {
+            if (!m[y][x] || lab[y][x]) continue;
+            ++next;
+            std::vector<std::pair<long, long> > stack{{y, x}};
+            lab[y][x] = next;
+            while (!stack.empty()) {
+                auto p = stack.back();
+                stack.pop_back();
+                for (long dy = -1; dy <= 1; ++dy)
+                    for (long dx = -1; dx <= 1; ++dx) {
+                        if ((dy == 0 && dx == 0) || (conn == connectivity::four && dy && dx)) continue;
+                        long ny = p.first + dy, nx = p.second + dx;
+                        if (ny < 0 || nx < 0 || ny >= static_cast<long>(m.height()) || nx >= static_cast<long>(m.width()))
+                            continue;
+                        if (m[ny][nx] && !lab[ny][nx]) {
+                            lab[ny][nx] = next;
+                            stack.emplace_back(ny, nx);
+                        }
+                    }
+            }
+        }
+    return lab;
+}
+
+}
+
+TEST_CASE("label small example", "[label]") {
+    Mask m{4, 6, {1, 1, 0, 0, 0, 1,
+                  0, 1, 0, 1, 0, 1,
+                  0, 0, 1, 0, 0, 0,
+                  1, 0, 0, 0, 1, 1}};
+
+    auto eight = label_components(m, connectivity::eight);
+    REQUIRE(eight.count() == 4);
+    REQUIRE(eight.labels[0][0] == 1);
+    REQUIRE(eight.labels[1][3] == 1); // via the diagonal at (2,2)
+    REQUIRE(eight.labels[0][5] == 2);
+    REQUIRE(eight.labels[3][0] == 3);
+    REQUIRE(eight.labels[3][5] == 4);
+    REQUIRE(eight.labels[0][2] == 0);
+    REQUIRE(eight.components[0].area == 5);
+    REQUIRE(eight.components[0].bounds == (region{0, 0, 3, 4}));
+    REQUIRE(eight.components[1].bounds == (region{0, 5, 2, 1}));
+    REQUIRE(eight.components[3].area == 2);
+
+    auto four = label_components(m, connectivity::four);
+    REQUIRE(four.count() == 6);
+    REQUIRE(four.labels[1][3] == 3);
+    REQUIRE(four.labels[2][2] == 4);
+    REQUIRE(four.components[0].area == 3);
+}
+
+TEST_CASE("label matches flood fill", "[label]") {
+    for (unsigned density : {10, 45, 60, 90})
+        for (std::size_t w : {1, 7, 50})
+            for (connectivity conn : {connectivity::four, connectivity::eight}) {
+                Mask m = random_mask(37, w, density, density + static_cast<unsigned>(w));
+                auto expect = reference_labels(m, conn);
+                for (unsigned bands : {1, 2, 3, 8, 100}) {
+                    auto got = label_components(m, conn, bands);
+                    REQUIRE(std::equal(got.labels.begin(), got.labels.end(), expect.begin()));
+                    REQUIRE(got.labels.invariants());
+
+                    // Statistics, the slow way
+                    std::vector<std::size_t> area(got.count());
+                    for (std::uint32_t l : expect)
+                        if (l) ++area[l - 1];
+                    for (std::size_t c = 0; c < got.count(); ++c) REQUIRE(got.components[c].area == area[c]);
+                }
+            }
+}
+
+TEST_CASE("label bounding boxes", "[label]") {
+    Mask m = random_mask(60, 60, 55, 3);
+    auto got = label_components(m, connectivity::eight, 4);
+    for (std::size_t c = 0; c < got.count(); ++c) {
+        std::size_t y0 = m.height(), y1 = 0, x0 = m.width(), x1 = 0;
+        for (std::size_t y = 0; y < m.height(); ++y)
+            for (std::size_t x = 0; x < m.width(); ++x)
+                if (got.labels[y][x] == c + 1) {
+                    y0 = std::min(y0, y);
+                    y1 = std::max(y1, y + 1);
+                    x0 = std::min(x0, x);
+                    x1 = std::max(x1, x + 1);
+                }
+        REQUIRE(got.components[c].bounds == (region{y0, x0, y1 - y0, x1 - x0}));
+    }
+}
+
+TEST_CASE("label large blob and empty", "[label]") {
+    // One big blob, which would overflow the stack of a recursive fill
+    Mask m{1000, 1000, 1};
+    auto got = label_components(m, connectivity::four, 4);
+    REQUIRE(got.count() == 1);
+    REQUIRE(got.components[0].area == 1000000);
+    REQUIRE(got.components[0].bounds == (region{0, 0, 1000, 1000}));
+
+    Mask none{0, 10};
+    REQUIRE(label_components(none).count() == 0);
+    Mask zeros{5, 5};
+    auto z = label_components(zeros);
+    REQUIRE(z.count() == 0);
+    REQUIRE(z.labels.height() == 5);
+
+    rectangular<float> f{1, 3, {0.5f, 0.0f, -1.0f}};
+    REQUIRE(label_components(f).count() == 2);
+}
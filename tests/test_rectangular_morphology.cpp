@@ -0,0 +1,142 @@
+#include "catch.hpp"
+
+#include "rectangular_morphology.hpp"
+#include "simd_level_guard.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+
+using namespace gnb;
+
+namespace {
+
+template <typename T>
+rectangular<T> random_grid(std::size_t h, std::size_t w, unsigned range, unsigned seed) {
+    std::mt19937 gen{seed};
+    rectangular<T> r{h, w};
+    for (auto& v : r) v = static_cast<T>(static_cast<int>(gen() % range) - (std::is_signed<T>::value ? 50 : 0));
+    return r;
+}
+
+// The slow way: every cell of the (clipped) window, anchor as documented
+template <typename T>
+rectangular<T> reference(const rectangular<T>& src, std::size_t kh, std::size_t kw, bool dilation) {
+    rectangular<T> out{src.height(), src.width()};
+    const long ay = dilation ? static_cast<long>(kh - 1 - kh / 2) : static_cast<long>(kh / 2);
+    const long ax = dilation ? static_cast<long>(kw - 1 - kw / 2) : static_cast<long>(kw / 2);
+    for (long y = 0; y < static_cast<long>(src.height()); ++y)
+        for (long x = 0; x < static_cast<long>(src.width()); ++x) {
+            bool first = true;
+            T best{};
+            for (long wy = y - ay; wy < y - ay + static_cast<long>(kh); ++wy)
+                for (long wx = x - ax; wx < x - ax + static_cast<long>(kw); ++wx) {
+                    if (wy < 0 || wx < 0 || wy >= static_cast<long>(src.height()) || wx >= static_cast<long>(src.width()))
+                        continue;
+                    T v = src[wy][wx];
+                    if (first || (dilation ? best < v : v < best)) best = v;
+                    first = false;
+                }
+            out[y][x] = best;
+        }
+    return out;
+}
+
+template <typename T>
+bool same(const rectangular<T>& a, const rectangular<T>& b) {
+    return a.height() == b.height() && a.width() == b.width() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename T>
+void check_morphology(std::size_t h, std::size_t w, unsigned seed) {
+    rectangular<T> src = random_grid<T>(h, w, 100, seed);
+    for (std::size_t kh : {1, 2, 3, 5, 8})
+        for (std::size_t kw : {1, 2, 4, 7}) {
+            REQUIRE(same(erode(src, kh, kw), reference(src, kh, kw, false)));
+            REQUIRE(same(dilate(src, kh, kw), reference(src, kh, kw, true)));
+        }
+}
+
+}
+
+TEST_CASE("morphology matches brute force", "[morphology]") {
+    level_guard guard;
+    for (simd_level l : {simd_level::scalar, simd_level::sse2, simd_level::avx2, simd_level::avx512}) {
+        set_simd_level(l);
+        for (std::size_t h : {1, 4, 13})
+            for (std::size_t w : {1, 6, 37, 100}) {
+                check_morphology<std::uint8_t>(h, w, static_cast<unsigned>(h * w));
+                check_morphology<float>(h, w, static_cast<unsigned>(h + w));
+            }
+    }
+    check_morphology<int>(9, 11, 1);
+    check_morphology<std::uint16_t>(9, 11, 2);
+}
+
+TEST_CASE("morphology large elements", "[morphology]") {
+    // Bigger than the grid, and tall enough for several column strips
+    rectangular<std::uint8_t> src = random_grid<std::uint8_t>(40, 300, 256, 3);
+    for (std::size_t k : {31, 64, 500}) {
+        REQUIRE(same(erode(src, k, 3), reference(src, k, 3, false)));
+        REQUIRE(same(dilate(src, 3, k), reference(src, 3, k, true)));
+    }
+    rectangular<float> wide = random_grid<float>(3, 5000, 1000, 4);
+    REQUIRE(same(erode(wide, 200, 1), reference(wide, 200, 1, false)));
+}
+
+TEST_CASE("morphology open and close", "[morphology]") {
+    rectangular<std::uint8_t> src = random_grid<std::uint8_t>(30, 40, 256, 5);
+    for (std::size_t kh : {1, 2, 3})
+        for (std::size_t kw : {2, 3, 6}) {
+            auto o = open(src, kh, kw);
+            auto c = close(src, kh, kw);
+            for (std::size_t i = 0; i < src.size(); ++i) {
+                REQUIRE(o.data()[i] <= src.data()[i]);
+                REQUIRE(src.data()[i] <= c.data()[i]);
+            }
+            // Idempotent, which depends on dilation using the reflected element
+            REQUIRE(same(open(o, kh, kw), o));
+            REQUIRE(same(close(c, kh, kw), c));
+        }
+
+    // A lone bright pixel is opened away, a lone dark one closed up
+    rectangular<std::uint8_t> dot{5, 5, 0};
+    dot[2][2] = 9;
+    auto opened = open(dot, 2, 2);
+    REQUIRE(std::all_of(opened.begin(), opened.end(), [](std::uint8_t v) { return v == 0; }));
+    rectangular<std::uint8_t> hole{5, 5, 9};
+    hole[2][2] = 0;
+    auto closed = close(hole, 3, 3);
+    REQUIRE(closed[2][2] == 9);
+}
+
+TEST_CASE("morphology binary matches grayscale", "[morphology]") {
+    for (std::size_t w : {1, 63, 64, 65, 200})
+        for (unsigned density : {20, 80}) {
+            std::mt19937 gen{static_cast<unsigned>(w + density)};
+            rectangular<std::uint8_t> mask{17, w};
+            for (auto& v : mask) v = gen() % 100 < density;
+            for (std::size_t kh : {1, 2, 5})
+                for (std::size_t kw : {1, 3, 8, 64, 70}) {
+                    REQUIRE(same(binary_erode(mask, kh, kw), erode(mask, kh, kw)));
+                    REQUIRE(same(binary_dilate(mask, kh, kw), dilate(mask, kh, kw)));
+                    REQUIRE(same(binary_open(mask, kh, kw), open(mask, kh, kw)));
+                    REQUIRE(same(binary_close(mask, kh, kw), close(mask, kh, kw)));
+                }
+        }
+
+    // Any non-zero cell is set
+    rectangular<float> f{1, 3, {0.5f, 0.0f, -2.0f}};
+    auto d = binary_dilate(f, 1, 1);
+    REQUIRE(d[0][0] == 1);
+    REQUIRE(d[0][1] == 0);
+    REQUIRE(d[0][2] == 1);
+}
+
+TEST_CASE("morphology bad element and empty", "[morphology]") {
+    rectangular<std::uint8_t> src{3, 3};
+    REQUIRE_THROWS_AS(erode(src, 0, 3), std::out_of_range);
+    REQUIRE_THROWS_AS(binary_dilate(src, 3, 0), std::out_of_range);
+    REQUIRE(erode(rectangular<std::uint8_t>{0, 5}, 3, 3).empty());
+    REQUIRE(binary_open(rectangular<std::uint8_t>{0, 5}, 3, 3).empty());
+}
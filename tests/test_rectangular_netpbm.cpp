@@ -0,0 +1,147 @@
+#include "catch.hpp"
+
+#include "rectangular_netpbm.hpp"
+#include "simd_level_guard.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+using namespace gnb;
+
+namespace {
+
+const char* const tmp_path = "test_netpbm.tmp";
+
+// Removes the scratch file however the test ends
+struct scratch_file {
+    ~scratch_file() { std::remove(tmp_path); }
+};
+
+std::string slurp(const char* path) {
+    std::string s;
+    if (std::FILE* f = std::fopen(path, "rb")) {
+        char buf[4096];
+        std::size_t n;
+        while ((n = std::fread(buf, 1, sizeof buf, f)) > 0) s.append(buf, n);
+        std::fclose(f);
+    }
+    return s;
+}
+
+void spit(const char* path, const std::string& s) {
+    std::FILE* f = std::fopen(path, "wb");
+    std::fwrite(s.data(), 1, s.size(), f);
+    std::fclose(f);
+}
+
+template <typename T>
+rectangular<T> random_image(std::size_t h, std::size_t w, unsigned seed) {
+    std::mt19937 gen{seed};
+    rectangular<T> r{h, w};
+    auto* bytes = reinterpret_cast<unsigned char*>(r.data());
+    for (std::size_t i = 0; i < r.size() * sizeof(T); ++i) bytes[i] = static_cast<unsigned char>(gen());
+    return r;
+}
+
+template <typename T>
+bool same_bytes(const rectangular<T>& a, const rectangular<T>& b) {
+    return a.height() == b.height() && a.width() == b.width()
+        && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+}
+
+TEST_CASE("netpbm pgm round trip", "[netpbm]") {
+    scratch_file scratch;
+    auto img = random_image<std::uint8_t>(7, 13, 1);
+    write_pgm(tmp_path, img);
+    REQUIRE(slurp(tmp_path).substr(0, 12) == "P5\n13 7\n255\n");
+    REQUIRE(read_pgm<std::uint8_t>(tmp_path) == img);
+}
+
+TEST_CASE("netpbm 16-bit pgm is big-endian", "[netpbm]") {
+    scratch_file scratch;
+    level_guard guard;
+    rectangular<std::uint16_t> small{1, 2, {0x0102, 0xA0B0}};
+    write_pgm(tmp_path, small);
+    REQUIRE(slurp(tmp_path) == std::string("P5\n2 1\n65535\n\x01\x02\xA0\xB0", 17));
+    for (simd_level l : {simd_level::scalar, simd_level::sse2, simd_level::avx2}) {
+        set_simd_level(l);
+        auto img = random_image<std::uint16_t>(5, 37, 2);
+        write_pgm(tmp_path, img);
+        REQUIRE(read_pgm<std::uint16_t>(tmp_path) == img);
+    }
+}
+
+TEST_CASE("netpbm ppm round trip", "[netpbm]") {
+    scratch_file scratch;
+    auto img = random_image<rgb8>(4, 9, 3);
+    write_ppm(tmp_path, img);
+    REQUIRE(same_bytes(read_ppm<rgb8>(tmp_path), img));
+    auto deep = random_image<rgb16>(3, 11, 4);
+    write_ppm(tmp_path, deep);
+    REQUIRE(same_bytes(read_ppm<rgb16>(tmp_path), deep));
+    REQUIRE_THROWS_AS(read_ppm<rgb8>(tmp_path), std::runtime_error);
+}
+
+TEST_CASE("netpbm pfm round trip", "[netpbm]") {
+    scratch_file scratch;
+    level_guard guard;
+    rectangular<float> img{2, 3, {1, 2, 3, 4, 5, 6}};
+    write_pfm(tmp_path, img);
+    std::string bytes = slurp(tmp_path);
+    REQUIRE(bytes.substr(0, 12) == "Pf\n3 2\n-1.0\n");
+    // Bottom row first
+    float first;
+    std::memcpy(&first, bytes.data() + 12, sizeof first);
+    REQUIRE(first == 4.0f);
+    REQUIRE(read_pfm(tmp_path) == img);
+
+    // A big-endian file with a comment in the header
+    for (simd_level l : {simd_level::scalar, simd_level::sse42, simd_level::avx2}) {
+        set_simd_level(l);
+        auto big = random_image<float>(3, 21, 5);
+        std::string data(reinterpret_cast<const char*>(big.data()), big.size() * sizeof(float));
+        std::string swapped;
+        for (std::size_t y = 3; y-- > 0;)
+            for (std::size_t i = 0; i < 21; ++i)
+                for (int b = 3; b >= 0; --b) swapped += data[(y * 21 + i) * 4 + b];
+        spit(tmp_path, "Pf\n# made by hand\n21 3\n1.0\n" + swapped);
+        REQUIRE(same_bytes(read_pfm(tmp_path), big));
+    }
+
+    struct rgbf {
+        float r, g, b;
+    };
+    auto colour = random_image<rgbf>(4, 4, 6);
+    write_pfm(tmp_path, colour);
+    REQUIRE(slurp(tmp_path).substr(0, 2) == "PF");
+    REQUIRE(same_bytes(read_pfm<rgbf>(tmp_path), colour));
+}
+
+TEST_CASE("netpbm header parsing and errors", "[netpbm]") {
+    scratch_file scratch;
+    spit(tmp_path, "P5 # comment\n#another\n 3\t2 100\n\x01\x02\x03\x04\x05\x06");
+    auto img = read_pgm<std::uint8_t>(tmp_path);
+    REQUIRE(img.height() == 2);
+    REQUIRE(img.width() == 3);
+    REQUIRE(img[1][2] == 6);
+
+    REQUIRE_THROWS_AS(read_pgm<std::uint16_t>(tmp_path), std::runtime_error); // 8-bit samples
+    spit(tmp_path, "P5\n3 2\n255\n\x01\x02");
+    REQUIRE_THROWS_AS(read_pgm<std::uint8_t>(tmp_path), std::runtime_error); // truncated
+    // Huge dimensions are rejected before allocating
+    spit(tmp_path, "P5\n16777216 16777216\n255\n\x01\x02");
+    REQUIRE_THROWS_AS(read_pgm<std::uint8_t>(tmp_path), std::runtime_error);
+    spit(tmp_path, "Pf\n16777216 16777216\n-1.0\n\x01\x02\x03\x04");
+    REQUIRE_THROWS_AS(read_pfm(tmp_path), std::runtime_error);
+    spit(tmp_path, "P2\n3 2\n255\n1 2 3 4 5 6");
+    REQUIRE_THROWS_AS(read_pgm<std::uint8_t>(tmp_path), std::runtime_error); // ASCII
+    spit(tmp_path, "P5\n-3 2\n255\n");
+    REQUIRE_THROWS_AS(read_pgm<std::uint8_t>(tmp_path), std::runtime_error);
+    REQUIRE_THROWS_AS(read_pgm<std::uint8_t>("no/such/file.pgm"), std::runtime_error);
+    REQUIRE_THROWS_AS(write_pgm(tmp_path, rectangular<std::uint8_t>{0, 3}), std::runtime_error);
+}
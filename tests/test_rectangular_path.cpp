@@ -0,0 +1,193 @@
+#include "catch.hpp"
+
+#include "rectangular_path.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <random>
+
+using namespace gnb;
+
+namespace {
+
+using Map = rectangular<std::uint8_t>;
+
+Map random_map(std::size_t h, std::size_t w, unsigned walls, unsigned seed) {
+    std::mt19937 gen{seed};
+    Map m{h, w};
+    for (auto& v : m) v = gen() % 100 < walls ? 0 : static_cast<std::uint8_t>(1 + gen() % 9);
+    return m;
+}
+
+// Plain BFS distances in steps on a 4-connected map of unit costs
+rectangular<int> bfs(const Map& m, std::size_t sy, std::size_t sx) {
+    rectangular<int> d{m.height(), m.width(), -1};
+    std::queue<std::pair<std::size_t, std::size_t> > q;
+    d[sy][sx] = 0;
+    q.emplace(sy, sx);
+    while (!q.empty()) {
+        auto p = q.front();
+        q.pop();
+        const int dy[] = {-1, 1, 0, 0}, dx[] = {0, 0, -1, 1};
+        for (int k = 0; k < 4; ++k) {
+            long ny = static_cast<long>(p.first) + dy[k], nx = static_cast<long>(p.second) + dx[k];
+            if (ny < 0 || nx < 0 || ny >= static_cast<long>(m.height()) || nx >= static_cast<long>(m.width())) continue;
+            if (!m[ny][nx] || d[ny][nx] >= 0) continue;
+            d[ny][nx] = d[p.first][p.second] + 1;
+            q.emplace(ny, nx);
+        }
+    }
+    return d;
+}
+
+}
+
+TEST_CASE("path visited grid", "[path]") {
+    visited_grid v{3, 4};
+    REQUIRE(!v.visited(1, 2));
+    REQUIRE(v.visit(1, 2));
+    REQUIRE(!v.visit(1, 2));
+    REQUIRE(v.visited(6));
+    v.clear();
+    REQUIRE(!v.visited(1, 2));
+    // Old visits stay forgotten however many clears follow
+    v.visit(0, 0);
+    for (std::uint64_t i = 0; i < 100000; ++i) v.clear();
+    REQUIRE(!v.visited(0, 0));
+    v.resize(2, 2);
+    REQUIRE(v.height() == 2);
+    REQUIRE(v.visit(1, 1));
+}
+
+TEST_CASE("path distance transform matches brute force", "[path]") {
+    std::mt19937 gen{5};
+    for (std::size_t h : {1, 6, 23})
+        for (std::size_t w : {1, 9, 31})
+            for (unsigned density : {1, 10, 50}) {
+                Map m{h, w};
+                for (auto& v : m) v = gen() % 100 < density;
+                m[gen() % h][gen() % w] = 1;
+                auto d2 = squared_distance_transform(m);
+                auto d = distance_transform(m);
+                for (std::size_t y = 0; y < h; ++y)
+                    for (std::size_t x = 0; x < w; ++x) {
+                        long best = std::numeric_limits<long>::max();
+                        for (std::size_t fy = 0; fy < h; ++fy)
+                            for (std::size_t fx = 0; fx < w; ++fx)
+                                if (m[fy][fx]) {
+                                    long dy = static_cast<long>(fy) - static_cast<long>(y);
+                                    long dx = static_cast<long>(fx) - static_cast<long>(x);
+                                    best = std::min(best, dy * dy + dx * dx);
+                                }
+                        REQUIRE(d2[y][x] == static_cast<double>(best));
+                        REQUIRE(d[y][x] == Approx(std::sqrt(static_cast<double>(best))));
+                    }
+            }
+}
+
+TEST_CASE("path distance transform beyond float precision", "[path]") {
+    // 4097 squared is odd and above 2^24, so not a float
+    Map row{1, 5000}, column{5000, 1};
+    row[0][0] = 1;
+    column[0][0] = 1;
+    REQUIRE(squared_distance_transform(row)[0][4097] == 4097.0 * 4097.0);
+    REQUIRE(squared_distance_transform(column)[4097][0] == 4097.0 * 4097.0);
+    REQUIRE(distance_transform(row)[0][4999] == 4999.0f);
+}
+
+TEST_CASE("path distance transform with no features", "[path]") {
+    Map m{3, 3};
+    auto d = distance_transform(m);
+    REQUIRE(std::isinf(d[1][1]));
+    REQUIRE(distance_transform(Map{0, 4}).empty());
+}
+
+TEST_CASE("path A* matches BFS on unit costs", "[path]") {
+    Map m = random_map(40, 50, 30, 1);
+    for (auto& v : m) v = v ? 1 : 0;
+    grid_pathfinder pf{40, 50, connectivity::four};
+    m[0][0] = 1;
+    auto expect = bfs(m, 0, 0);
+    // Many queries on the same pathfinder
+    for (std::size_t y = 0; y < 40; y += 3)
+        for (std::size_t x = 0; x < 50; x += 7) {
+            const bool found = pf.find_path(m, {0, 0}, {y, x});
+            REQUIRE(found == (expect[y][x] >= 0));
+            if (!found) {
+                REQUIRE(pf.path().empty());
+                continue;
+            }
+            REQUIRE(pf.distance(y, x) == static_cast<float>(expect[y][x]));
+            auto path = pf.path();
+            REQUIRE(path.size() == static_cast<std::size_t>(expect[y][x]) + 1);
+            REQUIRE(path.front() == std::make_pair(std::size_t{0}, std::size_t{0}));
+            REQUIRE(path.back() == std::make_pair(y, x));
+            for (std::size_t k = 1; k < path.size(); ++k) {
+                std::size_t dist = (path[k].first > path[k - 1].first ? path[k].first - path[k - 1].first
+                                                                      : path[k - 1].first - path[k].first)
+                                 + (path[k].second > path[k - 1].second ? path[k].second - path[k - 1].second
+                                                                        : path[k - 1].second - path[k].second);
+                REQUIRE(dist == 1);
+                REQUIRE(m[path[k].first][path[k].second] != 0);
+            }
+        }
+}
+
+TEST_CASE("path A* agrees with Dijkstra on weighted maps", "[path]") {
+    for (unsigned seed : {2, 3, 4}) {
+        Map m = random_map(30, 30, 20, seed);
+        m[0][0] = 1;
+        for (connectivity conn : {connectivity::four, connectivity::eight}) {
+            grid_pathfinder astar{30, 30, conn}, dijkstra{30, 30, conn};
+            // Dijkstra, as search_all() with the same step costs as find_path()
+            const float diag = std::sqrt(2.0f), inf = std::numeric_limits<float>::infinity();
+            const std::uint8_t* c = m.data();
+            dijkstra.search_all({0, 0}, [&](std::uint32_t from, std::uint32_t to, bool diagonal) -> float {
+                if (!c[to]) return inf;
+                if (!diagonal) return c[to];
+                if (!c[from / 30 * 30 + to % 30] || !c[to / 30 * 30 + from % 30]) return inf;
+                return c[to] * diag;
+            });
+            for (std::size_t y = 0; y < 30; y += 4)
+                for (std::size_t x = 0; x < 30; x += 5) {
+                    const float best = dijkstra.distance(y, x);
+                    REQUIRE(astar.find_path(m, {0, 0}, {y, x}) == !std::isinf(best));
+                    if (!std::isinf(best)) REQUIRE(astar.distance(y, x) == Approx(best));
+                }
+        }
+    }
+}
+
+TEST_CASE("path diagonal moves", "[path]") {
+    Map m{3, 3, 1};
+    grid_pathfinder pf{3, 3};
+    REQUIRE(pf.find_path(m, {0, 0}, {2, 2}));
+    REQUIRE(pf.path().size() == 3);
+    REQUIRE(pf.distance(2, 2) == Approx(2 * std::sqrt(2.0)));
+
+    // No cutting the corner of a wall
+    m[0][1] = 0;
+    REQUIRE(pf.find_path(m, {0, 0}, {1, 2}));
+    REQUIRE(pf.path()[1] == std::make_pair(std::size_t{1}, std::size_t{0}));
+
+    // Walled off
+    m[1][0] = m[1][1] = 0;
+    REQUIRE(!pf.find_path(m, {0, 0}, {2, 2}));
+    REQUIRE(!pf.found());
+    REQUIRE(std::isinf(pf.distance(2, 2)));
+
+    REQUIRE_THROWS_AS(pf.find_path(m, {0, 0}, {3, 0}), std::out_of_range);
+    REQUIRE_THROWS_AS(pf.find_path(Map{2, 2}, {0, 0}, {1, 1}), std::out_of_range);
+}
+
+TEST_CASE("path distance only for settled cells", "[path]") {
+    // The cell past the goal is on the open list, not settled
+    Map m{1, 10, 1};
+    grid_pathfinder pf{1, 10};
+    REQUIRE(pf.find_path(m, {0, 0}, {0, 2}));
+    REQUIRE(pf.distance(0, 2) == 2.0f);
+    REQUIRE(pf.distance(0, 1) == 1.0f);
+    REQUIRE(std::isinf(pf.distance(0, 3)));
+}
@@ -0,0 +1,120 @@
+#include "catch.hpp"
+
+#include "rectangular_reduce.hpp"
+
+#include <cstdint>
+#include <numeric>
+#include <random>
+
+using namespace gnb;
+
+using U8 = rectangular<std::uint8_t>;
+using F = rectangular<float>;
+
+static U8 random_u8(std::size_t h, std::size_t w, unsigned seed) {
+    std::mt19937 gen{seed};
+    U8 r{h, w};
+    for (auto& v : r) v = static_cast<std::uint8_t>(gen());
+    return r;
+}
+
+static F random_f(std::size_t h, std::size_t w, unsigned seed) {
+    std::mt19937 gen{seed};
+    std::uniform_real_distribution<float> dist{-100.0f, 100.0f};
+    F r{h, w};
+    for (auto& v : r) v = dist(gen);
+    return r;
+}
+
+TEST_CASE("reduce uint8 sum and minmax", "[reduce]") {
+    // Sizes to exercise the SIMD tails
+    for (std::size_t w : {1, 7, 16, 31, 33, 100, 257}) {
+        U8 r = random_u8(5, w, static_cast<unsigned>(w));
+        std::uint64_t expect = std::accumulate(r.begin(), r.end(), std::uint64_t{0});
+        REQUIRE(sum(r) == expect);
+
+        auto mm = minmax(r);
+        REQUIRE(mm.first == *std::min_element(r.begin(), r.end()));
+        REQUIRE(mm.second == *std::max_element(r.begin(), r.end()));
+    }
+}
+
+TEST_CASE("reduce uint8 sum does not overflow", "[reduce]") {
+    U8 r{300, 1000, 255};
+    static_assert(std::is_same<decltype(sum(r)), std::uint64_t>::value, "uint8 sums are 64 bit");
+    REQUIRE(sum(r) == 255ull * 300 * 1000);
+    REQUIRE(minmax(r) == std::make_pair(std::uint8_t{255}, std::uint8_t{255}));
+}
+
+TEST_CASE("reduce float sum and minmax", "[reduce]") {
+    for (std::size_t w : {1, 3, 4, 9, 16, 17, 100}) {
+        F r = random_f(4, w, static_cast<unsigned>(w));
+        double expect = std::accumulate(r.begin(), r.end(), 0.0);
+        REQUIRE(sum(r) == Approx(expect).margin(1e-2));
+
+        auto mm = minmax(r);
+        REQUIRE(mm.first == *std::min_element(r.begin(), r.end()));
+        REQUIRE(mm.second == *std::max_element(r.begin(), r.end()));
+    }
+}
+
+TEST_CASE("reduce generic types", "[reduce]") {
+    rectangular<int> r{2, 3, {-1, 5, 3, 5, -7, 2}};
+
+    static_assert(std::is_same<decltype(sum(r)), std::int64_t>::value, "int sums are signed 64 bit");
+    REQUIRE(sum(r) == 7);
+    REQUIRE(minmax(r) == std::make_pair(-7, 5));
+    REQUIRE(argmax(r) == std::make_pair(std::size_t{0}, std::size_t{1}));
+    REQUIRE(row_sums(r) == (std::vector<std::int64_t>{7, 0}));
+    REQUIRE(col_sums(r) == (std::vector<std::int64_t>{4, -2, 5}));
+
+    rectangular<double> d{1, 2, {0.5, 0.25}};
+    REQUIRE(sum(d) == 0.75);
+}
+
+TEST_CASE("reduce argmax", "[reduce]") {
+    U8 r{40, 50, 3};
+    r[17][33] = 200;
+    r[30][2] = 200;
+    REQUIRE(argmax(r) == std::make_pair(std::size_t{17}, std::size_t{33}));
+
+    F f = random_f(13, 21, 1);
+    f[12][20] = 1000.0f;
+    REQUIRE(argmax(f) == std::make_pair(std::size_t{12}, std::size_t{20}));
+}
+
+TEST_CASE("reduce empty", "[reduce]") {
+    U8 r{0, 5};
+    REQUIRE(sum(r) == 0);
+    REQUIRE_THROWS_AS(minmax(r), std::out_of_range);
+    REQUIRE_THROWS_AS(argmax(r), std::out_of_range);
+    REQUIRE(row_sums(r).empty());
+    REQUIRE(col_sums(r) == (std::vector<std::uint64_t>(5, 0)));
+}
+
+TEST_CASE("reduce row and column sums", "[reduce]") {
+    for (std::size_t w : {1, 15, 16, 40, 67}) {
+        U8 r = random_u8(23, w, 7);
+        auto rows = row_sums(r);
+        auto cols = col_sums(r);
+        REQUIRE(rows.size() == 23);
+        REQUIRE(cols.size() == w);
+        for (std::size_t y = 0; y < r.height(); ++y)
+            REQUIRE(rows[y] == std::accumulate(r[y], r[y] + w, std::uint64_t{0}));
+        for (std::size_t x = 0; x < w; ++x) {
+            std::uint64_t c = 0;
+            for (std::size_t y = 0; y < r.height(); ++y) c += r[y][x];
+            REQUIRE(cols[x] == c);
+        }
+
+        F f = random_f(11, w, 3);
+        auto fcols = col_sums(f);
+        auto frows = row_sums(f);
+        for (std::size_t x = 0; x < w; ++x) {
+            double c = 0;
+            for (std::size_t y = 0; y < f.height(); ++y) c += f[y][x];
+            REQUIRE(fcols[x] == Approx(c).margin(1e-3));
+        }
+        REQUIRE(frows[10] == Approx(std::accumulate(f[10], f[10] + w, 0.0)).margin(1e-3));
+    }
+}
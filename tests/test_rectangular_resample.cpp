@@ -0,0 +1,143 @@
+#include "catch.hpp"
+
+#include "rectangular_resample.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+
+using namespace gnb;
+
+namespace {
+
+using Image = rectangular<std::uint8_t>;
+using FImage = rectangular<float>;
+
+template <typename T>
+rectangular<T> random_image(std::size_t h, std::size_t w, unsigned seed) {
+    std::mt19937 gen{seed};
+    rectangular<T> r{h, w};
+    for (auto& v : r) v = static_cast<T>(gen() % 256);
+    return r;
+}
+
+// Area resampling done directly in 2D: each output pixel is the mean of the
+// source, weighted by overlap
+FImage reference_area(const FImage& src, std::size_t h, std::size_t w) {
+    FImage out{h, w};
+    const double sy = static_cast<double>(src.height()) / h, sx = static_cast<double>(src.width()) / w;
+    for (std::size_t y = 0; y < h; ++y)
+        for (std::size_t x = 0; x < w; ++x) {
+            double sum = 0, total = 0;
+            for (std::size_t j = 0; j < src.height(); ++j)
+                for (std::size_t i = 0; i < src.width(); ++i) {
+                    double oy = std::min(y * sy + sy, j + 1.0) - std::max(y * sy, static_cast<double>(j));
+                    double ox = std::min(x * sx + sx, i + 1.0) - std::max(x * sx, static_cast<double>(i));
+                    if (oy <= 0 || ox <= 0) continue;
+                    sum += oy * ox * src[j][i];
+                    total += oy * ox;
+                }
+            out[y][x] = static_cast<float>(sum / total);
+        }
+    return out;
+}
+
+}
+
+TEST_CASE("resample same size is a copy", "[resample]") {
+    Image img = random_image<std::uint8_t>(13, 17, 1);
+    for (resample_filter f : {resample_filter::bilinear, resample_filter::bicubic, resample_filter::area}) {
+        Image out = resample(img, 13, 17, f);
+        REQUIRE(std::equal(out.begin(), out.end(), img.begin()));
+    }
+}
+
+TEST_CASE("resample keeps constant images constant", "[resample]") {
+    Image img{11, 7, 200};
+    for (resample_filter f : {resample_filter::bilinear, resample_filter::bicubic, resample_filter::area})
+        for (std::size_t h : {1, 3, 11, 30})
+            for (std::size_t w : {1, 5, 7, 25}) {
+                Image out = resample(img, h, w, f);
+                REQUIRE(out.height() == h);
+                REQUIRE(out.width() == w);
+                REQUIRE(std::all_of(out.begin(), out.end(), [](std::uint8_t v) { return v == 200; }));
+            }
+}
+
+TEST_CASE("resample area matches brute force", "[resample]") {
+    FImage img = random_image<float>(23, 19, 2);
+    for (std::size_t h : {1, 4, 10, 23, 31})
+        for (std::size_t w : {1, 3, 8, 19, 40}) {
+            FImage got = resample(img, h, w, resample_filter::area);
+            FImage expect = reference_area(img, h, w);
+            for (std::size_t y = 0; y < h; ++y)
+                for (std::size_t x = 0; x < w; ++x) REQUIRE(got[y][x] == Approx(expect[y][x]).epsilon(1e-4));
+        }
+}
+
+TEST_CASE("resample bilinear and bicubic keep ramps linear", "[resample]") {
+    FImage ramp{8, 8};
+    for (std::size_t y = 0; y < 8; ++y)
+        for (std::size_t x = 0; x < 8; ++x) ramp[y][x] = static_cast<float>(3 * x + 5 * y);
+    for (resample_filter f : {resample_filter::bilinear, resample_filter::bicubic}) {
+        FImage up = resample(ramp, 16, 16, f);
+        // Away from the edges, output pixel centres map back to (i + 0.5) / 2 - 0.5
+        for (std::size_t y = 4; y < 12; ++y)
+            for (std::size_t x = 4; x < 12; ++x)
+                REQUIRE(up[y][x] == Approx(3 * ((x + 0.5) / 2 - 0.5) + 5 * ((y + 0.5) / 2 - 0.5)));
+    }
+}
+
+TEST_CASE("resample clamps integer results", "[resample]") {
+    // Bicubic overshoots at a hard edge
+    Image step{1, 8, {0, 0, 0, 0, 255, 255, 255, 255}};
+    Image up = resample(step, 1, 32, resample_filter::bicubic);
+    REQUIRE(*std::min_element(up.begin(), up.end()) == 0);
+    REQUIRE(*std::max_element(up.begin(), up.end()) == 255);
+    FImage fstep{1, 8, {0, 0, 0, 0, 255, 255, 255, 255}};
+    FImage fup = resample(fstep, 1, 32, resample_filter::bicubic);
+    REQUIRE(*std::max_element(fup.begin(), fup.end()) > 255.0f);
+}
+
+TEST_CASE("resample empty", "[resample]") {
+    Image img{0, 5};
+    REQUIRE(resample(img, 3, 3).size() == 9);
+    REQUIRE(resample(Image{4, 4, 1}, 0, 3).empty());
+}
+
+TEST_CASE("pyramid levels", "[resample]") {
+    Image img = random_image<std::uint8_t>(5, 3, 3);
+    auto levels = build_pyramid(img);
+    REQUIRE(levels.size() == 3);
+    REQUIRE(levels[0].height() == 3);
+    REQUIRE(levels[0].width() == 2);
+    REQUIRE(levels[1].height() == 2);
+    REQUIRE(levels[1].width() == 1);
+    REQUIRE(levels[2].size() == 1);
+
+    // Each level from the one above, the slow way
+    const Image* above = &img;
+    for (const Image& level : levels) {
+        for (std::size_t y = 0; y < level.height(); ++y)
+            for (std::size_t x = 0; x < level.width(); ++x) {
+                std::size_t y1 = std::min(2 * y + 1, above->height() - 1), x1 = std::min(2 * x + 1, above->width() - 1);
+                unsigned sum = (*above)[2 * y][2 * x] + (*above)[2 * y][x1] + (*above)[y1][2 * x] + (*above)[y1][x1];
+                REQUIRE(level[y][x] == (sum + 2) / 4);
+            }
+        above = &level;
+    }
+
+    REQUIRE(build_pyramid(img, 1).size() == 1);
+    REQUIRE(build_pyramid(Image{1, 1}).empty());
+    REQUIRE(build_pyramid(Image{0, 4}).empty());
+}
+
+TEST_CASE("pyramid agrees with area resampling", "[resample]") {
+    FImage img = random_image<float>(64, 48, 4);
+    auto levels = build_pyramid(img);
+    REQUIRE(levels.size() == 6);
+    for (std::size_t k = 0; k < 4; ++k) {
+        FImage expect = resample(img, levels[k].height(), levels[k].width(), resample_filter::area);
+        for (std::size_t i = 0; i < expect.size(); ++i) REQUIRE(levels[k].data()[i] == Approx(expect.data()[i]));
+    }
+}
@@ -0,0 +1,97 @@
+#include "catch.hpp"
+
+#include "rectangular_simd.hpp"
+#include "rectangular_reduce.hpp"
+#include "simd_level_guard.hpp"
+
+#include <cstdint>
+#include <numeric>
+#include <random>
+
+using namespace gnb;
+
+namespace {
+int one() { return 1; }
+int two() { return 2; }
+int four() { return 4; }
+
+const simd_level all_levels[] = {simd_level::scalar, simd_level::sse2, simd_level::sse42,
+    simd_level::avx2, simd_level::avx512};
+}
+
+TEST_CASE("simd parse level names", "[simd]") {
+    simd_level l = simd_level::scalar;
+    REQUIRE(parse_simd_level("avx2", l));
+    REQUIRE(l == simd_level::avx2);
+    REQUIRE(parse_simd_level("scalar", l));
+    REQUIRE(l == simd_level::scalar);
+    REQUIRE(parse_simd_level("sse42", l));
+    REQUIRE(l == simd_level::sse42);
+    REQUIRE(!parse_simd_level("mmx", l));
+    REQUIRE(l == simd_level::sse42);
+}
+
+TEST_CASE("simd detected level is consistent", "[simd]") {
+    const cpu_features& f = detected_cpu_features();
+    simd_level d = detected_simd_level();
+    if (d >= simd_level::sse2) REQUIRE(f.sse2);
+    if (d >= simd_level::avx2) REQUIRE(f.avx2);
+    if (d >= simd_level::avx512) REQUIRE((f.avx512f && f.avx512bw));
+    REQUIRE(active_simd_level() <= d);
+}
+
+TEST_CASE("simd set level is clamped", "[simd]") {
+    level_guard g;
+    set_simd_level(simd_level::scalar);
+    REQUIRE(active_simd_level() == simd_level::scalar);
+    set_simd_level(simd_level::avx512);
+    REQUIRE(active_simd_level() == detected_simd_level());
+}
+
+TEST_CASE("simd dispatch table falls back to lower levels", "[simd]") {
+    level_guard g;
+    dispatch_table<int (*)()> t{one, two, nullptr, four, nullptr};
+
+    REQUIRE(t.get(simd_level::scalar)() == 1);
+    REQUIRE(t.get(simd_level::sse2)() == 2);
+    REQUIRE(t.get(simd_level::sse42)() == 2);
+    REQUIRE(t.get(simd_level::avx2)() == 4);
+    REQUIRE(t.get(simd_level::avx512)() == 4);
+
+    set_simd_level(simd_level::scalar);
+    REQUIRE(t.get()() == 1);
+
+    dispatch_table<int (*)()> only{one};
+    REQUIRE(only.get(simd_level::avx512)() == 1);
+}
+
+TEST_CASE("simd reductions agree at every level", "[simd]") {
+    level_guard g;
+    std::mt19937 gen{42};
+    rectangular<std::uint8_t> u{37, 201};
+    for (auto& v : u) v = static_cast<std::uint8_t>(gen());
+    rectangular<float> f{29, 203};
+    std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+    for (auto& v : f) v = dist(gen);
+
+    set_simd_level(simd_level::scalar);
+    auto u_sum = sum(u);
+    auto u_mm = minmax(u);
+    auto u_cols = col_sums(u);
+    auto f_sum = sum(f);
+    auto f_mm = minmax(f);
+    auto f_cols = col_sums(f);
+    REQUIRE(u_sum == std::accumulate(u.begin(), u.end(), std::uint64_t{0}));
+
+    for (simd_level l : all_levels) {
+        if (l > detected_simd_level()) break;
+        set_simd_level(l);
+        REQUIRE(sum(u) == u_sum);
+        REQUIRE(minmax(u) == u_mm);
+        REQUIRE(col_sums(u) == u_cols);
+        REQUIRE(sum(f) == Approx(f_sum).margin(1e-3));
+        REQUIRE(minmax(f) == f_mm);
+        auto cols = col_sums(f);
+        for (std::size_t x = 0; x < cols.size(); ++x) REQUIRE(cols[x] == Approx(f_cols[x]).margin(1e-4));
+    }
+}
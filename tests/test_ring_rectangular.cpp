@@ -0,0 +1,136 @@
+#include "catch.hpp"
+
+#include "ring_rectangular.hpp"
+
+#include <string>
+
+using namespace gnb;
+
+namespace {
+
+// Row y holds y*100 + x
+ring_rectangular<int> numbered(std::size_t h, std::size_t w) {
+    ring_rectangular<int> r{h, w};
+    for (std::size_t y = 0; y < h; ++y)
+        for (std::size_t x = 0; x < w; ++x) r[y][x] = static_cast<int>(y * 100 + x);
+    return r;
+}
+
+}
+
+TEST_CASE("ring basics", "[ring]") {
+    ring_rectangular<int> r{3, 4, 7};
+    REQUIRE(r.height() == 3);
+    REQUIRE(r.width() == 4);
+    REQUIRE(r.size() == 12);
+    REQUIRE(r.is_linear());
+    REQUIRE(r.at(2, 3) == 7);
+    REQUIRE_THROWS_AS(r.at(3, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(r.at(0, 4), std::out_of_range);
+    REQUIRE(r.invariants());
+
+    rectangular<int> src{2, 2, {1, 2, 3, 4}};
+    ring_rectangular<int> from{src};
+    REQUIRE(from.at(1, 0) == 3);
+}
+
+TEST_CASE("ring scroll rows", "[ring]") {
+    auto r = numbered(5, 3);
+    const int* row2 = r[2];
+    r.scroll_rows(2);
+    REQUIRE(r.base_row() == 2);
+    REQUIRE(!r.is_linear());
+    // No data moved
+    REQUIRE(r[0] == row2);
+    REQUIRE(r.at(0, 1) == 201);
+    REQUIRE(r.at(2, 2) == 402);
+    // Wrapped round
+    REQUIRE(r.at(3, 0) == 0);
+    REQUIRE(r.at(4, 0) == 100);
+
+    r.scroll_rows(-3);
+    REQUIRE(r.at(0, 0) == 400);
+    REQUIRE(r.at(1, 0) == 0);
+
+    r.scroll_rows(11); // same as 1
+    REQUIRE(r.at(0, 0) == 0);
+    REQUIRE(r.is_linear());
+    REQUIRE(r.invariants());
+}
+
+TEST_CASE("ring scroll with fill", "[ring]") {
+    auto r = numbered(5, 2);
+    r.scroll_rows(2, -1);
+    REQUIRE(r.at(0, 0) == 200);
+    REQUIRE(r.at(2, 1) == 401);
+    REQUIRE(r.at(3, 0) == -1);
+    REQUIRE(r.at(4, 1) == -1);
+
+    r.scroll_rows(-1, -2);
+    REQUIRE(r.at(0, 0) == -2);
+    REQUIRE(r.at(1, 0) == 200);
+
+    // Scrolling by more than the height clears everything
+    r.scroll_rows(9, 5);
+    for (std::size_t y = 0; y < 5; ++y) REQUIRE(r.at(y, 0) == 5);
+}
+
+TEST_CASE("ring linearize and copy out", "[ring]") {
+    auto r = numbered(4, 3);
+    r.scroll_rows(3);
+    auto copy = r.to_rectangular();
+    REQUIRE(copy.at(0, 0) == 300);
+    REQUIRE(copy.at(1, 2) == 2);
+
+    r.linearize();
+    REQUIRE(r.is_linear());
+    REQUIRE(r[1] == r[0] + 3);
+    for (std::size_t y = 0; y < 4; ++y)
+        for (std::size_t x = 0; x < 3; ++x) REQUIRE(r.at(y, x) == copy.at(y, x));
+    REQUIRE(r.invariants());
+}
+
+TEST_CASE("ring shift columns", "[ring]") {
+    auto r = numbered(2, 5);
+    r.shift_cols(2, -1);
+    REQUIRE(r.at(0, 0) == -1);
+    REQUIRE(r.at(0, 1) == -1);
+    REQUIRE(r.at(0, 2) == 0);
+    REQUIRE(r.at(1, 4) == 102);
+
+    r.shift_cols(-3, -2);
+    REQUIRE(r.at(0, 0) == 1);
+    REQUIRE(r.at(1, 1) == 102);
+    REQUIRE(r.at(1, 2) == -2);
+
+    r.shift_cols(7);
+    REQUIRE(r.at(1, 0) == 0);
+    REQUIRE(r.at(1, 4) == 0);
+
+    ring_rectangular<std::string> s{1, 4};
+    s.at(0, 0) = "a";
+    s.at(0, 1) = "b";
+    s.shift_cols(1, "-");
+    REQUIRE(s.at(0, 0) == "-");
+    REQUIRE(s.at(0, 1) == "a");
+    REQUIRE(s.at(0, 2) == "b");
+    s.shift_cols(-2, "+");
+    REQUIRE(s.at(0, 0) == "b");
+    REQUIRE(s.at(0, 3) == "+");
+}
+
+TEST_CASE("ring copy and move", "[ring]") {
+    auto r = numbered(3, 3);
+    r.scroll_rows(1);
+    auto c = r;
+    REQUIRE(c.at(0, 0) == 100);
+    auto m = std::move(c);
+    REQUIRE(m.at(2, 2) == 2);
+    REQUIRE(c.empty());
+    REQUIRE(c.invariants());
+    REQUIRE(m.invariants());
+
+    ring_rectangular<int> e;
+    e.scroll_rows(3, 1);
+    REQUIRE(e.invariants());
+}
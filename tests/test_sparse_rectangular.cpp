@@ -0,0 +1,107 @@
+#include "catch.hpp"
+
+#include "sparse_rectangular.hpp"
+
+using namespace gnb;
+
+using S = sparse_rectangular<int>;
+
+TEST_CASE("sparse_rectangular create huge", "[sparse]") {
+    S s{1000000, 1000000, -1};
+
+    REQUIRE(s.height() == 1000000);
+    REQUIRE(s.width() == 1000000);
+    REQUIRE(s.size() == 1000000000000ull);
+    REQUIRE(s.tile_count() == 0);
+    REQUIRE(s.invariants());
+
+    const S& cs = s;
+    REQUIRE(cs.at(999999, 999999) == -1);
+    REQUIRE(cs.at(0, 0) == -1);
+    REQUIRE(s.tile_count() == 0);
+}
+
+TEST_CASE("sparse_rectangular write allocates one tile", "[sparse]") {
+    S s{1000000, 1000000};
+
+    s.at(123456, 654321) = 7;
+    REQUIRE(s.tile_count() == 1);
+    REQUIRE(s.at(123456, 654321) == 7);
+    REQUIRE(s.is_allocated(123456, 654321));
+    REQUIRE(s.is_allocated(123456 & ~63, 654321 | 63));
+    REQUIRE(!s.is_allocated(123456 + 64, 654321));
+    // Rest of the tile has the default value
+    REQUIRE(static_cast<const S&>(s).at(123456 & ~63, 654321 & ~63) == 0);
+
+    s.at(123457, 654321) = 8; // Same tile
+    REQUIRE(s.tile_count() == 1);
+    REQUIRE(s.invariants());
+}
+
+TEST_CASE("sparse_rectangular bounds", "[sparse]") {
+    S s{100, 50};
+    REQUIRE_THROWS_AS(s.at(100, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(s.at(0, 50), std::out_of_range);
+    const S& cs = s;
+    REQUIRE_THROWS_AS(cs.at(100, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(s.is_allocated(0, 50), std::out_of_range);
+    REQUIRE(s.tile_count() == 0);
+}
+
+TEST_CASE("sparse_rectangular tile iteration", "[sparse]") {
+    sparse_rectangular<int, 3> s{20, 30};  // 8x8 tiles
+    s.at(0, 0) = 1;
+    s.at(19, 29) = 2;   // edge tile, clipped to 4x6
+    s.at(10, 10) = 3;
+
+    std::vector<S::size_type> ys, hs, ws;
+    int total = 0;
+    s.for_each_tile([&](const sparse_rectangular<int, 3>::tile& t) {
+        ys.push_back(t.y);
+        hs.push_back(t.height);
+        ws.push_back(t.width);
+        for (std::size_t dy = 0; dy < t.height; ++dy)
+            for (std::size_t dx = 0; dx < t.width; ++dx)
+                total += t.data[dy * s.tile_size + dx];
+    });
+    REQUIRE(ys == (std::vector<S::size_type>{0, 16, 8}));
+    REQUIRE(hs == (std::vector<S::size_type>{8, 4, 8}));
+    REQUIRE(ws == (std::vector<S::size_type>{8, 6, 8}));
+    REQUIRE(total == 6);
+
+    // Writing via the tile
+    s.for_each_tile([](const sparse_rectangular<int, 3>::tile& t) { t.data[0] = 9; });
+    REQUIRE(s.at(16, 24) == 9);
+
+    const auto& cs = s;
+    std::size_t n = 0;
+    cs.for_each_tile([&](const sparse_rectangular<int, 3>::const_tile&) { ++n; });
+    REQUIRE(n == 3);
+}
+
+TEST_CASE("sparse_rectangular copy, move, clear", "[sparse]") {
+    S s{5000, 5000, 4};
+    s.at(1, 1) = 1;
+    s.at(4000, 4000) = 2;
+
+    S c{s};
+    s.at(1, 1) = 10;
+    REQUIRE(c.at(1, 1) == 1);
+    REQUIRE(c.at(4000, 4000) == 2);
+    REQUIRE(c.tile_count() == 2);
+    REQUIRE(c.invariants());
+
+    S m{std::move(c)};
+    REQUIRE(c.size() == 0);
+    REQUIRE(c.invariants());
+    REQUIRE(m.at(4000, 4000) == 2);
+
+    m.clear();
+    REQUIRE(m.tile_count() == 0);
+    REQUIRE(static_cast<const S&>(m).at(4000, 4000) == 4);
+    REQUIRE(m.invariants());
+
+    S a;
+    a = s;
+    REQUIRE(a.at(1, 1) == 10);
+}
@@ -0,0 +1,101 @@
+#include "catch.hpp"
+
+#include "toroidal_rectangular.hpp"
+
+using namespace gnb;
+
+namespace {
+
+using Torus = toroidal_rectangular<int>;
+
+Torus numbered(std::size_t h, std::size_t w) {
+    Torus t{h, w};
+    for (std::size_t y = 0; y < h; ++y)
+        for (std::size_t x = 0; x < w; ++x) t[y][x] = static_cast<int>(y * 1000 + x);
+    return t;
+}
+
+// The obvious version, with % everywhere
+int slow_at(const Torus& t, long y, long x) {
+    long h = static_cast<long>(t.height()), w = static_cast<long>(t.width());
+    return t[((y % h) + h) % h][((x % w) + w) % w];
+}
+
+}
+
+TEST_CASE("toroidal wrapped at", "[toroidal]") {
+    // Power of two and not, in each direction
+    for (std::size_t h : {1, 5, 8})
+        for (std::size_t w : {1, 3, 16}) {
+            Torus t = numbered(h, w);
+            for (long y = -20; y < 20; ++y)
+                for (long x = -40; x < 40; ++x)
+                    REQUIRE(t.at(y, x) == slow_at(t, y, x));
+        }
+
+    Torus t = numbered(4, 6);
+    REQUIRE(t.at(-1, 6) == 3000);
+    t.at(4, -1) = 42;
+    REQUIRE(t[0][5] == 42);
+
+    const Torus& c = t;
+    REQUIRE(c.at(-4, -7) == 42);
+
+    REQUIRE(Torus::wrap(-1, 8) == 7);
+    REQUIRE(Torus::wrap(-9, 8) == 7);
+    REQUIRE(Torus::wrap(-1, 7) == 6);
+    REQUIRE(Torus::wrap(15, 7) == 1);
+}
+
+TEST_CASE("toroidal is a rectangular", "[toroidal]") {
+    Torus t{2, 3, {1, 2, 3, 4, 5, 6}};
+    rectangular<int>& r = t;
+    REQUIRE(r.at(1, 2) == 6);
+    REQUIRE(t[1][0] == 4);
+    REQUIRE(t.invariants());
+
+    Torus empty;
+    REQUIRE_THROWS_AS(empty.at(0, 0), std::out_of_range);
+}
+
+TEST_CASE("toroidal neighbourhoods", "[toroidal]") {
+    for (std::size_t radius : {0, 1, 2, 5})
+        for (std::size_t h : {1, 4, 9})
+            for (std::size_t w : {1, 3, 8, 13}) {
+                Torus t = numbered(h, w);
+                std::size_t visited = 0;
+                bool ok = true;
+                t.for_each_neighbourhood(radius, [&](std::size_t y, std::size_t x, const Torus::neighbourhood& n) {
+                    ++visited;
+                    const long r = static_cast<long>(radius);
+                    for (long dy = -r; dy <= r; ++dy)
+                        for (long dx = -r; dx <= r; ++dx)
+                            if (n(dy, dx) != slow_at(t, static_cast<long>(y) + dy, static_cast<long>(x) + dx)) ok = false;
+                });
+                REQUIRE(ok);
+                REQUIRE(visited == h * w);
+            }
+}
+
+TEST_CASE("toroidal game of life glider wraps", "[toroidal]") {
+    toroidal_rectangular<int> g{8, 8};
+    // A glider, heading down and right
+    g[0][1] = g[1][2] = g[2][0] = g[2][1] = g[2][2] = 1;
+    for (int gen = 0; gen < 32; ++gen) {
+        toroidal_rectangular<int> next{8, 8};
+        g.for_each_neighbourhood(1, [&](std::size_t y, std::size_t x, const toroidal_rectangular<int>::neighbourhood& n) {
+            int live = 0;
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dx = -1; dx <= 1; ++dx)
+                    if (dy || dx) live += n(dy, dx);
+            next[y][x] = live == 3 || (live == 2 && n(0, 0));
+        });
+        g = next;
+    }
+    // 32 generations moves it 8 cells diagonally, back where it started
+    REQUIRE(g[0][1] == 1);
+    REQUIRE(g[2][2] == 1);
+    int total = 0;
+    for (int v : g) total += v;
+    REQUIRE(total == 5);
+}
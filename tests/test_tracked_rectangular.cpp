@@ -0,0 +1,132 @@
+#include "catch.hpp"
+
+#include "tracked_rectangular.hpp"
+
+#include <algorithm>
+
+using namespace gnb;
+
+using TR = tracked_rectangular<int>;
+
+TEST_CASE("tracked_rectangular starts clean", "[tracked]") {
+    TR t{4, 5, 1};
+
+    REQUIRE(t.height() == 4);
+    REQUIRE(t.width() == 5);
+    REQUIRE(!t.is_dirty());
+    REQUIRE(t.dirty_regions().empty());
+    REQUIRE(t.dirty_bounds() == (region{0, 0, 0, 0}));
+    REQUIRE(t.invariants());
+}
+
+TEST_CASE("tracked_rectangular at() marks cells", "[tracked]") {
+    TR t{10, 10};
+    t.at(2, 3) = 1;
+    t.at(3, 7) = 1;
+    t.at(7, 0) = 1;
+
+    REQUIRE(t.is_dirty());
+    REQUIRE(t.dirty_row_count() == 3);
+    REQUIRE(t.dirty_rows() == (std::vector<std::size_t>{2, 3, 7}));
+    REQUIRE(t.dirty_bounds() == (region{2, 0, 6, 8}));
+
+    auto regs = t.dirty_regions();
+    REQUIRE(regs.size() == 2);
+    REQUIRE(regs[0] == (region{2, 3, 2, 5}));
+    REQUIRE(regs[1] == (region{7, 0, 1, 1}));
+    REQUIRE(t.invariants());
+
+    REQUIRE_THROWS_AS(t.at(10, 0), std::out_of_range);
+    REQUIRE(t.invariants());
+}
+
+TEST_CASE("tracked_rectangular const access is clean", "[tracked]") {
+    TR t{3, 3, 2};
+    const TR& ct = t;
+
+    REQUIRE(ct.at(1, 1) == 2);
+    REQUIRE(ct[2][2] == 2);
+    REQUIRE(std::count(ct.begin(), ct.end(), 2) == 9);
+    REQUIRE(!t.is_dirty());
+}
+
+TEST_CASE("tracked_rectangular operator[] marks rows", "[tracked]") {
+    TR t{4, 6};
+    t[1][2] = 5;
+
+    REQUIRE(t.dirty_regions() == (std::vector<region>{region{1, 0, 1, 6}}));
+    REQUIRE(t.contents().at(1, 2) == 5);
+}
+
+TEST_CASE("tracked_rectangular iterators mark cells", "[tracked]") {
+    TR t{4, 4};
+    auto it = t.begin() + 5;  // (1, 1)
+    *it = 3;
+    it[4] = 3;                // (2, 1)
+    REQUIRE(t.end() - t.begin() == 16);
+
+    REQUIRE(t.dirty_regions() == (std::vector<region>{region{1, 1, 2, 1}}));
+
+    t.clear_dirty();
+    std::fill(t.begin() + 12, t.end(), 9);
+    REQUIRE(t.dirty_regions() == (std::vector<region>{region{3, 0, 1, 4}}));
+    REQUIRE(t.at(3, 3) == 9);
+}
+
+TEST_CASE("tracked_rectangular clear and fill", "[tracked]") {
+    TR t{5, 5};
+    t.at(4, 4) = 1;
+    t.clear_dirty();
+
+    REQUIRE(!t.is_dirty());
+    REQUIRE(!t.row_dirty(4));
+    REQUIRE(t.invariants());
+
+    t.fill(2);
+    REQUIRE(t.dirty_row_count() == 5);
+    REQUIRE(t.dirty_bounds() == (region{0, 0, 5, 5}));
+}
+
+TEST_CASE("tracked_rectangular dirty tiles", "[tracked]") {
+    TR t{10, 10};
+    t.at(0, 0) = 1;
+    t.at(1, 3) = 1;
+    t.at(9, 9) = 1;
+    t.mark_dirty(region{5, 3, 1, 2}); // columns 3,4 straddle two tiles
+
+    auto tiles = t.dirty_tiles(4, 4);
+    REQUIRE(tiles.size() == 4);
+    REQUIRE(tiles[0] == (region{0, 0, 4, 4}));
+    REQUIRE(tiles[1] == (region{4, 0, 4, 4}));
+    REQUIRE(tiles[2] == (region{4, 4, 4, 4}));
+    REQUIRE(tiles[3] == (region{8, 8, 2, 2})); // clipped at the edge
+
+    REQUIRE_THROWS_AS(t.dirty_tiles(0, 4), std::invalid_argument);
+    REQUIRE_THROWS_AS(t.dirty_tiles(4, 0), std::invalid_argument);
+}
+
+TEST_CASE("tracked_rectangular mark_dirty clips", "[tracked]") {
+    TR t{3, 3};
+    t.mark_dirty(region{2, 2, 10, 10});
+    REQUIRE(t.dirty_regions() == (std::vector<region>{region{2, 2, 1, 1}}));
+    t.mark_dirty(region{0, 5, 1, 1});
+    REQUIRE(t.dirty_row_count() == 1);
+}
+
+TEST_CASE("tracked_rectangular resize and move", "[tracked]") {
+    TR t{2, 2};
+    t.resize(3, 4, 1);
+    REQUIRE(t.dirty_bounds() == (region{0, 0, 3, 4}));
+    REQUIRE(t.invariants());
+
+    TR m{std::move(t)};
+    REQUIRE(t.size() == 0);
+    REQUIRE(t.invariants());
+    REQUIRE(m.invariants());
+    REQUIRE(m.dirty_row_count() == 3);
+
+    rectangular<int> r{2, 2, 7};
+    TR adopted{std::move(r)};
+    REQUIRE(!adopted.is_dirty());
+    REQUIRE(adopted.at(1, 1) == 7);
+}
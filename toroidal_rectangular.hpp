@@ -0,0 +1,141 @@
+#ifndef GNB_toroidal_rectangular
+#define GNB_toroidal_rectangular
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "rectangular.hpp"
+
+namespace gnb {
+
+/*
+ * toroidal_rectangular IS-A rectangular
+ * but at(y, x) takes signed indexes and wraps them round, for periodic boundaries
+ *
+ * toroidal_rectangular<int> g{64, 64};
+ * g.at(-1, 64);                      // same as g.at(63, 0)
+ * g.for_each_neighbourhood(1, [&](size_t y, size_t x, const toroidal_rectangular<int>::neighbourhood& n) {
+ *     out[y][x] = n(-1, 0) + n(1, 0) + n(0, -1) + n(0, 1);
+ * });
+ *
+ * Indexes already in range cost one compare.  Otherwise dimensions that are
+ * a power of two wrap with a mask, and others with %.  at() only throws
+ * std::out_of_range if the grid is empty.  operator[] is the raw
+ * rectangular one, and does not wrap.
+ *
+ * for_each_neighbourhood() visits every cell with a view of the cells within
+ * radius of it.  The rows of the view are wrapped once per row of the grid,
+ * and the columns are only wrapped for cells within radius of the left or
+ * right edge, so the interior of the grid is plain pointer arithmetic.
+ */
+template <typename T, class Allocator = std::allocator<T> >
+class toroidal_rectangular : public rectangular<T, Allocator> {
+        using Base = rectangular<T, Allocator>;
+    public:
+        using size_type = typename Base::size_type;
+        using difference_type = typename Base::difference_type;
+        using value_type = typename Base::value_type;
+        using reference = typename Base::reference;
+        using const_reference = typename Base::const_reference;
+        using const_pointer = typename Base::const_pointer;
+
+        /*
+         * The cells around one cell, n(dy, dx) for -radius <= dy, dx <= radius.
+         * Only valid during the call to the for_each_neighbourhood() callback.
+         */
+        class neighbourhood {
+                friend class toroidal_rectangular;
+            public:
+                const_reference operator()(difference_type dy, difference_type dx) const {
+                    const_pointer row = m_rows[dy + m_radius];
+                    if (!m_border) return row[m_x + dx];
+                    return row[wrap(m_x + dx, m_width)];
+                }
+                size_type radius() const { return static_cast<size_type>(m_radius); }
+            private:
+                neighbourhood(size_type radius, size_type width) :
+                    m_rows(2 * radius + 1), m_radius{static_cast<difference_type>(radius)},
+                    m_width{width}, m_x{0}, m_border{false} {}
+                std::vector<const_pointer> m_rows; // start of each wrapped row, top to bottom
+                difference_type m_radius;
+                size_type m_width;
+                difference_type m_x;
+                bool m_border;
+        };
+
+        // Inherit all the base class constructors
+        using Base::Base;
+
+        // Default dtor/copy/assign/move OK
+
+        // Wrapped, only throws std::out_of_range() if empty
+        reference at(difference_type y, difference_type x) {
+            check();
+            return (*this)[wrap(y, this->height())][wrap(x, this->width())];
+        }
+        const_reference at(difference_type y, difference_type x) const {
+            check();
+            return (*this)[wrap(y, this->height())][wrap(x, this->width())];
+        }
+
+        // Call fn(y, x, n) for every cell, where n is a neighbourhood of the given radius
+        template <typename Fn>
+        void for_each_neighbourhood(size_type radius, Fn fn) const {
+            if (this->empty()) return;
+            const size_type h = this->height(), w = this->width();
+            const difference_type r = static_cast<difference_type>(radius);
+            neighbourhood n{radius, w};
+            for (size_type y = 0; y < h; ++y) {
+                for (difference_type dy = -r; dy <= r; ++dy)
+                    n.m_rows[dy + r] = (*this)[wrap(static_cast<difference_type>(y) + dy, h)];
+                // Left border, interior, right border
+                const size_type left = std::min(radius, w), right = std::max(left, w - left);
+                n.m_border = true;
+                for (size_type x = 0; x < left; ++x) visit(n, fn, y, x);
+                n.m_border = false;
+                for (size_type x = left; x < right; ++x) visit(n, fn, y, x);
+                n.m_border = true;
+                for (size_type x = right; x < w; ++x) visit(n, fn, y, x);
+            }
+        }
+
+        // Wrap any index into [0, n), n must not be 0
+        static size_type wrap(difference_type i, size_type n) {
+            if (static_cast<size_type>(i) < n) return static_cast<size_type>(i);
+            // Two's complement, so this also works for negative i
+            if ((n & (n - 1)) == 0) return static_cast<size_type>(i) & (n - 1);
+            difference_type m = i % static_cast<difference_type>(n);
+            return static_cast<size_type>(m < 0 ? m + static_cast<difference_type>(n) : m);
+        }
+
+    private:
+        void check() const {
+            if (this->empty()) throw std::out_of_range("toroidal_rectangular empty");
+        }
+
+        template <typename Fn>
+        static void visit(neighbourhood& n, Fn& fn, size_type y, size_type x) {
+            n.m_x = static_cast<difference_type>(x);
+            fn(y, x, static_cast<const neighbourhood&>(n));
+        }
+};
+
+} // namespace gnb
+
+#endif // GNB_toroidal_rectangular
@@ -0,0 +1,298 @@
+#ifndef GNB_tracked_rectangular
+#define GNB_tracked_rectangular
+
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Please feel free to copy this file into your own project.
+ * This software comes with NO WARRANTY.
+ *
+ * For more information, please see the associated LICENSE file or refer to <https://unlicense.org>
+ *
+ * This version for C++11 and later.
+ *
+ * Bugs/Comments/Pull requests to https://github.com/gnbond/Rectangular
+ */
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "rectangular.hpp"
+#include "rectangular_region.hpp"
+
+namespace gnb {
+
+/*
+ * A rectangular that remembers which cells have been written since the dirty
+ * set was last cleared, so that downstream passes only need to reprocess what
+ * has changed.
+ *
+ * tracked_rectangular<int> t{100, 100};
+ * t.at(5, 7) = 1;
+ * for (auto& reg : t.dirty_regions()) reprocess(t, reg);
+ * t.clear_dirty();
+ *
+ * For each row the span of written columns is kept, so the dirty set can be
+ * read back as rows, bounding rectangles or tiles.  Writes through at(), the
+ * mutable iterators and fill() record exactly which cells they touched.
+ * operator[] hands out a raw row pointer, so marks the whole row.  Anything
+ * writing through a saved pointer or reference must call mark_dirty() itself.
+ *
+ * The cost of tracking is proportional to the number of dirty rows, not to the
+ * size of the grid.
+ */
+template <typename T, class Allocator = std::allocator<T> >
+class tracked_rectangular {
+        using Base = rectangular<T, Allocator>;
+    public:
+        using value_type = typename Base::value_type;
+        using reference = typename Base::reference;
+        using const_reference = typename Base::const_reference;
+        using pointer = typename Base::pointer;
+        using const_pointer = typename Base::const_pointer;
+        using size_type = typename Base::size_type;
+        using difference_type = typename Base::difference_type;
+        using const_iterator = typename Base::const_iterator;
+
+        /*
+         * Mutable iterator that marks each element it dereferences as dirty.
+         * Dereferencing without writing still counts as a write.
+         */
+        class iterator {
+                friend class tracked_rectangular;
+            public:
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = typename Base::value_type;
+                using difference_type = typename Base::difference_type;
+                using pointer = typename Base::pointer;
+                using reference = typename Base::reference;
+
+                iterator() : m_owner{nullptr}, m_pos{0} {}
+
+                reference operator*() const { return m_owner->mark_index(m_pos); }
+                pointer operator->() const { return &**this; }
+                reference operator[](difference_type n) const { return *(*this + n); }
+
+                iterator& operator++() { ++m_pos; return *this; }
+                iterator operator++(int) { iterator i{*this}; ++m_pos; return i; }
+                iterator& operator--() { --m_pos; return *this; }
+                iterator operator--(int) { iterator i{*this}; --m_pos; return i; }
+                iterator& operator+=(difference_type n) { m_pos += n; return *this; }
+                iterator& operator-=(difference_type n) { m_pos -= n; return *this; }
+                iterator operator+(difference_type n) const { return iterator{m_owner, m_pos + n}; }
+                iterator operator-(difference_type n) const { return iterator{m_owner, m_pos - n}; }
+                friend iterator operator+(difference_type n, const iterator& i) { return i + n; }
+                difference_type operator-(const iterator& i) const {
+                    return static_cast<difference_type>(m_pos) - static_cast<difference_type>(i.m_pos);
+                }
+
+                bool operator==(const iterator& i) const { return m_pos == i.m_pos; }
+                bool operator!=(const iterator& i) const { return m_pos != i.m_pos; }
+                bool operator<(const iterator& i) const { return m_pos < i.m_pos; }
+                bool operator>(const iterator& i) const { return m_pos > i.m_pos; }
+                bool operator<=(const iterator& i) const { return m_pos <= i.m_pos; }
+                bool operator>=(const iterator& i) const { return m_pos >= i.m_pos; }
+
+            private:
+                iterator(tracked_rectangular* owner, size_type pos) : m_owner{owner}, m_pos{pos} {}
+                tracked_rectangular* m_owner;
+                size_type m_pos;
+        };
+
+        tracked_rectangular() : m_data{}, m_lo{}, m_hi{}, m_rows{} {}
+        explicit tracked_rectangular(size_type height, size_type width, value_type value = value_type()) :
+            m_data{height, width, value}, m_lo{}, m_hi{}, m_rows{} { reset_tracking(); }
+        // Take over an existing rectangular, which starts off clean
+        explicit tracked_rectangular(Base&& r) : m_data{std::move(r)}, m_lo{}, m_hi{}, m_rows{} { reset_tracking(); }
+
+        // Default dtor/copy/assign OK, copies are dirty in the same places
+        ~tracked_rectangular() = default;
+        tracked_rectangular(const tracked_rectangular&) = default;
+        tracked_rectangular& operator=(const tracked_rectangular&) = default;
+
+        // Move ctor/assign need help to maintain invariants
+        tracked_rectangular(tracked_rectangular&& r) : m_data{}, m_lo{}, m_hi{}, m_rows{} { swap(r); }
+        tracked_rectangular& operator=(tracked_rectangular&& r) { swap(r); return *this; }
+
+        // Iterate over the data in row-major order
+        iterator begin() { return iterator{this, 0}; }
+        iterator end() { return iterator{this, size()}; }
+        const_iterator begin() const { return m_data.cbegin(); }
+        const_iterator end() const { return m_data.cend(); }
+        const_iterator cbegin() const { return m_data.cbegin(); }
+        const_iterator cend() const { return m_data.cend(); }
+
+        size_type size() const { return m_data.size(); }
+        bool empty() const { return m_data.empty(); }
+
+        size_type height() const { return m_data.height(); }
+        size_type width() const { return m_data.width(); }
+
+        // Bounds-checked, will throw std::out_of_range() if required
+        reference at(size_type y, size_type x) {
+            reference r = m_data.at(y, x);
+            mark(y, x, x + 1);
+            return r;
+        }
+        const_reference at(size_type y, size_type x) const { return m_data.at(y, x); }
+
+        // Raw pointers, fast but no bounds checking
+        // The mutable version marks the whole row y as dirty
+        pointer operator[](size_type y) {
+            mark(y, 0, width());
+            return m_data[y];
+        }
+        const_pointer operator[](size_type y) const { return m_data[y]; }
+
+        // Read-only view of the contents
+        const Base& contents() const { return m_data; }
+
+        void fill(const_reference value) {
+            m_data.fill(value);
+            mark_dirty(region{0, 0, height(), width()});
+        }
+
+        // Everything is dirty after a resize
+        void resize(size_type new_height, size_type new_width, value_type value = value_type()) {
+            m_data.resize(new_height, new_width, value);
+            reset_tracking();
+            mark_dirty(region{0, 0, height(), width()});
+        }
+
+        void swap(tracked_rectangular& r) {
+            m_data.swap(r.m_data);
+            std::swap(m_lo, r.m_lo);
+            std::swap(m_hi, r.m_hi);
+            std::swap(m_rows, r.m_rows);
+        }
+
+        // Record writes the tracker could not see, clipped to the grid
+        void mark_dirty(const region& reg) {
+            size_type y_end = std::min(height(), reg.y + reg.height);
+            size_type x_end = std::min(width(), reg.x + reg.width);
+            if (reg.x >= x_end) return;
+            for (size_type y = reg.y; y < y_end; ++y) mark(y, reg.x, x_end);
+        }
+
+        bool is_dirty() const { return !m_rows.empty(); }
+        bool row_dirty(size_type y) const { return m_lo[y] < m_hi[y]; }
+        // Number of dirty rows
+        size_type dirty_row_count() const { return m_rows.size(); }
+
+        // Dirty rows in ascending order
+        std::vector<size_type> dirty_rows() const {
+            std::vector<size_type> rows{m_rows};
+            std::sort(rows.begin(), rows.end());
+            return rows;
+        }
+
+        // Smallest rectangle holding every dirty cell, empty if clean
+        region dirty_bounds() const {
+            if (m_rows.empty()) return region{0, 0, 0, 0};
+            size_type y0 = m_rows[0], y1 = m_rows[0], x0 = m_lo[y0], x1 = m_hi[y0];
+            for (size_type y : m_rows) {
+                y0 = std::min(y0, y);
+                y1 = std::max(y1, y);
+                x0 = std::min(x0, m_lo[y]);
+                x1 = std::max(x1, m_hi[y]);
+            }
+            return region{y0, x0, y1 + 1 - y0, x1 - x0};
+        }
+
+        /*
+         * Runs of consecutive dirty rows, each with the bounding span of its
+         * dirty columns.  Every dirty cell is in exactly one region.
+         */
+        std::vector<region> dirty_regions() const {
+            std::vector<region> out;
+            for (size_type y : dirty_rows()) {
+                if (!out.empty() && out.back().y + out.back().height == y) {
+                    region& r = out.back();
+                    size_type x0 = std::min(r.x, m_lo[y]), x1 = std::max(r.x + r.width, m_hi[y]);
+                    r.x = x0;
+                    r.width = x1 - x0;
+                    ++r.height;
+                } else {
+                    out.push_back(region{y, m_lo[y], 1, m_hi[y] - m_lo[y]});
+                }
+            }
+            return out;
+        }
+
+        /*
+         * Dirty tiles of tile_height x tile_width, as regions clipped to the
+         * grid, in row-major tile order.  Zero tile sizes throw std::invalid_argument.
+         */
+        std::vector<region> dirty_tiles(size_type tile_height, size_type tile_width) const {
+            if (tile_height == 0 || tile_width == 0) throw std::invalid_argument("tracked_rectangular tile size");
+            size_type tiles_x = (width() + tile_width - 1) / tile_width;
+            std::vector<size_type> tiles;
+            for (size_type y : m_rows) {
+                size_type ty = y / tile_height;
+                for (size_type tx = m_lo[y] / tile_width; tx * tile_width < m_hi[y]; ++tx)
+                    tiles.push_back(ty * tiles_x + tx);
+            }
+            std::sort(tiles.begin(), tiles.end());
+            tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+            std::vector<region> out;
+            out.reserve(tiles.size());
+            for (size_type t : tiles) {
+                size_type y = t / tiles_x * tile_height, x = t % tiles_x * tile_width;
+                out.push_back(region{y, x, std::min(tile_height, height() - y), std::min(tile_width, width() - x)});
+            }
+            return out;
+        }
+
+        // Forget the dirty set, in time proportional to its size
+        void clear_dirty() {
+            for (size_type y : m_rows) {
+                m_lo[y] = width();
+                m_hi[y] = 0;
+            }
+            m_rows.clear();
+        }
+
+        // Check invariants, mainly for unit tests
+        bool invariants() const {
+            if (!m_data.invariants() || m_lo.size() != height() || m_hi.size() != height()) return false;
+            size_type dirty = 0;
+            for (size_type y = 0; y < height(); ++y)
+                if (row_dirty(y)) ++dirty;
+            return dirty == m_rows.size();
+        }
+
+    private:
+        // Row y is clean iff m_lo[y] >= m_hi[y]
+        void reset_tracking() {
+            m_lo.assign(height(), width());
+            m_hi.assign(height(), 0);
+            m_rows.clear();
+        }
+
+        void mark(size_type y, size_type x0, size_type x1) {
+            if (m_lo[y] >= m_hi[y]) {
+                if (x0 >= x1) return;
+                m_rows.push_back(y);
+            }
+            m_lo[y] = std::min(m_lo[y], x0);
+            m_hi[y] = std::max(m_hi[y], x1);
+        }
+
+        reference mark_index(size_type i) {
+            size_type y = i / width(), x = i % width();
+            mark(y, x, x + 1);
+            return m_data[y][x];
+        }
+
+        Base m_data;
+        std::vector<size_type> m_lo, m_hi; // dirty columns [lo, hi) of each row
+        std::vector<size_type> m_rows;     // the rows that are dirty, unordered
+};
+
+} // namespace gnb
+
+#endif // GNB_tracked_rectangular